@@ -0,0 +1,66 @@
+#include "cm4u_bench.h"
+#include "cm4u_bitband.h"
+
+/*
+ * Setting / clearing one shared bit that ISRs also touch.
+ *
+ *   bb.set_const      CM4U_BB_SET() on a static word (alias computed, then one STR)
+ *   bb.flag_set       cm4u_bb_flag_set() on a 64-flag array
+ *   bb.flag_clear     cm4u_bb_flag_clear()
+ *   bb.rmw_primask    word |= bit with PRIMASK held
+ *   bb.rmw_ldrex      word |= bit with an LDREX/STREX retry loop
+ */
+
+static volatile uint32_t shared_word;
+static uint32_t ev_words[CM4U_BB_FLAG_WORDS(64u)];
+static cm4u_bb_flags_t ev;
+static volatile uint32_t bench_bit = 17u;
+
+int main(void)
+{
+    cm4u_bench_init();
+    cm4u_bb_flags_init(&ev, ev_words, 64u);
+
+    CM4U_BENCH_RUN("bb.set_const", {
+        CM4U_BB_SET(&shared_word, 5u);
+    });
+
+    CM4U_BENCH_RUN("bb.flag_set", {
+        cm4u_bb_flag_set(&ev, bench_bit);
+    });
+
+    CM4U_BENCH_RUN("bb.flag_clear", {
+        cm4u_bb_flag_clear(&ev, bench_bit);
+    });
+
+    CM4U_BENCH_RUN("bb.rmw_primask", {
+        uint32_t pm = __get_PRIMASK();
+        __disable_irq();
+        shared_word |= 1u << bench_bit;
+        __set_PRIMASK(pm);
+    });
+
+    CM4U_BENCH_RUN("bb.rmw_ldrex", {
+        uint32_t v;
+        do {
+            v = __LDREXW(&shared_word);
+        } while (__STREXW(v | (1u << bench_bit), &shared_word) != 0u);
+    });
+
+    /* The alias mapping hits exactly the intended bits */
+    shared_word = 0u;
+    CM4U_BB_SET(&shared_word, 5u);
+    CM4U_BB_SET(&shared_word, 31u);
+    CM4U_BB_CLEAR(&shared_word, 5u);
+    cm4u_bb_flag_set(&ev, 40u);
+    cm4u_bb_flag_set(&ev, 63u);
+    bool ok = (shared_word == 0x80000000u) && (CM4U_BB_SRAM_READ(&shared_word, 31u) == 1u) &&
+              (ev_words[0] == 0u) && (ev_words[1] == ((1u << 8) | (1u << 31))) &&
+              cm4u_bb_flag_get(&ev, 40u) && !cm4u_bb_flag_get(&ev, 41u) &&
+              (cm4u_bb_flags_first(&ev) == 40u);
+#if !defined(CM4U_HOST)
+    ok = ok && (CM4U_BITBAND_SRAM(0x20000300u, 2u) == 0x22006008u) &&
+         (CM4U_BITBAND_PERIPH(0x40020014u, 5u) == 0x42400294u);
+#endif
+    return ok ? 0 : 1;
+}
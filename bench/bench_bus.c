@@ -0,0 +1,139 @@
+#include "cm4u_bench.h"
+#include "cm4u_bus.h"
+
+/*
+ * Static publish / subscribe vs. hand-written fan-out.
+ *
+ *   bus.publish_0          topic without subscribers (statistics only)
+ *   bus.publish_1_now      one immediate subscriber
+ *   bus.publish_4_now      four immediate subscribers
+ *   bus.direct_4           the same four handlers called by hand
+ *   bus.publish_deferred   publish to two PendSV subscribers (levels 1 and
+ *                          2), both delivered, back in Thread
+ *
+ * The run checks that level 1 is delivered before level 2 although it is
+ * listed second, and prints each topic's statistics on a "CM4U_BUS ..."
+ * line.
+ */
+
+static volatile uint32_t sink;
+static volatile uint32_t order[2];
+static volatile uint32_t order_n;
+
+static void on_add(void *ctx, uint32_t data)
+{
+    (void)ctx;
+    sink += data;
+}
+
+static void on_xor(void *ctx, uint32_t data)
+{
+    (void)ctx;
+    sink ^= data;
+}
+
+static void on_count(void *ctx, uint32_t data)
+{
+    (void)data;
+    (*(volatile uint32_t *)ctx)++;
+}
+
+static void on_level(void *ctx, uint32_t data)
+{
+    (void)data;
+    if (order_n < 2u) {
+        order[order_n] = (uint32_t)(uintptr_t)ctx;
+    }
+    order_n++;
+}
+
+__attribute__((noinline)) static void direct_add(uint32_t d) { sink += d; }
+__attribute__((noinline)) static void direct_xor(uint32_t d) { sink ^= d; }
+__attribute__((noinline)) static void direct_sub(uint32_t d) { sink -= d; }
+__attribute__((noinline)) static void direct_or(uint32_t d)  { sink |= d; }
+
+static volatile uint32_t count_a, count_b;
+
+CM4U_TOPIC_DEFINE(t_idle);
+CM4U_TOPIC_DEFINE(t_one);
+CM4U_TOPIC_DEFINE(t_deferred);
+CM4U_TOPIC_DECLARE(t_four);
+
+CM4U_SUBSCRIBE(t_one, on_add, 0, CM4U_BUS_NOW);
+CM4U_SUBSCRIBE(t_deferred, on_level, (void *)2u, 2u);
+CM4U_SUBSCRIBE(t_deferred, on_count, (void *)&count_b, 1u);
+
+static void on_level1(void *ctx, uint32_t data) { on_level(ctx, data); }
+CM4U_SUBSCRIBE(t_deferred, on_level1, (void *)1u, 1u);
+
+/* Table form: no linker sections */
+static const cm4u_sub_t four_subs[] = {
+    { &t_four, on_add, 0, CM4U_BUS_NOW },
+    { &t_four, on_xor, 0, CM4U_BUS_NOW },
+    { &t_four, on_count, (void *)&count_a, CM4U_BUS_NOW },
+    { &t_four, on_add, 0, CM4U_BUS_NOW },
+};
+CM4U_TOPIC_DEFINE_TABLE(t_four, four_subs);
+
+CM4U_BUS_HANDLER(PendSV_Handler)
+
+static void print_topic(const char *name, const cm4u_topic_t *t)
+{
+    printf("CM4U_BUS topic=%s subscribers=%lu published=%lu dropped=%lu min_interval=%lu "
+           "max_publish=%lu latency_avg=%lu latency_max=%lu rate_hz=%lu\n",
+           name, (unsigned long)cm4u_topic_subscribers(t), (unsigned long)t->published,
+           (unsigned long)t->dropped, (unsigned long)t->min_interval,
+           (unsigned long)t->max_publish, (unsigned long)cm4u_topic_latency_avg(t),
+           (unsigned long)t->latency_max,
+           (unsigned long)cm4u_topic_rate_hz(t, CM4U_CFG_CORE_CLOCK_HZ));
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(PendSV_IRQn, PendSV_Handler);
+#endif
+    NVIC_SetPriority(PendSV_IRQn, 15u);
+    (void)cm4u_dwt_init();
+
+    CM4U_BENCH_RUN("bus.publish_0", {
+        cm4u_bus_publish(&t_idle, 1u);
+    });
+    CM4U_BENCH_RUN("bus.publish_1_now", {
+        cm4u_bus_publish(&t_one, 1u);
+    });
+    CM4U_BENCH_RUN("bus.publish_4_now", {
+        cm4u_bus_publish(&t_four, 3u);
+    });
+    CM4U_BENCH_RUN("bus.direct_4", {
+        direct_add(3u);
+        direct_xor(3u);
+        direct_sub(3u);
+        direct_or(3u);
+    });
+
+    /* Level 1 first, although the level-2 subscriber is listed first */
+    cm4u_bus_publish(&t_deferred, 0u);
+    __DSB();
+    __ISB();
+    bool ok = (order_n == 2u) && (order[0] == 1u) && (order[1] == 2u) && (count_b == 1u);
+
+    CM4U_BENCH_RUN("bus.publish_deferred", {
+        cm4u_bus_publish(&t_deferred, 0u);
+        __DSB();
+        __ISB();
+    });
+
+    print_topic("t_one", &t_one);
+    print_topic("t_four", &t_four);
+    print_topic("t_deferred", &t_deferred);
+
+    ok = ok && (cm4u_topic_subscribers(&t_idle) == 0u) && (cm4u_topic_subscribers(&t_one) == 1u) &&
+         (cm4u_topic_subscribers(&t_four) == 4u) && (cm4u_topic_subscribers(&t_deferred) == 3u) &&
+         (count_a == CM4U_BENCH_ITERS) && (count_b == CM4U_BENCH_ITERS + 1u) &&
+         (order_n == 2u * (CM4U_BENCH_ITERS + 1u)) &&
+         (t_deferred.delivered == 3u * (CM4U_BENCH_ITERS + 1u)) && (t_deferred.dropped == 0u) &&
+         (t_one.published == CM4U_BENCH_ITERS);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "cm4u_bench.h"
+
+/*
+ * Core primitives: critical sections, mask registers, clock math, PendSV.
+ */
+
+static volatile uint32_t bench_sink;
+static volatile uint32_t bench_pendsv_count;
+
+void PendSV_Handler(void)
+{
+    bench_pendsv_count++;
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(PendSV_IRQn, PendSV_Handler);
+#endif
+
+    CM4U_BENCH_RUN("core.critical_pair", {
+        uint32_t pm = cm4u_critical_enter();
+        cm4u_critical_exit(pm);
+    });
+
+    CM4U_BENCH_RUN("core.basepri_pair", {
+        uint32_t bp = cm4u_get_basepri();
+        cm4u_set_basepri(0x40u);
+        cm4u_set_basepri(bp);
+    });
+
+    CM4U_BENCH_RUN("core.in_handler_mode", {
+        bench_sink = (uint32_t)cm4u_in_handler_mode();
+    });
+
+    volatile uint32_t us = 10u, hz = 168000000u;
+    CM4U_BENCH_RUN("core.us_to_cycles_runtime", {
+        bench_sink = cm4u_us_to_cycles(us, hz);
+    });
+
+#if (CM4U_CFG_CORE_CLOCK_HZ != 0)
+    CM4U_BENCH_RUN("core.us_to_cycles_fixed", {
+        bench_sink = cm4u_us_to_cycles_fixed(us);
+    });
+
+    CM4U_BENCH_RUN("core.delay_us_const_1", {
+        CM4U_DELAY_US(1);
+    });
+#endif
+
+    CM4U_BENCH_RUN("core.pendsv_roundtrip", {
+        cm4u_trigger_pendsv();
+    });
+
+    CM4U_BENCH_RUN("core.delay_cycles_100", {
+        cm4u_delay_cycles(100u);
+    });
+
+    return (bench_pendsv_count == CM4U_BENCH_ITERS) ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+#include "cm4u_bench.h"
+#include "cm4u.hpp"
+
+/*
+ * C++ wrapper layer vs. the C API it forwards to.
+ *
+ * Each zo_c_* / zo_cpp_* pair does the same work; the pairs are timed here
+ * and their code sizes compared by the zero_overhead_report target.
+ */
+
+using namespace cm4u::literals;
+using SysClock = cm4u::Clock<168000000u>;
+
+static volatile uint32_t bench_shared;
+
+extern "C" {
+
+__attribute__((noinline)) void zo_c_critical(void)
+{
+    uint32_t pm = cm4u_critical_enter();
+    bench_shared = bench_shared + 1u;
+    cm4u_critical_exit(pm);
+}
+
+__attribute__((noinline)) void zo_cpp_critical(void)
+{
+    cm4u::CriticalSection cs;
+    bench_shared = bench_shared + 1u;
+}
+
+__attribute__((noinline)) void zo_c_basepri(void)
+{
+    uint32_t bp = cm4u_get_basepri();
+    cm4u_raise_basepri(0x40u);
+    bench_shared = bench_shared + 1u;
+    cm4u_set_basepri(bp);
+}
+
+__attribute__((noinline)) void zo_cpp_basepri(void)
+{
+    cm4u::BasepriGuard guard(0x40u);
+    bench_shared = bench_shared + 1u;
+}
+
+__attribute__((noinline)) uint32_t zo_c_profile(void)
+{
+    uint32_t start = cm4u_profile_cycles_start();
+    bench_shared = bench_shared + 1u;
+    return cm4u_profile_cycles_end(start);
+}
+
+__attribute__((noinline)) uint32_t zo_cpp_profile(void)
+{
+    cm4u::Cycles spent(0u);
+    {
+        cm4u::ScopedProfile p(spent);
+        bench_shared = bench_shared + 1u;
+    }
+    return spent.count();
+}
+
+__attribute__((noinline)) void zo_c_delay(void)
+{
+    cm4u_delay_us(2u, 168000000u);
+}
+
+__attribute__((noinline)) void zo_cpp_delay(void)
+{
+    SysClock::delay(2_us);
+}
+
+} /* extern "C" */
+
+static_assert(SysClock::to_cycles(10_us) == 1680_cyc, "constexpr clock math");
+static_assert(SysClock::to_cycles(1_ms) == 168000_cyc, "constexpr clock math");
+
+int main(void)
+{
+    cm4u_bench_init();
+
+    CM4U_BENCH_RUN("cpp.c_critical", zo_c_critical());
+    CM4U_BENCH_RUN("cpp.cpp_critical", zo_cpp_critical());
+    CM4U_BENCH_RUN("cpp.c_basepri", zo_c_basepri());
+    CM4U_BENCH_RUN("cpp.cpp_basepri", zo_cpp_basepri());
+    CM4U_BENCH_RUN("cpp.c_profile", (void)zo_c_profile());
+    CM4U_BENCH_RUN("cpp.cpp_profile", (void)zo_cpp_profile());
+    CM4U_BENCH_RUN("cpp.c_delay_2us", zo_c_delay());
+    CM4U_BENCH_RUN("cpp.cpp_delay_2us", zo_cpp_delay());
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "cm4u_bench.h"
+#include "cm4u_fiber.h"
+
+/*
+ * Cooperative fiber switch vs. a PendSV context switch.
+ *
+ *   fiber.resume_yield    cm4u_fiber_resume() into a fiber that yields
+ *                         straight back: two switches
+ *   fiber.switch          one switch (resume_yield / 2)
+ *   fiber.pendsv_switch   what an RTOS does per switch: pend PendSV, stack
+ *                         the exception frame, save R4-R11 (and S16-S31 if
+ *                         the thread used the FPU) to the PSP stack, swap
+ *                         PSP, restore, return
+ *
+ * The fiber's stack high water mark goes to a "CM4U_FIBER ..." line.
+ *
+ * On target the run fails if a switch takes 30 cycles or more (plus the
+ * S16-S31 transfer with CM4U_CFG_FIBER_FPU). The host cannot measure
+ * either switch: it charges CM4U_FIBER_SWITCH_CYCLES per fiber switch and
+ * only exception entry / exit for PendSV. Those metrics get a "_modelled"
+ * suffix there, so the host baseline does not pass them off as
+ * measurements.
+ */
+
+#define BENCH_STACK_WORDS  1024u
+#define SWITCH_LIMIT       (30u + ((CM4U_CFG_FIBER_FPU != 0) ? 34u : 0u))
+
+#if defined(CM4U_HOST)
+#define FIBER_METRIC(name)  "fiber." name "_modelled"
+#else
+#define FIBER_METRIC(name)  "fiber." name
+#endif
+
+static uint32_t ping_stack[BENCH_STACK_WORDS];
+static cm4u_fiber_t ping;
+static volatile uint32_t ping_count;
+
+static uint32_t once_stack[BENCH_STACK_WORDS];
+static cm4u_fiber_t once;
+static volatile uint32_t once_steps;
+
+static void ping_main(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        ping_count++;
+        cm4u_fiber_yield();
+    }
+}
+
+/* Blocking-style code: three waits, then the fiber returns */
+static void once_main(void *arg)
+{
+    volatile uint32_t *ticks = (volatile uint32_t *)arg;
+    for (uint32_t step = 1u; step <= 3u; step++) {
+        CM4U_FIBER_WAIT(*ticks >= step);
+        once_steps = step;
+    }
+}
+
+#if defined(CM4U_HOST)
+static void PendSV_Handler(void)
+{
+    /* The host model charges entry / exit; the register swap is not modelled */
+}
+#else
+static uint32_t pendsv_stack[64];
+__attribute__((used)) static uint32_t *volatile pendsv_sp;
+
+/* A minimal RTOS switch (saves and restores the same thread) */
+__attribute__((naked)) void PendSV_Handler(void)
+{
+    __asm volatile(
+        "mrs     r0, psp            \n"
+#if (CM4U_CFG_FIBER_FPU != 0)
+        "tst     lr, #0x10          \n"
+        "it      eq                 \n"
+        "vstmdbeq r0!, {s16-s31}    \n"
+#endif
+        "stmdb   r0!, {r4-r11, lr}  \n"
+        "ldr     r1, =pendsv_sp     \n"
+        "str     r0, [r1]           \n"
+        "ldr     r0, [r1]           \n"
+        "ldmia   r0!, {r4-r11, lr}  \n"
+#if (CM4U_CFG_FIBER_FPU != 0)
+        "tst     lr, #0x10          \n"
+        "it      eq                 \n"
+        "vldmiaeq r0!, {s16-s31}    \n"
+#endif
+        "msr     psp, r0            \n"
+        "bx      lr                 \n");
+}
+#endif
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(PendSV_IRQn, PendSV_Handler);
+#else
+    __set_PSP((uint32_t)(uintptr_t)&pendsv_stack[64]);
+#endif
+    NVIC_SetPriority(PendSV_IRQn, 15u);
+
+    cm4u_fiber_init(&ping, ping_stack, sizeof(ping_stack), ping_main, 0);
+    CM4U_BENCH_RUN(FIBER_METRIC("resume_yield"), {
+        cm4u_fiber_resume(&ping);
+    });
+    uint32_t rt = *cm4u_bench_last();
+    cm4u_bench_report_value(FIBER_METRIC("switch"), rt / 2u, rt / 2u, CM4U_BENCH_ITERS);
+
+    CM4U_BENCH_RUN(FIBER_METRIC("pendsv_switch"), {
+        cm4u_trigger_pendsv();
+    });
+
+    volatile uint32_t ticks = 0u;
+    cm4u_fiber_init(&once, once_stack, sizeof(once_stack), once_main, (void *)&ticks);
+    uint32_t resumes = 0u;
+    while (!cm4u_fiber_done(&once)) {
+        cm4u_fiber_resume(&once);
+        ticks++;
+        resumes++;
+    }
+
+    printf("CM4U_FIBER stack_bytes=%lu ping_used=%lu frame_words=%lu\n",
+           (unsigned long)sizeof(ping_stack), (unsigned long)cm4u_fiber_stack_used(&ping),
+           (unsigned long)CM4U_FIBER_FRAME_WORDS);
+
+    bool ok = (ping_count == CM4U_BENCH_ITERS) && (once_steps == 3u) && (resumes == 4u) &&
+              (cm4u_fiber_current == 0) && (cm4u_fiber_stack_used(&once) > 0u);
+#if !defined(CM4U_HOST)
+    ok = ok && ((rt / 2u) < SWITCH_LIMIT);
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include "cm4u_bench.h"
+#include "cm4u_idle.h"
+
+/*
+ * cm4u_idle_enter() on the host model: mode choice, accounting, the
+ * masked-window race and SCR hygiene.
+ *
+ *   idle.enter_none   deadline too close: decide and return
+ *   idle.enter_wfe    WFE with the wake-up IRQ already pending, through
+ *                     the handler
+ *
+ * cm4u_host_state.wfi_hook stands in for the sleep: it moves the clock to
+ * the deadline (plus `oversleep`), then pends the wake-up IRQ. A WFE that
+ * reaches the hook while that IRQ is already pending would sleep for good
+ * on silicon (its SEVONPEND event is gone), so the hook counts it as a
+ * lost wake-up instead. An NMI pends the IRQ between the masking and the
+ * WFE, which is the window the manager has to cover.
+ *
+ * Host only: the checks need the hook, and the numbers are step counts.
+ */
+
+#define WAKE_IRQ     ((IRQn_Type)9)
+#define MARGIN       20u
+#define SCR_CALLER   0u
+
+static const uint32_t latency[CM4U_SLEEP_NUM_MODES] = { 0u, 10u, 100u, 2000u };
+
+static cm4u_idle_t idle;
+
+static volatile uint32_t sleep_until;   /* absolute CYCCNT the hook wakes at */
+static volatile uint32_t oversleep;
+static volatile uint32_t hook_calls;
+static volatile uint32_t hook_slept;
+static volatile uint32_t hook_scr;
+static volatile uint32_t lost_wakeups;
+static volatile uint32_t wakes;
+static volatile uint32_t nmi_masked;
+static volatile uint32_t deep_enters;
+static volatile uint32_t deep_exits;
+static uint32_t wfe_seen;
+
+static void wake_handler(void)
+{
+    wakes++;
+}
+
+static void nmi_handler(void)
+{
+    nmi_masked = __get_PRIMASK();
+    NVIC_SetPendingIRQ(WAKE_IRQ);
+}
+
+static void sleep_hook(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    bool wfe = (h->wfe_count != wfe_seen);
+    wfe_seen = h->wfe_count;
+
+    hook_calls++;
+    hook_scr = SCB->SCR;
+    if (NVIC_GetPendingIRQ(WAKE_IRQ) != 0u) {
+        if (wfe) {
+            lost_wakeups++;  /* no event left to end this WFE */
+        }
+        return;
+    }
+
+    int32_t left = (int32_t)(sleep_until - cm4u_dwt_get_cycles());
+    uint32_t n = ((left > 0) ? (uint32_t)left : 0u) + oversleep;
+    cm4u_host_advance_cycles(n);
+    hook_slept = n;
+    NVIC_SetPendingIRQ(WAKE_IRQ);
+}
+
+static void deep_enter(void *ctx) { (void)ctx; deep_enters++; }
+static void deep_exit(void *ctx)  { (void)ctx; deep_exits++; }
+static uint32_t deep_elapsed(void *ctx) { (void)ctx; return hook_slept; }
+
+/* One idle call `budget` cycles ahead of now; false if SCR was not restored */
+static bool idle_for(uint32_t budget, cm4u_sleep_mode_t expect)
+{
+    SCB->SCR = SCR_CALLER;
+    hook_slept = 0u;
+    sleep_until = cm4u_dwt_get_cycles() + budget;
+    cm4u_sleep_mode_t mode = cm4u_idle_enter(&idle, sleep_until);
+    return (mode == expect) && (SCB->SCR == SCR_CALLER) && (__get_PRIMASK() == 0u);
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+    cm4u_host_set_handler(WAKE_IRQ, wake_handler);
+    cm4u_host_set_handler(NonMaskableInt_IRQn, nmi_handler);
+    cm4u_host()->wfi_hook = sleep_hook;
+    wfe_seen = cm4u_host()->wfe_count;
+    NVIC_SetPriority(WAKE_IRQ, 1u);
+    NVIC_EnableIRQ(WAKE_IRQ);
+
+    cm4u_idle_init(&idle, latency, MARGIN);
+    idle.deep_enter   = deep_enter;
+    idle.deep_exit    = deep_exit;
+    idle.deep_elapsed = deep_elapsed;
+
+    /* Deepest mode whose latency + margin fits, generous slack for the decision */
+    bool ok = idle_for(10u, CM4U_SLEEP_NONE) &&
+              idle_for(80u, CM4U_SLEEP_WFE) &&
+              idle_for(500u, CM4U_SLEEP_WFI) &&
+              idle_for(5000u, CM4U_SLEEP_DEEP);
+    uint32_t deep_scr = hook_scr;
+    idle.deepest = CM4U_SLEEP_WFI;
+    ok = ok && idle_for(5000u, CM4U_SLEEP_WFI);
+    idle.deepest = CM4U_SLEEP_DEEP;
+
+    ok = ok && (deep_scr & SCB_SCR_SLEEPDEEP_Msk) != 0u &&
+         (hook_scr & SCB_SCR_SLEEPDEEP_Msk) == 0u &&
+         (deep_enters == 1u) && (deep_exits == 1u) &&
+         (wakes == 4u) && (hook_calls == 4u) && (lost_wakeups == 0u);
+    for (uint32_t m = 0u; m < (uint32_t)CM4U_SLEEP_NUM_MODES; m++) {
+        ok = ok && (idle.entries[m] == ((m == (uint32_t)CM4U_SLEEP_WFI) ? 2u : 1u));
+    }
+    /* Residency is the hook's sleep plus a few steps (DEEP: deep_elapsed exactly) */
+    ok = ok && (idle.residency_cycles[CM4U_SLEEP_NONE] == 0u) &&
+         (idle.residency_cycles[CM4U_SLEEP_WFE] >= 60u) &&
+         (idle.residency_cycles[CM4U_SLEEP_WFI] >= 5400u) &&
+         (idle.residency_cycles[CM4U_SLEEP_WFI] < 5500u) &&
+         (idle.residency_cycles[CM4U_SLEEP_DEEP] > 4900u) &&
+         (idle.residency_cycles[CM4U_SLEEP_DEEP] <= 5000u) &&
+         (idle.missed_wakeups == 0u);
+
+    /* Woken late by more than the margin: one missed wake-up */
+    oversleep = MARGIN + 50u;
+    ok = ok && idle_for(500u, CM4U_SLEEP_WFI) &&
+         (idle.missed_wakeups == 1u) && (idle.worst_lateness >= MARGIN + 50u);
+    oversleep = 0u;
+
+    /* WFE sleeps with SEVONPEND set, and a stale event does not end it early */
+    __SEV();
+    uint32_t calls = hook_calls;
+    ok = ok && idle_for(80u, CM4U_SLEEP_WFE) && (hook_calls == calls + 1u) &&
+         (hook_scr & SCB_SCR_SEVONPEND_Msk) != 0u;
+
+    /* IRQ pended after the masking, before WFE: no sleep, handler runs before return */
+    uint32_t woken = wakes;
+    calls = hook_calls;
+    SCB->ICSR = SCB_ICSR_NMIPENDSET_Msk;  /* taken at the first barrier inside */
+    ok = ok && idle_for(80u, CM4U_SLEEP_WFE) && (nmi_masked == 1u) &&
+         (wakes == woken + 1u) && (hook_calls == calls) && (lost_wakeups == 0u);
+
+    /* A caller that already set SEVONPEND keeps it */
+    SCB->SCR = SCB_SCR_SEVONPEND_Msk;
+    sleep_until = cm4u_dwt_get_cycles() + 80u;
+    ok = ok && (cm4u_idle_enter(&idle, sleep_until) == CM4U_SLEEP_WFE) &&
+         (SCB->SCR == SCB_SCR_SEVONPEND_Msk);
+    SCB->SCR = SCR_CALLER;
+
+    CM4U_BENCH_RUN("idle.enter_none", {
+        (void)cm4u_idle_enter(&idle, cm4u_dwt_get_cycles());
+    });
+
+    CM4U_BENCH_RUN("idle.enter_wfe", {
+        __disable_irq();
+        NVIC_SetPendingIRQ(WAKE_IRQ);
+        (void)cm4u_idle_enter(&idle, cm4u_dwt_get_cycles() + 80u);
+        __enable_irq();
+    });
+
+    ok = ok && (lost_wakeups == 0u);
+    printf("CM4U_IDLE entries=%lu/%lu/%lu/%lu missed=%lu worst_late=%lu lost=%lu\n",
+           (unsigned long)idle.entries[0], (unsigned long)idle.entries[1],
+           (unsigned long)idle.entries[2], (unsigned long)idle.entries[3],
+           (unsigned long)idle.missed_wakeups, (unsigned long)idle.worst_lateness,
+           (unsigned long)lost_wakeups);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+#include "cm4u_bench.h"
+#include "cm4u_kernel.h"
+
+/*
+ * NVIC-scheduled run-to-completion tasks (IRQ43..45).
+ *
+ *   kernel.post            cm4u_task_post() to a task that cannot run yet
+ *   kernel.activate        post from Thread -> first line of the task
+ *   kernel.roundtrip       post, run one empty event, back in Thread
+ *   kernel.preempt         low task posts to high task: switch in and back
+ *   kernel.res_lock        cm4u_res_lock() + cm4u_res_unlock()
+ *   kernel.rtos_switch     reference: one PendSV context switch of a
+ *                          conventional stackful RTOS with the same 3 tasks
+ *                          (R4-R11 / S16-S31 to the task's PSP stack, TCB
+ *                          pick, restore), round robin main -> 1 -> 2 -> main;
+ *                          includes the two tasks' yield loops
+ *
+ * Both sides go to one "CM4U_KERNEL ..." line. For the kernel: the
+ * activation latency, the task control blocks, and the MSP used by the
+ * deepest preemption chain, which is its whole stack cost. For the
+ * reference: the switch, its TCBs, the private stacks it needs (one per
+ * task, each holding the task's own calls plus a saved context), and on
+ * target their painted high water mark.
+ *
+ * The host cannot switch stacks from a handler: there the reference PendSV
+ * only picks the next TCB, so its switch is reported as
+ * kernel.rtos_switch_modelled (exception entry / exit only).
+ */
+
+#define EV_PING    1u
+#define EV_CHAIN   2u
+
+#define RTOS_TASKS        3u
+#define RTOS_STACK_WORDS  64u
+#define RTOS_PAINT        0xA5A5A5A5u
+
+#if defined(CM4U_HOST)
+#define RTOS_METRIC  "kernel.rtos_switch_modelled"
+#else
+#define RTOS_METRIC  "kernel.rtos_switch"
+#endif
+
+static cm4u_task_t hi, mid, lo;
+static cm4u_res_t bus;
+static volatile uint32_t t_entry;
+static volatile uint32_t handled;
+static volatile uint32_t msp_thread, msp_deepest;
+
+/* Reference RTOS: a typical minimal TCB, saved SP first (PendSV uses it) */
+typedef struct {
+    uint32_t *sp;
+    uint32_t *stack;
+    uint32_t  stack_words;
+    uint32_t  priority;
+    uint32_t  state;
+    uint32_t  delay;
+    void     *next;
+    void     *event;
+} rtos_tcb_t;
+
+__attribute__((used)) static rtos_tcb_t rtos_tcb[RTOS_TASKS];
+__attribute__((used)) static volatile uint32_t rtos_cur;
+static uint32_t rtos_stack[RTOS_TASKS - 1u][RTOS_STACK_WORDS] __attribute__((aligned(8)));
+static volatile uint32_t rtos_runs;
+
+CM4U_TASK_HANDLER(IRQ43_Handler, hi)
+CM4U_TASK_HANDLER(IRQ44_Handler, mid)
+CM4U_TASK_HANDLER(IRQ45_Handler, lo)
+
+static void hi_event(void *ctx, uint32_t ev)
+{
+    (void)ctx;
+    (void)ev;
+    t_entry = cm4u_bench_now();
+    uint32_t msp = cm4u_get_msp();
+    if ((msp_thread - msp) > msp_deepest) {
+        msp_deepest = msp_thread - msp;
+    }
+    handled++;
+}
+
+static void mid_event(void *ctx, uint32_t ev)
+{
+    (void)ctx;
+    handled++;
+    if (ev == EV_CHAIN) {
+        uint32_t key = cm4u_res_lock(&bus);
+        handled++;
+        cm4u_res_unlock(key);
+        (void)cm4u_task_post(&hi, EV_PING);  /* preempts at once */
+    }
+}
+
+static void lo_event(void *ctx, uint32_t ev)
+{
+    (void)ctx;
+    handled++;
+    if (ev == EV_CHAIN) {
+        (void)cm4u_task_post(&mid, EV_CHAIN);
+    }
+}
+
+#if defined(CM4U_HOST)
+static void PendSV_Handler(void)
+{
+    /* The host model charges entry / exit; the register swap is not modelled */
+    rtos_cur = (rtos_cur + 1u) % RTOS_TASKS;
+    if (rtos_cur != 0u) {
+        rtos_runs++;
+    }
+}
+#else
+/* Tasks 1 and 2 yield straight back; main (task 0) stays on MSP */
+static void rtos_task(void)
+{
+    for (;;) {
+        rtos_runs++;
+        cm4u_trigger_pendsv();
+    }
+}
+
+__attribute__((naked)) void PendSV_Handler(void)
+{
+    __asm volatile(
+        "tst     lr, #4             \n"
+        "bne     1f                 \n"
+#if defined(__ARM_FP)
+        "tst     lr, #0x10          \n"
+        "it      eq                 \n"
+        "vpusheq {s16-s31}          \n"
+#endif
+        "push    {r4-r11, lr}       \n"  /* main: context stays on MSP */
+        "mov     r0, sp             \n"
+        "b       2f                 \n"
+        "1:                         \n"
+        "mrs     r0, psp            \n"
+#if defined(__ARM_FP)
+        "tst     lr, #0x10          \n"
+        "it      eq                 \n"
+        "vstmdbeq r0!, {s16-s31}    \n"
+#endif
+        "stmdb   r0!, {r4-r11, lr}  \n"
+        "2:                         \n"
+        "ldr     r1, =rtos_cur      \n"
+        "ldr     r2, [r1]           \n"
+        "ldr     r3, =rtos_tcb      \n"
+        "add     r12, r3, r2, lsl #5\n"
+        "str     r0, [r12]          \n"  /* tcb[cur].sp */
+        "adds    r2, r2, #1         \n"
+        "cmp     r2, #3             \n"
+        "it      eq                 \n"
+        "moveq   r2, #0             \n"
+        "str     r2, [r1]           \n"
+        "add     r12, r3, r2, lsl #5\n"
+        "ldr     r0, [r12]          \n"
+        "cbnz    r2, 3f             \n"
+        "mov     sp, r0             \n"
+        "pop     {r4-r11, lr}       \n"
+#if defined(__ARM_FP)
+        "tst     lr, #0x10          \n"
+        "it      eq                 \n"
+        "vpopeq  {s16-s31}          \n"
+#endif
+        "bx      lr                 \n"
+        "3:                         \n"
+        "ldmia   r0!, {r4-r11, lr}  \n"
+#if defined(__ARM_FP)
+        "tst     lr, #0x10          \n"
+        "it      eq                 \n"
+        "vldmiaeq r0!, {s16-s31}    \n"
+#endif
+        "msr     psp, r0            \n"
+        "bx      lr                 \n");
+}
+#endif
+
+/* Painted private stacks; tasks 1 and 2 start from a fake exception return */
+static void rtos_init(void)
+{
+#if !defined(CM4U_HOST)
+    _Static_assert(sizeof(rtos_tcb_t) == 32u, "PendSV indexes rtos_tcb[] by << 5");
+#endif
+    for (uint32_t t = 1u; t < RTOS_TASKS; t++) {
+        uint32_t *stack = rtos_stack[t - 1u];
+        for (uint32_t i = 0u; i < RTOS_STACK_WORDS; i++) {
+            stack[i] = RTOS_PAINT;
+        }
+        uint32_t *sp = &stack[RTOS_STACK_WORDS - 17u];
+#if !defined(CM4U_HOST)
+        sp[8]  = 0xFFFFFFFDu;                           /* EXC_RETURN: Thread, PSP, no FP frame */
+        sp[15] = (uint32_t)(uintptr_t)rtos_task & ~1u;  /* PC */
+        sp[16] = 0x01000000u;                           /* xPSR: Thumb */
+#endif
+        rtos_tcb[t].sp          = sp;
+        rtos_tcb[t].stack       = stack;
+        rtos_tcb[t].stack_words = RTOS_STACK_WORDS;
+        rtos_tcb[t].priority    = 1u;
+    }
+    rtos_cur = 0u;
+}
+
+#if !defined(CM4U_HOST)
+/* Bytes of the reference stacks ever written (paint high water mark) */
+static uint32_t rtos_stack_used(void)
+{
+    uint32_t used = 0u;
+    for (uint32_t t = 0u; t < RTOS_TASKS - 1u; t++) {
+        uint32_t i = 0u;
+        while ((i < RTOS_STACK_WORDS) && (rtos_stack[t][i] == RTOS_PAINT)) {
+            i++;
+        }
+        used += (RTOS_STACK_WORDS - i) * 4u;
+    }
+    return used;
+}
+#endif
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler((IRQn_Type)43, IRQ43_Handler);
+    cm4u_host_set_handler((IRQn_Type)44, IRQ44_Handler);
+    cm4u_host_set_handler((IRQn_Type)45, IRQ45_Handler);
+    cm4u_host_set_handler(PendSV_IRQn, PendSV_Handler);
+#endif
+    NVIC_SetPriority(PendSV_IRQn, 15u);
+    cm4u_task_init(&hi, (IRQn_Type)43, 2u, hi_event, 0);
+    cm4u_task_init(&mid, (IRQn_Type)44, 4u, mid_event, 0);
+    cm4u_task_init(&lo, (IRQn_Type)45, 6u, lo_event, 0);
+    cm4u_res_init(&bus);
+    cm4u_res_use(&bus, &hi);
+    cm4u_res_use(&bus, &mid);
+    msp_thread = cm4u_get_msp();
+
+    /* lo is masked by BASEPRI at its own priority: queue only */
+    uint32_t key = cm4u_get_basepri();
+    cm4u_set_basepri(CM4U_KERNEL_BASEPRI(lo.priority));
+    CM4U_BENCH_RUN("kernel.post", {
+        (void)cm4u_task_post(&lo, EV_PING);
+    });
+    cm4u_set_basepri(key);  /* lo now handles all of them */
+    bool ok = (lo.runs == CM4U_BENCH_ITERS) && (lo.dropped == 0u) &&
+              (lo.max_depth == CM4U_BENCH_ITERS);
+
+    uint32_t act_min = 0xFFFFFFFFu, act_max = 0u;
+    for (uint32_t i = 0u; i < CM4U_BENCH_ITERS; i++) {
+        uint32_t t0 = cm4u_bench_now();
+        (void)cm4u_task_post(&hi, EV_PING);
+        __DSB();
+        __ISB();
+#if defined(CM4U_BENCH_TIMER_SYSTICK)
+        uint32_t dt = (t0 - t_entry) & SysTick_LOAD_RELOAD_Msk;
+#else
+        uint32_t dt = t_entry - t0;
+#endif
+        if (dt < act_min) act_min = dt;
+        if (dt > act_max) act_max = dt;
+    }
+    cm4u_bench_report("kernel.activate", act_min, act_max, CM4U_BENCH_ITERS);
+    uint32_t act = *cm4u_bench_last();
+
+    CM4U_BENCH_RUN("kernel.roundtrip", {
+        (void)cm4u_task_post(&hi, EV_PING);
+        __DSB();
+        __ISB();
+    });
+
+    handled = 0u;
+    CM4U_BENCH_RUN("kernel.preempt", {
+        (void)cm4u_task_post(&lo, EV_CHAIN);
+        __DSB();
+        __ISB();
+    });
+    ok = ok && (handled == 4u * CM4U_BENCH_ITERS);
+
+    CM4U_BENCH_RUN("kernel.res_lock", {
+        uint32_t k = cm4u_res_lock(&bus);
+        cm4u_res_unlock(k);
+    });
+
+    /* Reference: each iteration is three switches, main -> 1 -> 2 -> main */
+    rtos_init();
+    CM4U_BENCH_RUN(RTOS_METRIC, {
+#if defined(CM4U_HOST)
+        cm4u_trigger_pendsv();
+        cm4u_trigger_pendsv();
+#endif
+        cm4u_trigger_pendsv();
+    });
+    uint32_t rtos_switch = *cm4u_bench_last() / 3u;
+    ok = ok && (rtos_runs == 2u * CM4U_BENCH_ITERS) && (rtos_cur == 0u);
+
+    /* The reference RTOS runs main on its own (MSP) stack: count two private stacks */
+    uint32_t tcb = 3u * (uint32_t)sizeof(cm4u_task_t) + (uint32_t)sizeof(cm4u_res_t);
+    uint32_t rtos_tcb_bytes = RTOS_TASKS * (uint32_t)sizeof(rtos_tcb_t);
+    printf("CM4U_KERNEL tasks=3 events=%u switch=%lu control_bytes=%lu shared_stack_bytes=%lu",
+           (unsigned)CM4U_CFG_TASK_EVENTS, (unsigned long)act, (unsigned long)tcb,
+           (unsigned long)msp_deepest);
+    printf(" rtos_switch=%lu rtos_tcb_bytes=%lu rtos_stack_bytes=%lu", (unsigned long)rtos_switch,
+           (unsigned long)rtos_tcb_bytes, (unsigned long)sizeof(rtos_stack));
+#if defined(CM4U_HOST)
+    printf("\n");
+#else
+    printf(" rtos_stack_used=%lu\n", (unsigned long)rtos_stack_used());
+#endif
+
+    ok = ok && (hi.dropped == 0u) && (mid.dropped == 0u) && (cm4u_get_basepri() == key);
+    return ok ? 0 : 1;
+}
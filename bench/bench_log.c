@@ -0,0 +1,76 @@
+#include <stdlib.h>
+#include "cm4u_bench.h"
+#include "cm4u_log.h"
+
+/*
+ * Deferred binary logging vs. formatting on the target.
+ *
+ *   log.call_0args / 2args / 6args   one CM4U_LOG() call
+ *   log.snprintf_2args               the same message formatted with snprintf
+ *   log.read_2args                   cm4u_log_read() of one 2-argument record
+ *
+ * On the host, CM4U_LOG_DUMP=<file> saves the drained records for
+ * tools/cm4u_log_decode.py:
+ *   CM4U_LOG_DUMP=log.bin ./bench_log && cm4u_log_decode.py bench_log log.bin
+ */
+
+static volatile uint32_t adc_ch = 3u;
+static volatile int32_t adc_val = -1234;
+static uint32_t drained[2u * CM4U_CFG_LOG_WORDS];
+static char text[64];
+
+static uint32_t drain(void)
+{
+    return cm4u_log_read(&cm4u_log_ring, drained, 2u * CM4U_CFG_LOG_WORDS);
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+
+    CM4U_BENCH_RUN("log.call_0args", {
+        CM4U_LOG("tick");
+    });
+    (void)drain();
+
+    CM4U_BENCH_RUN("log.call_2args", {
+        CM4U_LOG("adc ch%u = %d", adc_ch, adc_val);
+    });
+    (void)drain();
+
+    CM4U_BENCH_RUN("log.call_6args", {
+        CM4U_LOG("%u %u %u %u %u %x", 1u, 2u, 3u, adc_ch, 5u, 0xBEEFu);
+    });
+    (void)drain();
+
+    CM4U_BENCH_RUN("log.snprintf_2args", {
+        snprintf(text, sizeof(text), "adc ch%u = %d", (unsigned)adc_ch, (int)adc_val);
+    });
+
+    CM4U_BENCH_RUN("log.read_2args", {
+        CM4U_LOG("adc ch%u = %d", adc_ch, adc_val);
+        (void)cm4u_log_read(&cm4u_log_ring, drained, 4u);
+    });
+
+    /* A sample session for the decoder */
+    CM4U_LOG("boot: %u IRQs, clock %u Hz", 64u, (uint32_t)CM4U_CFG_CORE_CLOCK_HZ);
+    CM4U_LOG("adc ch%u = %d", adc_ch, adc_val);
+    CM4U_LOG("gain %.3f", cm4u_log_f32(1.25f));
+    uint32_t n = drain();
+
+    bool ok = (n == (2u + 2u) + (2u + 2u) + (2u + 1u)) &&
+              (CM4U_LOG_HDR_NARGS(drained[4]) == 2u) && (drained[6] == 3u) &&
+              (cm4u_log_ring.dropped == 0u);
+
+#if defined(CM4U_HOST)
+    const char *dump = getenv("CM4U_LOG_DUMP");
+    if (dump != NULL) {
+        FILE *f = fopen(dump, "wb");
+        if (f != NULL) {
+            ok = ok && (fwrite(drained, sizeof(uint32_t), n, f) == n);
+            fclose(f);
+        }
+    }
+#endif
+    return ok ? 0 : 1;
+}
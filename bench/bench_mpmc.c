@@ -0,0 +1,240 @@
+#include "cm4u_bench.h"
+
+/*
+ * Bounded MPMC queue (IRQ50 = low, IRQ51 = high).
+ *
+ *   mpmc.push              cm4u_mpmc_push() into a non-full queue
+ *   mpmc.pop               cm4u_mpmc_pop() from a non-empty queue
+ *   mpmc.push_pop          one value through
+ *   mpmc.locked_push_pop   the same through a ring guarded by PRIMASK
+ *
+ * On the host, CM4U_MPMC_STEP() preempts the algorithm: for every step k
+ * of a Thread-mode push / pop / push / pop sequence, the low ISR (push +
+ * pop) is taken right there. For every step k2 of that ISR, the high ISR
+ * (push + pop) nests inside it. Each scenario runs from an empty, a
+ * partly filled and a full queue. Afterwards every value pushed must be
+ * popped exactly once, and each call may retry at most once per
+ * preemption it suffered; a scenario that runs away (livelock) stops the
+ * program. Totals go to a "CM4U_MPMC ..." line.
+ */
+
+#define LOW_IRQ   ((IRQn_Type)50)
+#define HIGH_IRQ  ((IRQn_Type)51)
+
+#if defined(CM4U_HOST)
+#include <stdlib.h>
+static void sim_step(void);
+#define CM4U_MPMC_STEP()  sim_step()
+#endif
+#include "cm4u_mpmc.h"
+
+#define BENCH_DEPTH  128u
+#define SIM_DEPTH    4u
+#define SIM_IDS      64u
+
+static cm4u_mpmc_slot_t bench_slots[BENCH_DEPTH];
+static cm4u_mpmc_t bq;
+
+/* PRIMASK-guarded reference ring */
+static uint32_t ring[BENCH_DEPTH];
+static volatile uint32_t ring_head, ring_tail;
+
+static bool locked_push(uint32_t v)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    bool ok = (ring_head - ring_tail) < BENCH_DEPTH;
+    if (ok) {
+        ring[ring_head & (BENCH_DEPTH - 1u)] = v;
+        ring_head = ring_head + 1u;
+    }
+    __set_PRIMASK(pm);
+    return ok;
+}
+
+static bool locked_pop(uint32_t *v)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    bool ok = ring_head != ring_tail;
+    if (ok) {
+        *v = ring[ring_tail & (BENCH_DEPTH - 1u)];
+        ring_tail = ring_tail + 1u;
+    }
+    __set_PRIMASK(pm);
+    return ok;
+}
+
+/* --------------------------------------------------------------------------
+ *  Preemption injection (host)
+ * -------------------------------------------------------------------------- */
+
+static cm4u_mpmc_slot_t sim_slots[SIM_DEPTH];
+static cm4u_mpmc_t sq;
+static uint8_t pushed[SIM_IDS], popped[SIM_IDS];
+static uint32_t next_id, bad_ids;
+static bool sim_on;
+static uint32_t thread_steps, low_steps, inject_low_at, inject_high_at;
+static uint32_t injections, prefill_now;
+
+/* A correct queue needs a few dozen steps per scenario */
+#define SIM_STEP_LIMIT  1000u
+
+static void sim_push(void)
+{
+    uint32_t id = next_id++;
+    if (cm4u_mpmc_push(&sq, id)) {
+        pushed[id] = 1u;
+    }
+}
+
+static void sim_pop(void)
+{
+    uint32_t v;
+    if (cm4u_mpmc_pop(&sq, &v)) {
+        if (v < SIM_IDS) {
+            popped[v]++;
+        } else {
+            bad_ids++;
+        }
+    }
+}
+
+#if defined(CM4U_HOST)
+static void sim_step(void)
+{
+    if (!sim_on) {
+        return;
+    }
+    uint32_t exc = cm4u_get_exception_number();
+    if ((thread_steps + low_steps) > SIM_STEP_LIMIT) {
+        printf("CM4U_MPMC sim livelock prefill=%lu k=%lu k2=%lu\n", (unsigned long)prefill_now,
+               (unsigned long)inject_low_at, (unsigned long)inject_high_at);
+        exit(1);
+    }
+    if ((exc == 0u) && (++thread_steps == inject_low_at)) {
+        injections++;
+        cm4u_nvic_set_pending(LOW_IRQ);
+        __DSB();
+    } else if ((exc == (16u + (uint32_t)LOW_IRQ)) && (++low_steps == inject_high_at)) {
+        injections++;
+        cm4u_nvic_set_pending(HIGH_IRQ);
+        __DSB();
+    }
+}
+#endif
+
+void IRQ50_Handler(void)
+{
+    sim_push();
+    sim_pop();
+}
+
+void IRQ51_Handler(void)
+{
+    sim_push();
+    sim_pop();
+}
+
+/* One scenario; returns false on a lost / duplicated value or unbounded retries */
+static bool sim_run(uint32_t prefill, uint32_t k, uint32_t k2, uint32_t *steps)
+{
+    cm4u_mpmc_init(&sq, sim_slots, SIM_DEPTH);
+    for (uint32_t i = 0u; i < SIM_IDS; i++) {
+        pushed[i] = 0u;
+        popped[i] = 0u;
+    }
+    next_id = 0u;
+    bad_ids = 0u;
+    for (uint32_t i = 0u; i < prefill; i++) {
+        sim_push();
+    }
+
+    thread_steps = 0u;
+    low_steps = 0u;
+    prefill_now = prefill;
+    inject_low_at = k;
+    inject_high_at = k2;
+    uint32_t before = injections;
+    sim_on = true;
+    sim_push();
+    sim_pop();
+    sim_push();
+    sim_pop();
+    sim_on = false;
+    *steps = thread_steps;
+
+    for (uint32_t i = 0u; (i < SIM_IDS) && (cm4u_mpmc_count(&sq) != 0u); i++) {
+        sim_pop();
+    }
+    bool ok = (bad_ids == 0u) && (cm4u_mpmc_count(&sq) == 0u) &&
+              (sq.retries <= (injections - before));
+    for (uint32_t i = 0u; i < next_id; i++) {
+        ok = ok && (popped[i] == pushed[i]);
+    }
+    return ok;
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(LOW_IRQ, IRQ50_Handler);
+    cm4u_host_set_handler(HIGH_IRQ, IRQ51_Handler);
+#endif
+    cm4u_nvic_set_priority(LOW_IRQ, 4u);
+    cm4u_nvic_set_priority(HIGH_IRQ, 2u);
+    cm4u_nvic_enable_irq(LOW_IRQ);
+    cm4u_nvic_enable_irq(HIGH_IRQ);
+    cm4u_mpmc_init(&bq, bench_slots, BENCH_DEPTH);
+
+    CM4U_BENCH_RUN("mpmc.push", {
+        (void)cm4u_mpmc_push(&bq, 1u);
+    });
+    uint32_t v = 0u, sum = 0u;
+    CM4U_BENCH_RUN("mpmc.pop", {
+        (void)cm4u_mpmc_pop(&bq, &v);
+        sum += v;
+    });
+    CM4U_BENCH_RUN("mpmc.push_pop", {
+        (void)cm4u_mpmc_push(&bq, 1u);
+        (void)cm4u_mpmc_pop(&bq, &v);
+        sum += v;
+    });
+    CM4U_BENCH_RUN("mpmc.locked_push_pop", {
+        (void)locked_push(1u);
+        (void)locked_pop(&v);
+        sum += v;
+    });
+    bool ok = (sum == 3u * CM4U_BENCH_ITERS) && (bq.retries == 0u) && (cm4u_mpmc_count(&bq) == 0u);
+
+    /* Every step of the Thread sequence x every step of the low ISR */
+    static const uint32_t prefills[] = { 0u, 1u, SIM_DEPTH - 1u, SIM_DEPTH };
+    uint32_t scenarios = 0u, failures = 0u, max_retries = 0u, max_steps = 0u;
+    for (uint32_t p = 0u; p < (sizeof(prefills) / sizeof(prefills[0])); p++) {
+        uint32_t steps = 0u;
+        (void)sim_run(prefills[p], 0u, 0u, &steps);
+        if (steps > max_steps) {
+            max_steps = steps;
+        }
+        for (uint32_t k = 1u; k <= steps; k++) {
+            for (uint32_t k2 = 0u; k2 <= 24u; k2++) {
+                uint32_t s;
+                failures += sim_run(prefills[p], k, k2, &s) ? 0u : 1u;
+                scenarios++;
+                if (sq.retries > max_retries) {
+                    max_retries = sq.retries;
+                }
+            }
+        }
+    }
+    printf("CM4U_MPMC sim scenarios=%lu thread_steps=%lu injections=%lu max_retries=%lu failures=%lu\n",
+           (unsigned long)scenarios, (unsigned long)max_steps, (unsigned long)injections,
+           (unsigned long)max_retries, (unsigned long)failures);
+
+    ok = ok && (failures == 0u);
+#if defined(CM4U_HOST)
+    ok = ok && (scenarios > 0u) && (injections > scenarios);
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include "cm4u_bench.h"
+#include "cm4u_msg.h"
+
+/*
+ * Zero-copy mailboxes vs. a copy-based queue (IRQ48 = producer ISR).
+ *
+ *   msg.zc_<n>       cm4u_msg_alloc() + cm4u_mbox_send() + cm4u_mbox_recv()
+ *                    + cm4u_msg_free() for an <n>-byte message
+ *   msg.copy_<n>     the same message through a ring of <n>-byte slots:
+ *                    copied in by the sender, copied out by the receiver
+ *   msg.zc_batch8    8 sends, one cm4u_mbox_recv_batch(), 8 frees
+ *
+ * Filling and reading the payload cost the same either way and are not
+ * timed. One "CM4U_MSG ..." line per size gives cycles per message and
+ * messages per second at CM4U_CFG_CORE_CLOCK_HZ.
+ *
+ * The copy queue copies with cm4u_bench_copy(), which the host model
+ * charges as a target LDM/STM copy.
+ */
+
+#define ISR_IRQ      ((IRQn_Type)48)
+#define MAX_PAYLOAD  1024u
+#define POOL_COUNT   16u
+#define BATCH        8u
+
+static uint32_t pool_store[CM4U_POOL_WORDS(MAX_PAYLOAD, POOL_COUNT)] __attribute__((aligned(8)));
+static cm4u_pool_t pool;
+static void *slots[16];
+static cm4u_mbox_t mbox;
+
+/* Copy-based reference: single producer / single consumer ring */
+typedef struct {
+    uint8_t           data[4][MAX_PAYLOAD];
+    uint32_t          len[4];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+} copy_queue_t;
+
+static copy_queue_t cq;
+static uint8_t tx_buf[MAX_PAYLOAD], rx_buf[MAX_PAYLOAD];
+
+static bool cq_put(copy_queue_t *q, const void *src, uint32_t n)
+{
+    uint32_t head = q->head;
+    if ((head - q->tail) >= 4u) {
+        return false;
+    }
+    cm4u_bench_copy(q->data[head & 3u], src, n);
+    q->len[head & 3u] = n;
+    __DMB();
+    q->head = head + 1u;
+    return true;
+}
+
+static uint32_t cq_get(copy_queue_t *q, void *dst)
+{
+    uint32_t tail = q->tail;
+    if (tail == q->head) {
+        return 0u;
+    }
+    uint32_t n = q->len[tail & 3u];
+    cm4u_bench_copy(dst, q->data[tail & 3u], n);
+    __DMB();
+    q->tail = tail + 1u;
+    return n;
+}
+
+static volatile uint32_t isr_sent;
+
+void IRQ48_Handler(void)
+{
+    uint8_t *m = (uint8_t *)cm4u_msg_alloc(&pool);
+    if (m != 0) {
+        m[0] = (uint8_t)isr_sent;
+        if (cm4u_mbox_send(&mbox, m, 1u)) {
+            isr_sent++;
+        } else {
+            cm4u_msg_free(m);
+        }
+    }
+}
+
+static const uint32_t sizes[] = { 16u, 64u, 256u, 1024u };
+static const char *const zc_names[] = { "msg.zc_16", "msg.zc_64", "msg.zc_256", "msg.zc_1024" };
+static const char *const copy_names[] = { "msg.copy_16", "msg.copy_64", "msg.copy_256", "msg.copy_1024" };
+
+static unsigned long msgs_per_s(uint32_t cycles)
+{
+    return (cycles == 0u) ? 0ul : (unsigned long)(CM4U_CFG_CORE_CLOCK_HZ / cycles);
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(ISR_IRQ, IRQ48_Handler);
+#endif
+    cm4u_nvic_set_priority(ISR_IRQ, 4u);
+    cm4u_nvic_enable_irq(ISR_IRQ);
+    cm4u_pool_init(&pool, pool_store, MAX_PAYLOAD, POOL_COUNT);
+    cm4u_mbox_init(&mbox, slots, 16u);
+    bool ok = true;
+
+    for (uint32_t s = 0u; s < (sizeof(sizes) / sizeof(sizes[0])); s++) {
+        uint32_t n = sizes[s];
+        volatile uint32_t got = 0u;
+
+        CM4U_BENCH_RUN(zc_names[s], {
+            void *m = cm4u_msg_alloc(&pool);
+            (void)cm4u_mbox_send(&mbox, m, n);
+            void *r = cm4u_mbox_recv(&mbox);
+            got += cm4u_msg_len(r);
+            cm4u_msg_free(r);
+        });
+        uint32_t zc = *cm4u_bench_last();
+
+        CM4U_BENCH_RUN(copy_names[s], {
+            (void)cq_put(&cq, tx_buf, n);
+            got += cq_get(&cq, rx_buf);
+        });
+        uint32_t cp = *cm4u_bench_last();
+
+        ok = ok && (got == 2u * CM4U_BENCH_ITERS * n);
+        printf("CM4U_MSG size=%lu zc_cycles=%lu copy_cycles=%lu zc_msgs_per_s=%lu copy_msgs_per_s=%lu\n",
+               (unsigned long)n, (unsigned long)zc, (unsigned long)cp, msgs_per_s(zc), msgs_per_s(cp));
+    }
+
+    void *batch[BATCH];
+    volatile uint32_t batched = 0u;
+    CM4U_BENCH_RUN("msg.zc_batch8", {
+        for (uint32_t i = 0u; i < BATCH; i++) {
+            (void)cm4u_mbox_send(&mbox, cm4u_msg_alloc(&pool), 64u);
+        }
+        uint32_t k = cm4u_mbox_recv_batch(&mbox, batch, BATCH);
+        for (uint32_t i = 0u; i < k; i++) {
+            cm4u_msg_free(batch[i]);
+        }
+        batched += k;
+    });
+    uint32_t b8 = *cm4u_bench_last();
+    printf("CM4U_MSG batch=%lu cycles_per_msg=%lu msgs_per_s=%lu\n",
+           (unsigned long)BATCH, (unsigned long)(b8 / BATCH), msgs_per_s(b8 / BATCH));
+    ok = ok && (batched == BATCH * CM4U_BENCH_ITERS);
+
+    /* ISR producer, Thread consumer: everything arrives, every buffer returns */
+    uint32_t received = 0u;
+    for (uint32_t i = 0u; i < 100u; i++) {
+        cm4u_nvic_set_pending(ISR_IRQ);
+        __DSB();
+        __ISB();
+        void *m = cm4u_mbox_recv(&mbox);
+        if (m != 0) {
+            ok = ok && (*(uint8_t *)m == (uint8_t)received);
+            received++;
+            cm4u_msg_free(m);
+        }
+    }
+    ok = ok && (received == 100u) && (isr_sent == 100u) && (mbox.dropped == 0u) &&
+         (pool.alloc_failures == 0u) && (pool.violations == 0u) && (cm4u_mbox_queued(&mbox) == 0u);
+
+    uint32_t nfree = 0u;
+    while (cm4u_msg_alloc(&pool) != 0) {
+        nfree++;
+    }
+    return (ok && (nfree == POOL_COUNT)) ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include "cm4u_bench.h"
+#include "cm4u_mutex.h"
+
+/*
+ * Priority-inheritance mutex (IRQ46 = high, IRQ47 = medium).
+ *
+ *   mutex.lock_unlock   uncontended cm4u_mutex_lock() + cm4u_mutex_unlock()
+ *   mutex.handoff       Thread holds the mutex; the high ISR tried it and
+ *                       was deferred. Cycles from cm4u_mutex_unlock() to the
+ *                       high ISR owning the mutex
+ *
+ * The run also checks the inheritance: the medium ISR, pended while Thread
+ * holds the mutex, must not run before the high ISR has had it. A SysTick
+ * waiter must be pended again too. With a non-zero inversion threshold,
+ * a short wait must not be flagged.
+ */
+
+#define HIGH_IRQ  ((IRQn_Type)46)
+#define MID_IRQ   ((IRQn_Type)47)
+
+/* Far above any hand-off: a wait this short is not an inversion */
+#define INVERSION_CYCLES  100000u
+
+static cm4u_mutex_t m;
+static volatile uint32_t t_acquired;
+static volatile uint32_t high_deferred, high_acquired;
+static volatile uint32_t mid_runs, mid_before_high;
+static volatile uint32_t tick_deferred, tick_acquired;
+
+void IRQ46_Handler(void)
+{
+    if (!cm4u_mutex_lock(&m)) {
+        high_deferred++;
+        return;  /* pended again by cm4u_mutex_unlock() */
+    }
+    t_acquired = cm4u_bench_now();
+    high_acquired++;
+    cm4u_mutex_unlock(&m);
+}
+
+void IRQ47_Handler(void)
+{
+    mid_runs++;
+    if (high_acquired < high_deferred) {
+        mid_before_high++;  /* would be an unbounded inversion */
+    }
+}
+
+void SysTick_Handler(void)
+{
+    if (!cm4u_mutex_lock(&m)) {
+        tick_deferred++;
+        return;
+    }
+    tick_acquired++;
+    cm4u_mutex_unlock(&m);
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(HIGH_IRQ, IRQ46_Handler);
+    cm4u_host_set_handler(MID_IRQ, IRQ47_Handler);
+    cm4u_host_set_handler(SysTick_IRQn, SysTick_Handler);
+#endif
+    cm4u_nvic_set_priority(HIGH_IRQ, 2u);
+    cm4u_nvic_set_priority(MID_IRQ, 4u);
+    cm4u_nvic_enable_irq(HIGH_IRQ);
+    cm4u_nvic_enable_irq(MID_IRQ);
+    cm4u_mutex_init(&m, 0u);
+
+    CM4U_BENCH_RUN("mutex.lock_unlock", {
+        (void)cm4u_mutex_lock(&m);
+        cm4u_mutex_unlock(&m);
+    });
+    bool ok = (m.contentions == 0u);
+
+    uint32_t h_min = 0xFFFFFFFFu, h_max = 0u;
+    for (uint32_t i = 0u; i < CM4U_BENCH_ITERS; i++) {
+        (void)cm4u_mutex_lock(&m);
+        cm4u_nvic_set_pending(HIGH_IRQ);  /* deferred: Thread now runs at its priority */
+        cm4u_nvic_set_pending(MID_IRQ);   /* must wait for the high ISR */
+        __DSB();
+        __ISB();
+        uint32_t t0 = cm4u_bench_now();
+        cm4u_mutex_unlock(&m);
+#if defined(CM4U_BENCH_TIMER_SYSTICK)
+        uint32_t dt = (t0 - t_acquired) & SysTick_LOAD_RELOAD_Msk;
+#else
+        uint32_t dt = t_acquired - t0;
+#endif
+        if (dt < h_min) h_min = dt;
+        if (dt > h_max) h_max = dt;
+    }
+    cm4u_bench_report("mutex.handoff", h_min, h_max, CM4U_BENCH_ITERS);
+
+    ok = ok && (high_deferred == CM4U_BENCH_ITERS) && (high_acquired == CM4U_BENCH_ITERS) &&
+         (mid_runs == CM4U_BENCH_ITERS) && (mid_before_high == 0u) &&
+         (m.contentions == CM4U_BENCH_ITERS) && (m.inversions == CM4U_BENCH_ITERS) &&
+         (m.last_inversion.owner == CM4U_MUTEX_THREAD) &&
+         (m.last_inversion.waiter == 16u + (uint32_t)HIGH_IRQ) &&
+         (cm4u_mutex_owner(&m) < 0) && (cm4u_get_basepri() == 0u);
+
+    /* SysTick waiter, and a wait below the threshold */
+    cm4u_mutex_init(&m, INVERSION_CYCLES);
+    NVIC_SetPriority(SysTick_IRQn, 3u);
+    (void)cm4u_mutex_lock(&m);
+    SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+    __DSB();
+    __ISB();
+    cm4u_mutex_unlock(&m);
+    __DSB();
+    __ISB();
+    ok = ok && (tick_deferred == 1u) && (tick_acquired == 1u) && (m.contentions == 1u) &&
+         (m.inversions == 0u) && (m.max_block_cycles < INVERSION_CYCLES) && (cm4u_get_basepri() == 0u);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include "cm4u_bench.h"
+#include "cm4u_preempt.h"
+
+/*
+ * Preemption matrix and execution profiles (IRQ52 = low, IRQ53 = mid,
+ * IRQ54 = high, IRQ55 / 56 = empty handlers, plain and instrumented).
+ *
+ *   preempt.isr_plain         pend + take an empty handler
+ *   preempt.isr_instrumented  the same with CM4U_PREEMPT_ENTER / EXIT
+ *   preempt.critical_plain    cm4u_critical_enter() / _exit()
+ *   preempt.critical_timed    CM4U_PREEMPT_CRITICAL_ENTER() / _EXIT()
+ *
+ * Then low pends mid, which pends high, a number of times, and Thread and
+ * low run critical sections. The run checks the cells Thread <- low,
+ * low <- mid, mid <- high, the nesting depth and the profiles (runs,
+ * exclusive times, critical sections), and prints the matrix on
+ * "CM4U_PREEMPT ..." lines. On the host, CM4U_PREEMPT_DUMP=<file> saves
+ * the export for tools/cm4u_preempt_report.py and tools/cm4u_rta.py:
+ *   CM4U_PREEMPT_DUMP=pm.bin ./bench_preempt && cm4u_rta.py pm.bin
+ */
+
+#define LOW_IRQ    ((IRQn_Type)52)
+#define MID_IRQ    ((IRQn_Type)53)
+#define HIGH_IRQ   ((IRQn_Type)54)
+#define PLAIN_IRQ  ((IRQn_Type)55)
+#define INSTR_IRQ  ((IRQn_Type)56)
+
+#define NESTED_RUNS  10u
+
+static volatile uint32_t sink;
+
+static void work(uint32_t n)
+{
+    for (uint32_t i = 0u; i < n; i++) {
+        sink = sink + __CLZ(i);
+        __NOP();  /* ticks the host clock */
+    }
+}
+
+static void pend(IRQn_Type irq)
+{
+    cm4u_nvic_set_pending(irq);
+    __DSB();
+    __ISB();
+}
+
+void IRQ52_Handler(void)
+{
+    CM4U_PREEMPT_ENTER();
+    work(4u);
+    pend(MID_IRQ);
+    uint32_t key = CM4U_PREEMPT_CRITICAL_ENTER();
+    work(4u);
+    CM4U_PREEMPT_CRITICAL_EXIT(key);
+    CM4U_PREEMPT_EXIT();
+}
+
+void IRQ53_Handler(void)
+{
+    CM4U_PREEMPT_ENTER();
+    work(2u);
+    pend(HIGH_IRQ);
+    CM4U_PREEMPT_EXIT();
+}
+
+static void high_isr(void)
+{
+    work(8u);
+}
+
+CM4U_PREEMPT_WRAP(IRQ54_Handler, high_isr)
+
+void IRQ55_Handler(void)
+{
+}
+
+void IRQ56_Handler(void)
+{
+    CM4U_PREEMPT_ENTER();
+    CM4U_PREEMPT_EXIT();
+}
+
+static const char *slot_name(uint32_t exc)
+{
+    static char buf[24];
+    if (exc == 0u) {
+        return "Thread";
+    }
+    if (exc == CM4U_PREEMPT_OTHER) {
+        return "other";
+    }
+    snprintf(buf, sizeof(buf), "IRQ%lu", (unsigned long)(exc - 16u));
+    return buf;
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(LOW_IRQ, IRQ52_Handler);
+    cm4u_host_set_handler(MID_IRQ, IRQ53_Handler);
+    cm4u_host_set_handler(HIGH_IRQ, IRQ54_Handler);
+    cm4u_host_set_handler(PLAIN_IRQ, IRQ55_Handler);
+    cm4u_host_set_handler(INSTR_IRQ, IRQ56_Handler);
+#endif
+    cm4u_nvic_set_priority(LOW_IRQ, 6u);
+    cm4u_nvic_set_priority(MID_IRQ, 4u);
+    cm4u_nvic_set_priority(HIGH_IRQ, 2u);
+    cm4u_nvic_set_priority(PLAIN_IRQ, 6u);
+    cm4u_nvic_set_priority(INSTR_IRQ, 6u);
+    cm4u_nvic_enable_irq(LOW_IRQ);
+    cm4u_nvic_enable_irq(MID_IRQ);
+    cm4u_nvic_enable_irq(HIGH_IRQ);
+    cm4u_nvic_enable_irq(PLAIN_IRQ);
+    cm4u_nvic_enable_irq(INSTR_IRQ);
+    (void)cm4u_dwt_init();
+
+    cm4u_preempt_reset();
+    CM4U_BENCH_RUN("preempt.isr_plain", {
+        pend(PLAIN_IRQ);
+    });
+    CM4U_BENCH_RUN("preempt.isr_instrumented", {
+        pend(INSTR_IRQ);
+    });
+
+    CM4U_BENCH_RUN("preempt.critical_plain", {
+        uint32_t key = cm4u_critical_enter();
+        cm4u_critical_exit(key);
+    });
+    CM4U_BENCH_RUN("preempt.critical_timed", {
+        uint32_t key = CM4U_PREEMPT_CRITICAL_ENTER();
+        CM4U_PREEMPT_CRITICAL_EXIT(key);
+    });
+
+    cm4u_preempt_reset();
+    for (uint32_t i = 0u; i < NESTED_RUNS; i++) {
+        pend(LOW_IRQ);
+        uint32_t key = CM4U_PREEMPT_CRITICAL_ENTER();
+        work(12u);
+        uint32_t inner = CM4U_PREEMPT_CRITICAL_ENTER();  /* nested: not timed on its own */
+        CM4U_PREEMPT_CRITICAL_EXIT(inner);
+        CM4U_PREEMPT_CRITICAL_EXIT(key);
+    }
+
+    static cm4u_preempt_t pm;
+    cm4u_preempt_snapshot(&pm);
+
+    /* Slots in first-run order: low, mid, high */
+    const cm4u_preempt_cell_t *t_low = &pm.cell[0][1];
+    const cm4u_preempt_cell_t *low_mid = &pm.cell[1][2];
+    const cm4u_preempt_cell_t *mid_high = &pm.cell[2][3];
+    bool ok = (pm.magic == CM4U_PREEMPT_MAGIC) && (pm.max_depth == 3u) && (pm.overflow == 0u) &&
+              (pm.exc[0] == 0u) && (pm.exc[1] == 16u + (uint32_t)LOW_IRQ) &&
+              (pm.exc[2] == 16u + (uint32_t)MID_IRQ) && (pm.exc[3] == 16u + (uint32_t)HIGH_IRQ) &&
+              (t_low->count == NESTED_RUNS) && (low_mid->count == NESTED_RUNS) &&
+              (mid_high->count == NESTED_RUNS) && (pm.cell[0][2].count == 0u) &&
+              (cm4u_preempt.depth == 0u);
+    const cm4u_preempt_prof_t *thread = &pm.prof[0];
+    const cm4u_preempt_prof_t *low = &pm.prof[1];
+    const cm4u_preempt_prof_t *high = &pm.prof[3];
+    ok = ok && (low->runs == NESTED_RUNS) && (pm.prof[2].runs == NESTED_RUNS) &&
+         (high->runs == NESTED_RUNS) && (low->priority == 6) && (high->priority == 2) &&
+         (low->gap_min > 0u) && ((low->last - low->first) >= (NESTED_RUNS - 1u) * low->gap_min) &&
+         (thread->crit_count == NESTED_RUNS) && (low->crit_count == NESTED_RUNS) &&
+         (pm.prof[2].crit_count == 0u) && (pm.prio_bits == __NVIC_PRIO_BITS);
+#if defined(CM4U_HOST)
+    /* Inclusive times: each victim lost at least what the level above took */
+    ok = ok && (mid_high->max > 0u) && (low_mid->max > mid_high->max) && (t_low->max > low_mid->max);
+    /* Exclusive times: low's own run is shorter than what Thread lost to it */
+    ok = ok && (low->exec_max > 0u) && (low->exec_max < t_low->max) && (low->crit_max > 0u) &&
+         (low->crit_max < low->exec_max) && (thread->crit_max > low->crit_max);
+#endif
+
+    for (uint32_t v = 0u; v < pm.slots; v++) {
+        for (uint32_t p = 0u; p < pm.slots; p++) {
+            const cm4u_preempt_cell_t *c = &pm.cell[v][p];
+            if (c->count != 0u) {
+                printf("CM4U_PREEMPT victim=%s", slot_name(pm.exc[v]));
+                printf(" by=%s count=%lu cycles=%lu max=%lu\n", slot_name(pm.exc[p]),
+                       (unsigned long)c->count, (unsigned long)c->cycles, (unsigned long)c->max);
+            }
+        }
+    }
+    for (uint32_t i = 1u; (i < pm.slots) && (pm.exc[i] != CM4U_PREEMPT_OTHER); i++) {
+        const cm4u_preempt_prof_t *f = &pm.prof[i];
+        printf("CM4U_PREEMPT handler=%s", slot_name(pm.exc[i]));
+        printf(" priority=%ld runs=%lu exec_max=%lu gap_min=%lu crit_max=%lu\n", (long)f->priority,
+               (unsigned long)f->runs, (unsigned long)f->exec_max, (unsigned long)f->gap_min,
+               (unsigned long)f->crit_max);
+    }
+    printf("CM4U_PREEMPT max_depth=%lu overflow=%lu export_bytes=%lu\n", (unsigned long)pm.max_depth,
+           (unsigned long)pm.overflow, (unsigned long)CM4U_PREEMPT_EXPORT_BYTES);
+
+#if defined(CM4U_HOST)
+    const char *dump = getenv("CM4U_PREEMPT_DUMP");
+    if (dump != NULL) {
+        FILE *f = fopen(dump, "wb");
+        if (f != NULL) {
+            ok = ok && (fwrite(&pm, 1u, CM4U_PREEMPT_EXPORT_BYTES, f) == CM4U_PREEMPT_EXPORT_BYTES);
+            fclose(f);
+        }
+    }
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include "cm4u_bench.h"
+#include "cm4u_idle.h"
+
+/*
+ * Sleep-on-exit vs. main-loop-with-WFI.
+ *
+ *   soe.mainloop_event   one event the traditional way: wake from WFI, take
+ *                        the ISR, return to Thread, loop, sleep again
+ *   soe.chain_32_events  32 events handled ISR-to-ISR (what SLEEPONEXIT
+ *                        gives you: no return to Thread in between)
+ *   soe.roundtrip_saved  per-event difference; use it as
+ *                        cm4u_soe_t.roundtrip_cycles on this part
+ *   soe.run_32_events    cm4u_soe_run() end to end: 32 ISRs, one Thread run
+ */
+
+#define BENCH_IRQ     ((IRQn_Type)8)
+#define BENCH_EVENTS  32u
+
+static cm4u_soe_t soe;
+static volatile uint32_t chain_left;
+static volatile uint32_t events;
+
+void IRQ8_Handler(void)
+{
+    events++;
+    if (chain_left != 0u) {
+        chain_left--;
+        cm4u_nvic_set_pending(BENCH_IRQ);  /* next event tail-chains */
+    } else if (soe.work != 0) {
+        cm4u_soe_request_thread(&soe);
+    }
+    cm4u_soe_isr_exit(&soe);
+}
+
+static void bench_soe_work(void *ctx)
+{
+    (void)ctx;
+    soe.stop = true;
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(BENCH_IRQ, IRQ8_Handler);
+#endif
+    cm4u_nvic_set_priority(BENCH_IRQ, 1u);
+    cm4u_nvic_enable_irq(BENCH_IRQ);
+
+    CM4U_BENCH_RUN("soe.mainloop_event", {
+        __disable_irq();
+        cm4u_nvic_set_pending(BENCH_IRQ);
+        __DSB();
+        __WFI();         /* event already pending: wakes at once */
+        __enable_irq();  /* ISR runs, returns to Thread */
+    });
+    uint32_t mainloop = *cm4u_bench_last();
+
+    CM4U_BENCH_RUN("soe.chain_32_events", {
+        chain_left = BENCH_EVENTS - 1u;
+        cm4u_nvic_set_pending(BENCH_IRQ);
+    });
+    uint32_t chained = *cm4u_bench_last() / BENCH_EVENTS;
+
+    uint32_t saved = (mainloop > chained) ? (mainloop - chained) : 0u;
+    cm4u_bench_report_value("soe.roundtrip_saved", saved, saved, 1u);
+
+    CM4U_BENCH_RUN("soe.run_32_events", {
+        cm4u_soe_init(&soe, bench_soe_work, 0);
+        chain_left = BENCH_EVENTS - 1u;
+        __disable_irq();
+        cm4u_nvic_set_pending(BENCH_IRQ);  /* taken once cm4u_soe_run unmasks */
+        __enable_irq();
+        cm4u_soe_run(&soe);
+    });
+
+    return (soe.thread_runs >= 1u) ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include "cm4u_bench.h"
+#include "cm4u_snapshot.h"
+
+/*
+ * Warm restart: full core bring-up vs. replaying a cm4u_snapshot_t.
+ *
+ *   snapshot.cold_init      NVIC priorities / enables one by one, fault
+ *                           enables, SysTick, DWT and 8 MPU regions
+ *   snapshot.warm_restore   cm4u_snapshot_try_restore(): checksum + replay
+ *   snapshot.save           capture after a cold init
+ *   snapshot.boot_saved     cold_init - warm_restore
+ *
+ * Each iteration starts from the core's reset state. With the SysTick
+ * timebase (QEMU) SysTick is left out of both paths.
+ *
+ * The host only counts core register accesses, one step each, and the
+ * restore does fewer of them by construction. What the checksum and the
+ * word stores really cost next to the NVIC_* calls only shows on QEMU or
+ * the target, so on the host every metric gets a "_modelled" suffix and
+ * the saving is not claimed.
+ */
+
+#define BENCH_IRQS     64u
+#define BENCH_REGIONS  8u
+
+#if defined(CM4U_BENCH_TIMER_SYSTICK)
+#define BENCH_PARTS    (CM4U_SNAPSHOT_ALL & ~CM4U_SNAPSHOT_SYSTICK)
+#else
+#define BENCH_PARTS    CM4U_SNAPSHOT_ALL
+#endif
+
+#if defined(CM4U_HOST)
+#define SNAP_METRIC(name)  "snapshot." name "_modelled"
+#else
+#define SNAP_METRIC(name)  "snapshot." name
+#endif
+
+static cm4u_snapshot_t boot_state CM4U_SNAPSHOT_RETAINED;
+
+/* 64 KB, full access, region enabled */
+#define BENCH_RASR     ((3u << MPU_RASR_AP_Pos) | (15u << MPU_RASR_SIZE_Pos) | MPU_RASR_ENABLE_Msk)
+
+/* What the boot code does without a snapshot */
+static void cold_core_init(void)
+{
+    NVIC_SetPriorityGrouping(3u);
+    NVIC_SetPriority(SVCall_IRQn, 1u);
+    NVIC_SetPriority(PendSV_IRQn, 7u);
+    NVIC_SetPriority(SysTick_IRQn, 6u);
+    for (uint32_t i = 0u; i < BENCH_IRQS; i++) {
+        NVIC_SetPriority((IRQn_Type)i, i & 7u);
+    }
+    for (uint32_t i = 0u; i < BENCH_IRQS; i += 2u) {
+        NVIC_EnableIRQ((IRQn_Type)i);
+    }
+    SCB->SHCSR |= SCB_SHCSR_USGFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_MEMFAULTENA_Msk;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#if !defined(CM4U_BENCH_TIMER_SYSTICK)
+    SysTick->LOAD = (CM4U_CFG_CORE_CLOCK_HZ / 1000u) - 1u;
+    SysTick->VAL  = 0u;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+#endif
+
+    MPU->CTRL = 0u;
+    for (uint32_t r = 0u; r < BENCH_REGIONS; r++) {
+        MPU->RNR  = r;
+        MPU->RBAR = 0x20000000u + (r << 16);
+        MPU->RASR = BENCH_RASR;
+    }
+    MPU->CTRL = MPU_CTRL_PRIVDEFENA_Msk | MPU_CTRL_ENABLE_Msk;
+    __DSB();
+    __ISB();
+}
+
+static void warm_core_init(void)
+{
+    (void)cm4u_snapshot_try_restore(&boot_state);
+}
+
+/* Back to what the core looks like after reset (DWT stays: it is the timebase) */
+static void core_reset_state(void)
+{
+    MPU->CTRL = 0u;
+    for (uint32_t r = 0u; r < BENCH_REGIONS; r++) {
+        MPU->RNR  = r;
+        MPU->RBAR = 0u;
+        MPU->RASR = 0u;
+    }
+    for (uint32_t i = 0u; i < BENCH_IRQS; i++) {
+        NVIC_DisableIRQ((IRQn_Type)i);
+        NVIC_ClearPendingIRQ((IRQn_Type)i);
+        NVIC_SetPriority((IRQn_Type)i, 0u);
+    }
+    NVIC_SetPriority(SVCall_IRQn, 0u);
+    NVIC_SetPriority(PendSV_IRQn, 0u);
+    NVIC_SetPriority(SysTick_IRQn, 0u);
+    NVIC_SetPriorityGrouping(0u);
+    SCB->SHCSR = 0u;
+#if !defined(CM4U_BENCH_TIMER_SYSTICK)
+    SysTick->CTRL = 0u;
+#endif
+    __DSB();
+    __ISB();
+}
+
+/* Did the restore reproduce the cold init? */
+static bool core_matches_cold(void)
+{
+    bool ok = (NVIC_GetPriorityGrouping() == 3u) &&
+              (NVIC_GetPriority(PendSV_IRQn) == 7u) &&
+              ((MPU->CTRL & MPU_CTRL_ENABLE_Msk) != 0u);
+    for (uint32_t i = 0u; i < BENCH_IRQS; i++) {
+        ok = ok && (NVIC_GetPriority((IRQn_Type)i) == (i & 7u)) &&
+             (NVIC_GetEnableIRQ((IRQn_Type)i) == (((i & 1u) == 0u) ? 1u : 0u));
+    }
+    for (uint32_t r = 0u; r < BENCH_REGIONS; r++) {
+        MPU->RNR = r;
+        ok = ok && ((MPU->RBAR & MPU_RBAR_ADDR_Msk) == (0x20000000u + (r << 16))) &&
+             (MPU->RASR == BENCH_RASR);
+    }
+    return ok;
+}
+
+static uint32_t bench_boot(const char *name, void (*init)(void))
+{
+    uint32_t min = 0xFFFFFFFFu;
+    uint32_t max = 0u;
+    for (uint32_t i = 0u; i < CM4U_BENCH_ITERS; i++) {
+        core_reset_state();
+        uint32_t t = cm4u_bench_now();
+        init();
+        t = cm4u_bench_elapsed(t);
+        if (t < min) min = t;
+        if (t > max) max = t;
+    }
+    cm4u_bench_report(name, min, max, CM4U_BENCH_ITERS);
+    return *cm4u_bench_last();
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+    uint32_t pm = cm4u_critical_enter();  /* enabled IRQs must not fire into Default_Handler */
+
+    uint32_t cold = bench_boot(SNAP_METRIC("cold_init"), cold_core_init);
+
+    CM4U_BENCH_RUN(SNAP_METRIC("save"), {
+        cm4u_snapshot_save(&boot_state, BENCH_PARTS);
+    });
+
+    uint32_t warm = bench_boot(SNAP_METRIC("warm_restore"), warm_core_init);
+    bool ok = core_matches_cold();
+
+    cm4u_bench_report_value(SNAP_METRIC("boot_saved"), (cold > warm) ? (cold - warm) : 0u,
+                            (cold > warm) ? (cold - warm) : 0u, 1u);
+
+    core_reset_state();
+    cm4u_snapshot_invalidate(&boot_state);
+    cm4u_critical_exit(pm);
+
+    return (ok && !cm4u_snapshot_valid(&boot_state)) ? 0 : 1;
+}
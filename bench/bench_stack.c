@@ -0,0 +1,239 @@
+#include <stdlib.h>
+#include "cm4u_bench.h"
+
+/*
+ * Worst-case MSP estimate (IRQ57 = low, IRQ58 / IRQ59 = mid, IRQ60 = high,
+ * IRQ61 / 62 = empty handlers, plain and instrumented).
+ *
+ *   stack.isr_plain         pend + take an empty handler
+ *   stack.isr_instrumented  the same with CM4U_STACK_ENTER / EXIT
+ *
+ * Then Thread, on 40 bytes of MSP, lets low preempt it. Low pends mid
+ * while 64 bytes deep. Mid sets FPCA, as if it had used the FPU, and
+ * pends high while 128 bytes deep, so high gets an FP frame. IRQ59 shares
+ * mid's priority and needs 200 bytes, but never nests. The run checks the
+ * per-handler frames and bodies, the painted high water and both
+ * estimates, and prints them on a "CM4U_STACK ..." line. On the host it
+ * also checks that a deep Thread excursion still counts in the high water
+ * after a handler window has repainted it.
+ *
+ * The host backend stacks no frame contents and the handlers run on the
+ * host stack, so here the bodies are simulated: the handler lowers the
+ * simulated MSP and writes the words. CM4U_STACK_WORD() maps the MSP
+ * addresses onto `msp_ram`. On the target the same handlers measure
+ * their real stack use.
+ *
+ * On the host, CM4U_STACK_DUMP=<file> saves the snapshot for
+ * tools/cm4u_stack_report.py:
+ *   CM4U_STACK_DUMP=stack.bin ./bench_stack && cm4u_stack_report.py stack.bin
+ */
+
+#if defined(CM4U_HOST)
+#define MSP_BASE  0x20000000u
+#define MSP_WORDS 1024u
+static uint32_t msp_ram[MSP_WORDS];
+#define CM4U_STACK_WORD(addr)  (msp_ram[((addr) - MSP_BASE) >> 2])
+#endif
+#include "cm4u_stack.h"
+
+#define LOW_IRQ    ((IRQn_Type)57)
+#define MID_IRQ    ((IRQn_Type)58)
+#define SIDE_IRQ   ((IRQn_Type)59)
+#define HIGH_IRQ   ((IRQn_Type)60)
+#define PLAIN_IRQ  ((IRQn_Type)61)
+#define INSTR_IRQ  ((IRQn_Type)62)
+
+#define RUNS  4u
+
+static volatile uint32_t sink;
+
+static void pend(IRQn_Type irq)
+{
+    cm4u_nvic_set_pending(irq);
+    __DSB();
+    __ISB();
+}
+
+/* Use `bytes` of stack and pend `irq` (if any) while at that depth */
+static void use_stack(uint32_t bytes, IRQn_Type irq, bool pend_it)
+{
+#if defined(CM4U_HOST)
+    uint32_t sp = __get_MSP();
+    __set_MSP(sp - bytes);
+    for (uint32_t a = sp - bytes; a < sp; a += 4u) {
+        CM4U_STACK_WORD(a) = a;
+    }
+    if (pend_it) {
+        pend(irq);
+    }
+    __set_MSP(sp);
+#else
+    volatile uint32_t local[64];
+    uint32_t n = bytes / 4u;
+    for (uint32_t i = 0u; i < n; i++) {
+        local[i] = i;
+    }
+    if (pend_it) {
+        pend(irq);
+    }
+    sink = local[0];
+#endif
+}
+
+static volatile bool nest;
+
+void IRQ57_Handler(void)
+{
+    CM4U_STACK_ENTER();
+    use_stack(64u, MID_IRQ, nest);
+    CM4U_STACK_EXIT();
+}
+
+void IRQ58_Handler(void)
+{
+    CM4U_STACK_ENTER();
+#if defined(CM4U_HOST)
+    __set_CONTROL(__get_CONTROL() | 0x4u);  /* FPCA: FP state in this context */
+#endif
+    use_stack(128u, HIGH_IRQ, nest);
+    CM4U_STACK_EXIT();
+}
+
+void IRQ59_Handler(void)
+{
+    CM4U_STACK_ENTER();
+    use_stack(200u, SIDE_IRQ, false);
+    CM4U_STACK_EXIT();
+}
+
+static void high_isr(void)
+{
+    use_stack(48u, HIGH_IRQ, false);
+}
+
+CM4U_STACK_WRAP(IRQ60_Handler, high_isr)
+
+void IRQ61_Handler(void)
+{
+}
+
+void IRQ62_Handler(void)
+{
+    CM4U_STACK_ENTER();
+    CM4U_STACK_EXIT();
+}
+
+static const cm4u_stack_isr_t *find(const cm4u_stack_t *s, IRQn_Type irq)
+{
+    for (uint32_t i = 0u; i < CM4U_CFG_STACK_SLOTS; i++) {
+        if (s->isr[i].exc == 16u + (uint32_t)irq) {
+            return &s->isr[i];
+        }
+    }
+    return &s->isr[CM4U_CFG_STACK_SLOTS - 1u];
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(LOW_IRQ, IRQ57_Handler);
+    cm4u_host_set_handler(MID_IRQ, IRQ58_Handler);
+    cm4u_host_set_handler(SIDE_IRQ, IRQ59_Handler);
+    cm4u_host_set_handler(HIGH_IRQ, IRQ60_Handler);
+    cm4u_host_set_handler(PLAIN_IRQ, IRQ61_Handler);
+    cm4u_host_set_handler(INSTR_IRQ, IRQ62_Handler);
+    uint32_t top = MSP_BASE + 4u * MSP_WORDS;
+    uint32_t limit = MSP_BASE;
+    __set_MSP(top);
+#else
+    extern uint32_t __StackTop;
+    extern uint32_t __StackLimit;
+    uint32_t top = (uint32_t)(uintptr_t)&__StackTop;
+    uint32_t limit = (uint32_t)(uintptr_t)&__StackLimit;
+#endif
+    cm4u_nvic_set_priority(LOW_IRQ, 6u);
+    cm4u_nvic_set_priority(MID_IRQ, 4u);
+    cm4u_nvic_set_priority(SIDE_IRQ, 4u);
+    cm4u_nvic_set_priority(HIGH_IRQ, 2u);
+    cm4u_nvic_set_priority(PLAIN_IRQ, 6u);
+    cm4u_nvic_set_priority(INSTR_IRQ, 6u);
+    cm4u_nvic_enable_irq(LOW_IRQ);
+    cm4u_nvic_enable_irq(MID_IRQ);
+    cm4u_nvic_enable_irq(SIDE_IRQ);
+    cm4u_nvic_enable_irq(HIGH_IRQ);
+    cm4u_nvic_enable_irq(PLAIN_IRQ);
+    cm4u_nvic_enable_irq(INSTR_IRQ);
+
+    cm4u_stack_init(limit, top);
+    CM4U_BENCH_RUN("stack.isr_plain", {
+        pend(PLAIN_IRQ);
+    });
+    CM4U_BENCH_RUN("stack.isr_instrumented", {
+        pend(INSTR_IRQ);
+    });
+
+    cm4u_stack_init(limit, top);
+#if defined(CM4U_HOST)
+    __set_MSP(top - 40u);  /* Thread's own use */
+#endif
+    for (uint32_t i = 0u; i < RUNS; i++) {
+        nest = (i != 0u);  /* one clean run each for low and mid */
+        pend(LOW_IRQ);
+        nest = false;
+        pend(MID_IRQ);
+        pend(SIDE_IRQ);
+    }
+#if defined(CM4U_HOST)
+    __set_MSP(top);
+#endif
+
+    static cm4u_stack_t snap;
+    cm4u_stack_snapshot(&snap);
+    uint32_t observed = cm4u_stack_estimate(&snap, false);
+    uint32_t fp = cm4u_stack_estimate(&snap, true);
+    const cm4u_stack_isr_t *lo = find(&snap, LOW_IRQ);
+    const cm4u_stack_isr_t *mid = find(&snap, MID_IRQ);
+    const cm4u_stack_isr_t *side = find(&snap, SIDE_IRQ);
+    const cm4u_stack_isr_t *hi = find(&snap, HIGH_IRQ);
+
+    bool ok = (snap.magic == CM4U_STACK_MAGIC) && (snap.max_depth == 3u) && (snap.overflow == 0u) &&
+              (lo->runs_clean == 1u) && (lo->runs_nested == RUNS - 1u) &&
+              (hi->runs_clean == RUNS - 1u) && (side->runs_clean == RUNS) &&
+              (cm4u_stack_group(&snap, mid) == cm4u_stack_group(&snap, side)) &&
+              (fp > observed) && (snap.used <= observed) && (observed < (top - limit)) &&
+              (cm4u_stack.depth == 0u);
+#if defined(CM4U_HOST)
+    /* Exact on the host: 40 + (32 + 64) + (32 + 200) + (104 + 48) */
+    ok = ok && (snap.thread_max == 40u) && (lo->frame_max == 32u) && (hi->frame_max == 104u) &&
+         (lo->body_clean == 64u) && (mid->body_clean == 128u) && (side->body_clean == 200u) &&
+         (hi->body_clean == 48u) && (observed == 520u) &&
+         (fp == 40u + (108u + 64u) + (108u + 200u) + (108u + 48u)) &&
+         (snap.used == 40u + 32u + 64u + 32u + 128u + 104u + 48u);
+#endif
+
+    printf("CM4U_STACK reserved=%lu used=%lu estimate=%lu estimate_fp=%lu thread=%lu max_depth=%lu\n",
+           (unsigned long)(top - limit), (unsigned long)snap.used, (unsigned long)observed,
+           (unsigned long)fp, (unsigned long)snap.thread_max, (unsigned long)snap.max_depth);
+#if defined(CM4U_HOST)
+    /* Thread dirties 300 bytes, then IRQ59's window repaints the bottom 28 */
+    static cm4u_stack_t again;
+    cm4u_stack_init(limit, top);
+    __set_MSP(top - 40u);
+    use_stack(260u, SIDE_IRQ, false);
+    pend(SIDE_IRQ);
+    __set_MSP(top);
+    cm4u_stack_snapshot(&again);
+    ok = ok && (again.used == 300u);
+
+    const char *dump = getenv("CM4U_STACK_DUMP");
+    if (dump != NULL) {
+        FILE *f = fopen(dump, "wb");
+        if (f != NULL) {
+            ok = ok && (fwrite(&snap, 1u, CM4U_STACK_EXPORT_BYTES, f) == CM4U_STACK_EXPORT_BYTES);
+            fclose(f);
+        }
+    }
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+#include "cm4u_bench.h"
+#include "cm4u_swi.h"
+
+/*
+ * Software-interrupt levels on spare vectors (IRQ40..42).
+ *
+ *   swi.pend_stir         cm4u_nvic_trigger(): one NVIC->STIR store
+ *   swi.pend_ispr         cm4u_nvic_set_pending(): NVIC_SetPendingIRQ()
+ *   swi.post              cm4u_swi_post() into a masked level (queue + pend)
+ *   swi.post_and_run      post, take the level, run an empty item, return
+ *   swi.pendsv_and_run    the same round trip through PendSV, for reference
+ *   swi.ladder_3_levels   Thread posts to the lowest level; each item posts
+ *                         to the next more urgent one, which preempts it
+ */
+
+#define BENCH_LEVELS  3u
+
+static cm4u_swi_t swi[BENCH_LEVELS];
+static const IRQn_Type swi_irq[BENCH_LEVELS] = { (IRQn_Type)40, (IRQn_Type)41, (IRQn_Type)42 };
+static volatile uint32_t work_runs;
+static volatile uint32_t pendsv_runs;
+
+CM4U_SWI_HANDLER(IRQ40_Handler, swi[0])
+CM4U_SWI_HANDLER(IRQ41_Handler, swi[1])
+CM4U_SWI_HANDLER(IRQ42_Handler, swi[2])
+
+void PendSV_Handler(void)
+{
+    pendsv_runs++;
+}
+
+static void empty_work(void *ctx, uint32_t arg)
+{
+    (void)ctx;
+    (void)arg;
+    work_runs++;
+}
+
+/* Level `arg` work: escalate to the next more urgent level */
+static void ladder_work(void *ctx, uint32_t arg)
+{
+    (void)ctx;
+    work_runs++;
+    if (arg > 0u) {
+        (void)cm4u_swi_post(&swi[arg - 1u], ladder_work, 0, arg - 1u);
+    }
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(swi_irq[0], IRQ40_Handler);
+    cm4u_host_set_handler(swi_irq[1], IRQ41_Handler);
+    cm4u_host_set_handler(swi_irq[2], IRQ42_Handler);
+    cm4u_host_set_handler(PendSV_IRQn, PendSV_Handler);
+#endif
+    NVIC_SetPriority(PendSV_IRQn, 5u);
+    cm4u_swi_ladder_init(swi, swi_irq, BENCH_LEVELS, 4u);
+
+    /* Raw pend cost: vector disabled, so nothing is taken */
+    cm4u_nvic_disable_irq(swi_irq[0]);
+    CM4U_BENCH_RUN("swi.pend_stir", {
+        cm4u_nvic_trigger(swi_irq[0]);
+    });
+    CM4U_BENCH_RUN("swi.pend_ispr", {
+        cm4u_nvic_set_pending(swi_irq[0]);
+    });
+    cm4u_nvic_clear_pending(swi_irq[0]);
+
+    /* CM4U_BENCH_ITERS items queue up, then run when the level is enabled */
+    work_runs = 0u;
+    CM4U_BENCH_RUN("swi.post", {
+        (void)cm4u_swi_post(&swi[0], empty_work, 0, 0u);
+    });
+    cm4u_nvic_enable_irq(swi_irq[0]);
+    __DSB();
+    __ISB();
+    bool ok = (work_runs == CM4U_BENCH_ITERS) && (swi[0].dropped == 0u) &&
+              (swi[0].max_depth == CM4U_BENCH_ITERS);
+
+    CM4U_BENCH_RUN("swi.post_and_run", {
+        (void)cm4u_swi_post(&swi[0], empty_work, 0, 0u);
+        __DSB();
+        __ISB();
+    });
+
+    CM4U_BENCH_RUN("swi.pendsv_and_run", {
+        cm4u_trigger_pendsv();
+    });
+
+    work_runs = 0u;
+    CM4U_BENCH_RUN("swi.ladder_3_levels", {
+        (void)cm4u_swi_post(&swi[2], ladder_work, 0, 2u);
+        __DSB();
+        __ISB();
+    });
+
+    ok = ok && (work_runs == BENCH_LEVELS * CM4U_BENCH_ITERS) &&
+         (pendsv_runs == CM4U_BENCH_ITERS) && (cm4u_swi_queued(&swi[0]) == 0u) &&
+         (cm4u_swi_queued(&swi[1]) == 0u) && (cm4u_swi_queued(&swi[2]) == 0u);
+    return ok ? 0 : 1;
+}
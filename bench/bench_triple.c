@@ -0,0 +1,155 @@
+#include "cm4u_bench.h"
+#include "cm4u_triple.h"
+
+/*
+ * Latest-value sharing of a 64-byte sample (IRQ49 = producer ISR).
+ *
+ *   triple.publish        producer swap (the sample is written in place)
+ *   triple.fetch_publish  consumer swap to a new value, then a publish
+ *   triple.fetch_stale    consumer check when nothing new was published
+ *   seqlock.write         sequence++, copy in, sequence++
+ *   seqlock.read          sequence check, copy out, sequence check
+ *   primask.write         copy in with interrupts masked
+ *   primask.read          copy out with interrupts masked
+ *
+ * The seqlock and PRIMASK references copy with cm4u_bench_copy(). PRIMASK
+ * adds its whole copy to every interrupt's latency; the triple buffer and
+ * the seqlock mask nothing, but a seqlock reader retries when the writer
+ * preempts it. The run also checks that the consumer only ever sees whole
+ * samples while the ISR publishes.
+ */
+
+#define ISR_IRQ  ((IRQn_Type)49)
+
+typedef struct {
+    uint32_t seq;
+    uint32_t word[15];
+} sample_t;
+
+static CM4U_TRIPLE(sample_t) tb;
+
+static volatile uint32_t seqlock_seq;
+static sample_t seqlock_value;
+static sample_t primask_value;
+static sample_t local;
+
+static volatile uint32_t isr_seq;
+
+void IRQ49_Handler(void)
+{
+    sample_t *w = CM4U_TRIPLE_WRITE_BUF(&tb);
+    uint32_t s = ++isr_seq;
+    w->seq = s;
+    for (uint32_t i = 0u; i < 15u; i++) {
+        w->word[i] = s;
+    }
+    CM4U_TRIPLE_PUBLISH(&tb);
+}
+
+static void seqlock_write(const sample_t *v)
+{
+    seqlock_seq++;
+    __DMB();
+    cm4u_bench_copy(&seqlock_value, v, sizeof(*v));
+    __DMB();
+    seqlock_seq++;
+}
+
+static uint32_t seqlock_read(sample_t *v)
+{
+    uint32_t s, retries = 0u;
+    for (;;) {
+        s = seqlock_seq;
+        if ((s & 1u) == 0u) {
+            __DMB();
+            cm4u_bench_copy(v, &seqlock_value, sizeof(*v));
+            __DMB();
+            if (seqlock_seq == s) {
+                return retries;
+            }
+        }
+        retries++;
+    }
+}
+
+static void primask_write(const sample_t *v)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    cm4u_bench_copy(&primask_value, v, sizeof(*v));
+    __set_PRIMASK(pm);
+}
+
+static void primask_read(sample_t *v)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    cm4u_bench_copy(v, &primask_value, sizeof(*v));
+    __set_PRIMASK(pm);
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(ISR_IRQ, IRQ49_Handler);
+#endif
+    cm4u_nvic_set_priority(ISR_IRQ, 4u);
+    cm4u_nvic_enable_irq(ISR_IRQ);
+    CM4U_TRIPLE_INIT(&tb);
+
+    CM4U_BENCH_RUN("triple.publish", {
+        CM4U_TRIPLE_PUBLISH(&tb);
+    });
+    uint32_t fresh = 0u;
+    CM4U_BENCH_RUN("triple.fetch_publish", {
+        fresh += CM4U_TRIPLE_FETCH(&tb) ? 1u : 0u;
+        CM4U_TRIPLE_PUBLISH(&tb);
+    });
+    (void)CM4U_TRIPLE_FETCH(&tb);
+    CM4U_BENCH_RUN("triple.fetch_stale", {
+        fresh += CM4U_TRIPLE_FETCH(&tb) ? 1u : 0u;
+    });
+    bool ok = (fresh == CM4U_BENCH_ITERS);
+
+    uint32_t retries = 0u;
+    CM4U_BENCH_RUN("seqlock.write", {
+        seqlock_write(&local);
+    });
+    CM4U_BENCH_RUN("seqlock.read", {
+        retries += seqlock_read(&local);
+    });
+    CM4U_BENCH_RUN("primask.write", {
+        primask_write(&local);
+    });
+    CM4U_BENCH_RUN("primask.read", {
+        primask_read(&local);
+    });
+    uint32_t masked = *cm4u_bench_last();
+    ok = ok && (retries == 0u);
+
+    /* ISR publishes, Thread fetches: whole samples only, never older */
+    uint32_t last = 0u, seen = 0u;
+    for (uint32_t i = 0u; i < 200u; i++) {
+        if ((i % 3u) != 0u) {
+            cm4u_nvic_set_pending(ISR_IRQ);
+            __DSB();
+            __ISB();
+        }
+        if (CM4U_TRIPLE_FETCH(&tb)) {
+            const sample_t *r = CM4U_TRIPLE_READ_BUF(&tb);
+            bool whole = true;
+            for (uint32_t k = 0u; k < 15u; k++) {
+                whole = whole && (r->word[k] == r->seq);
+            }
+            ok = ok && whole && (r->seq > last);
+            last = r->seq;
+            seen++;
+        }
+    }
+    ok = ok && (last == isr_seq) && (seen > 0u) && (__get_PRIMASK() == 0u);
+
+    printf("CM4U_TRIPLE sample_bytes=%lu ram_bytes=%lu primask_masked_cycles=%lu\n",
+           (unsigned long)sizeof(sample_t), (unsigned long)sizeof(tb), (unsigned long)masked);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include "cm4u_bench.h"
+#include "cm4u_wcet.h"
+
+/*
+ * WCET harness (IRQ63 = injected interrupt).
+ *
+ *   wcet.run_empty   one harness run of an empty function (the harness cost)
+ *   wcet.sort_max    worst insertion sort of 8 random halfwords seen in
+ *                    RUNS runs, with all three perturbations drawn
+ *   wcet.sort_mean   its mean
+ *
+ * The run checks the statistics and the block bookkeeping, that replaying
+ * the recorded input reproduces the worst case (exact on the host), and
+ * that an injected handler burning IRQ_BURN cycles is subtracted from the
+ * runs it hits, together with the interrupt round trip: with a fixed input,
+ * runs with and without the IRQ must match (exactly on the host). It prints the tail estimates on a "CM4U_WCET ..." line.
+ */
+
+#define WCET_IRQ  ((IRQn_Type)63)
+#define KEYS      8u
+#define RUNS      2048u
+#define IRQ_BURN  200u
+
+static volatile uint32_t sink;
+
+/* Data-dependent path: one shift per inversion, KEYS * (KEYS - 1) / 2 at worst */
+static void sort_keys(const void *input, uint32_t size, void *ctx)
+{
+    (void)ctx;
+    uint16_t k[KEYS];
+    memcpy(k, input, (size < sizeof(k)) ? size : sizeof(k));
+    for (uint32_t i = 1u; i < KEYS; i++) {
+        uint16_t v = k[i];
+        uint32_t j = i;
+        while ((j > 0u) && (k[j - 1u] > v)) {
+            k[j] = k[j - 1u];
+            j--;
+            __NOP();  /* ticks the host clock */
+        }
+        k[j] = v;
+    }
+    sink = k[0];
+}
+
+static void gen_keys(void *input, uint32_t size, uint32_t *seed, void *ctx)
+{
+    (void)ctx;
+    uint8_t *b = input;
+    for (uint32_t i = 0u; i < size; i++) {
+        b[i] = (uint8_t)cm4u_wcet_rand(seed);
+    }
+}
+
+static void empty(const void *input, uint32_t size, void *ctx)
+{
+    (void)input;
+    (void)size;
+    (void)ctx;
+}
+
+static void burn(void *ctx)
+{
+    (void)ctx;
+    for (uint32_t i = 0u; i < IRQ_BURN; i++) {
+        __NOP();
+    }
+}
+
+void IRQ63_Handler(void)
+{
+    cm4u_wcet_irq_handler();
+}
+
+int main(void)
+{
+    cm4u_bench_init();
+#if defined(CM4U_HOST)
+    cm4u_host_set_handler(WCET_IRQ, IRQ63_Handler);
+#endif
+    cm4u_nvic_set_priority(WCET_IRQ, 2u);
+    cm4u_nvic_enable_irq(WCET_IRQ);
+    (void)cm4u_dwt_init();
+
+    static cm4u_wcet_t w;
+    cm4u_wcet_cfg_t cfg = {
+        .run = empty, .gen = NULL, .size = 4u, .flags = 0u, .seed = 1u, .irq = WCET_IRQ,
+    };
+    cm4u_wcet_init(&w, &cfg);
+    CM4U_BENCH_RUN("wcet.run_empty", {
+        (void)cm4u_wcet_run(&w, &cfg, 1u);
+    });
+
+    /* Input-dependent worst case under all perturbations */
+    cfg.run = sort_keys;
+    cfg.gen = gen_keys;
+    cfg.size = KEYS * 2u;
+    cfg.flags = CM4U_WCET_FLUSH | CM4U_WCET_IRQ | CM4U_WCET_MISALIGN;
+    cfg.irq_fn = burn;
+    cm4u_wcet_init(&w, &cfg);
+    uint32_t worst = cm4u_wcet_run(&w, &cfg, RUNS);
+    uint32_t again = cm4u_wcet_replay(&w, &cfg);
+    uint32_t tail6 = cm4u_wcet_tail(&w, 1e-6f);
+    uint32_t tail9 = cm4u_wcet_tail(&w, 1e-9f);
+    cm4u_bench_report_value("wcet.sort_max", worst, worst, RUNS);
+    cm4u_bench_report_value("wcet.sort_mean", cm4u_wcet_mean(&w), worst, RUNS);
+
+    bool ok = (w.runs == RUNS) && (w.min <= cm4u_wcet_mean(&w)) && (cm4u_wcet_mean(&w) <= worst) &&
+              (w.max_run < RUNS) && (w.blocks >= 8u) && (tail6 >= cm4u_wcet_mean(&w)) && (tail9 >= tail6) &&
+              (w.block_len * w.blocks + w.block_fill == RUNS);
+
+    /* The injected handler is subtracted: fixed input, IRQ in about half the runs */
+    static cm4u_wcet_t quiet;
+    cm4u_wcet_cfg_t irq_cfg = cfg;
+    irq_cfg.gen = NULL;
+    irq_cfg.flags = CM4U_WCET_IRQ;
+    cm4u_wcet_init(&quiet, &irq_cfg);
+    (void)cm4u_wcet_run(&quiet, &irq_cfg, 64u);
+    ok = ok && (quiet.irq_overhead != 0u) && (quiet.max - quiet.min < 8u);
+#if defined(CM4U_HOST)
+    /* Deterministic: the worst input costs the same again, and the IRQ costs nothing */
+    ok = ok && (again == worst) && (worst >= w.min + 10u) && (quiet.max == quiet.min);
+#endif
+
+    printf("CM4U_WCET runs=%lu min=%lu mean=%lu max=%lu replay=%lu run=%lu perturb=0x%lx offset=%lu",
+           (unsigned long)w.runs, (unsigned long)w.min, (unsigned long)cm4u_wcet_mean(&w),
+           (unsigned long)worst, (unsigned long)again, (unsigned long)w.max_run,
+           (unsigned long)w.max_perturb, (unsigned long)w.max_offset);
+    printf(" tail_1e-6=%lu tail_1e-9=%lu blocks=%lu x %lu irq_overhead=%lu\n", (unsigned long)tail6,
+           (unsigned long)tail9, (unsigned long)w.blocks, (unsigned long)w.block_len,
+           (unsigned long)quiet.irq_overhead);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#ifndef CM4U_BENCH_H
+#define CM4U_BENCH_H
+
+/*
+ * Tiny benchmark harness shared by the bench programs (target, QEMU and host).
+ *
+ * Every measurement prints one line that tools/cm4u_qemu_bench.py parses:
+ *
+ *   CM4U_BENCH <name> cycles=<min> max=<max> iters=<n>
+ *
+ * cycles/max are per iteration with the empty-measurement overhead removed.
+ * Timebase is DWT CYCCNT, or a free-running SysTick when the platform has no
+ * DWT (define CM4U_BENCH_TIMER_SYSTICK, e.g. under QEMU).
+ */
+
+#if defined(CM4U_DEVICE_HEADER)
+#include CM4U_DEVICE_HEADER
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "cm4u_core.h"
+
+#ifndef CM4U_BENCH_ITERS
+#define CM4U_BENCH_ITERS 64u
+#endif
+
+#if defined(CM4U_BENCH_SEMIHOSTING)
+extern void initialise_monitor_handles(void);
+#endif
+
+static inline uint32_t cm4u_bench_now(void)
+{
+#if defined(CM4U_BENCH_TIMER_SYSTICK)
+    return SysTick->VAL;
+#else
+    return cm4u_dwt_get_cycles();
+#endif
+}
+
+static inline uint32_t cm4u_bench_elapsed(uint32_t start)
+{
+#if defined(CM4U_BENCH_TIMER_SYSTICK)
+    /* SysTick counts down, 24 bits */
+    return (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk;
+#else
+    return (uint32_t)(cm4u_dwt_get_cycles() - start);
+#endif
+}
+
+/* Target cost of a word-wise copy: LDMIA / STMIA of 4 words per 16 bytes, call and tail */
+#define CM4U_BENCH_COPY_CYCLES(n)  (((n) * 10u) / 16u + 8u)
+
+/*
+ * memcpy() for reference implementations that copy. The host model does
+ * not time memcpy(), so STEP mode charges CM4U_BENCH_COPY_CYCLES instead.
+ */
+static inline void cm4u_bench_copy(void *dst, const void *src, uint32_t n)
+{
+    memcpy(dst, src, n);
+#if defined(CM4U_HOST)
+    if (cm4u_host()->clock_mode == CM4U_HOST_CLOCK_STEP) {
+        cm4u_host_advance_cycles(CM4U_BENCH_COPY_CYCLES(n));
+    }
+#endif
+}
+
+/* Cost of an empty measurement, subtracted from every result */
+static inline uint32_t *cm4u_bench_overhead(void)
+{
+    static uint32_t overhead;
+    return &overhead;
+}
+
+/* Result (min cycles) of the most recent CM4U_BENCH_RUN, for derived metrics */
+static inline uint32_t *cm4u_bench_last(void)
+{
+    static uint32_t last;
+    return &last;
+}
+
+/* Print one result line as-is (derived values, single-shot measurements) */
+static inline void cm4u_bench_report_value(const char *name, uint32_t min, uint32_t max, uint32_t iters)
+{
+    *cm4u_bench_last() = min;
+    printf("CM4U_BENCH %s cycles=%lu max=%lu iters=%lu\n",
+           name, (unsigned long)min, (unsigned long)max, (unsigned long)iters);
+}
+
+/* Print a raw measurement with the timing overhead removed */
+static inline void cm4u_bench_report(const char *name, uint32_t min, uint32_t max, uint32_t iters)
+{
+    uint32_t ovh = *cm4u_bench_overhead();
+    min = (min > ovh) ? (min - ovh) : 0u;
+    max = (max > ovh) ? (max - ovh) : 0u;
+    cm4u_bench_report_value(name, min, max, iters);
+}
+
+/*
+ * Run a statement CM4U_BENCH_ITERS times and report min/max cycles.
+ *
+ * Usage:
+ *   CM4U_BENCH_RUN("critical_pair", {
+ *       uint32_t pm = cm4u_critical_enter();
+ *       cm4u_critical_exit(pm);
+ *   });
+ */
+#define CM4U_BENCH_RUN(name, ...)                                               \
+    do {                                                                        \
+        uint32_t cm4u_bench_min_ = 0xFFFFFFFFu;                                 \
+        uint32_t cm4u_bench_max_ = 0u;                                          \
+        for (uint32_t cm4u_bench_i_ = 0u; cm4u_bench_i_ < CM4U_BENCH_ITERS;     \
+             cm4u_bench_i_++) {                                                 \
+            uint32_t cm4u_bench_t_ = cm4u_bench_now();                          \
+            __VA_ARGS__;                                                        \
+            cm4u_bench_t_ = cm4u_bench_elapsed(cm4u_bench_t_);                  \
+            if (cm4u_bench_t_ < cm4u_bench_min_) cm4u_bench_min_ = cm4u_bench_t_; \
+            if (cm4u_bench_t_ > cm4u_bench_max_) cm4u_bench_max_ = cm4u_bench_t_; \
+        }                                                                       \
+        cm4u_bench_report((name), cm4u_bench_min_, cm4u_bench_max_,             \
+                          CM4U_BENCH_ITERS);                                    \
+    } while (0)
+
+/* Platform bring-up + timebase + overhead calibration; call first in main() */
+static inline void cm4u_bench_init(void)
+{
+#if defined(CM4U_BENCH_SEMIHOSTING)
+    initialise_monitor_handles();
+#endif
+#if defined(CM4U_BENCH_TIMER_SYSTICK)
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL  = 0u;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+#else
+    (void)cm4u_dwt_init();
+#endif
+
+    uint32_t min = 0xFFFFFFFFu;
+    for (uint32_t i = 0u; i < CM4U_BENCH_ITERS; i++) {
+        uint32_t t = cm4u_bench_now();
+        t = cm4u_bench_elapsed(t);
+        if (t < min) min = t;
+    }
+    *cm4u_bench_overhead() = min;
+}
+
+#endif /* CM4U_BENCH_H */
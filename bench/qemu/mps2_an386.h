@@ -0,0 +1,37 @@
+#ifndef CM4U_MPS2_AN386_H
+#define CM4U_MPS2_AN386_H
+
+/*
+ * Minimal device header for QEMU's mps2-an386 (Cortex-M4F) benchmark target.
+ * Only what CMSIS core_cm4.h needs; device IRQs are used as plain numbers.
+ */
+
+typedef enum {
+    NonMaskableInt_IRQn   = -14,
+    HardFault_IRQn        = -13,
+    MemoryManagement_IRQn = -12,
+    BusFault_IRQn         = -11,
+    UsageFault_IRQn       = -10,
+    SVCall_IRQn           = -5,
+    DebugMonitor_IRQn     = -4,
+    PendSV_IRQn           = -2,
+    SysTick_IRQn          = -1,
+    UART0RX_IRQn          = 0,
+    UART0TX_IRQn          = 1
+} IRQn_Type;
+
+/* Number of device vectors provided by startup_mps2.c */
+#define CM4U_MPS2_NUM_IRQS      64U
+
+/* AN386 system clock (QEMU models SysTick at this rate) */
+#define CM4U_MPS2_CORE_HZ       25000000U
+
+#define __CM4_REV               0x0001U
+#define __MPU_PRESENT           1U
+#define __NVIC_PRIO_BITS        3U
+#define __Vendor_SysTickConfig  0U
+#define __FPU_PRESENT           1U
+
+#include "core_cm4.h"
+
+#endif /* CM4U_MPS2_AN386_H */
@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "mps2_an386.h"
+#include "cm4u_boot.h"
+
+/*
+ * Startup for QEMU mps2-an386: vector table, .data/.bss init, FPU enable,
+ * static constructors, main(), then exit() (semihosting SYS_EXIT via rdimon).
+ * Boot phases are stamped when built with CM4U_CFG_BOOT_PROFILE=1.
+ */
+
+extern uint32_t __StackTop;
+extern uint32_t __etext;       /* LMA of .data */
+extern uint32_t __data_start__;
+extern uint32_t __data_end__;
+extern uint32_t __bss_start__;
+extern uint32_t __bss_end__;
+
+extern int  main(void);
+extern void __libc_init_array(void);
+
+void Reset_Handler(void);
+
+void Default_Handler(void)
+{
+    for (;;) {
+    }
+}
+
+#define CM4U_WEAK_HANDLER(name) \
+    void name(void) __attribute__((weak, alias("Default_Handler")))
+
+CM4U_WEAK_HANDLER(NMI_Handler);
+CM4U_WEAK_HANDLER(HardFault_Handler);
+CM4U_WEAK_HANDLER(MemManage_Handler);
+CM4U_WEAK_HANDLER(BusFault_Handler);
+CM4U_WEAK_HANDLER(UsageFault_Handler);
+CM4U_WEAK_HANDLER(SVC_Handler);
+CM4U_WEAK_HANDLER(DebugMon_Handler);
+CM4U_WEAK_HANDLER(PendSV_Handler);
+CM4U_WEAK_HANDLER(SysTick_Handler);
+
+/* Device vectors are generic: IRQ<n>_Handler, n = 0..63 */
+CM4U_WEAK_HANDLER(IRQ0_Handler);
+CM4U_WEAK_HANDLER(IRQ1_Handler);
+CM4U_WEAK_HANDLER(IRQ2_Handler);
+CM4U_WEAK_HANDLER(IRQ3_Handler);
+CM4U_WEAK_HANDLER(IRQ4_Handler);
+CM4U_WEAK_HANDLER(IRQ5_Handler);
+CM4U_WEAK_HANDLER(IRQ6_Handler);
+CM4U_WEAK_HANDLER(IRQ7_Handler);
+CM4U_WEAK_HANDLER(IRQ8_Handler);
+CM4U_WEAK_HANDLER(IRQ9_Handler);
+CM4U_WEAK_HANDLER(IRQ10_Handler);
+CM4U_WEAK_HANDLER(IRQ11_Handler);
+CM4U_WEAK_HANDLER(IRQ12_Handler);
+CM4U_WEAK_HANDLER(IRQ13_Handler);
+CM4U_WEAK_HANDLER(IRQ14_Handler);
+CM4U_WEAK_HANDLER(IRQ15_Handler);
+CM4U_WEAK_HANDLER(IRQ16_Handler);
+CM4U_WEAK_HANDLER(IRQ17_Handler);
+CM4U_WEAK_HANDLER(IRQ18_Handler);
+CM4U_WEAK_HANDLER(IRQ19_Handler);
+CM4U_WEAK_HANDLER(IRQ20_Handler);
+CM4U_WEAK_HANDLER(IRQ21_Handler);
+CM4U_WEAK_HANDLER(IRQ22_Handler);
+CM4U_WEAK_HANDLER(IRQ23_Handler);
+CM4U_WEAK_HANDLER(IRQ24_Handler);
+CM4U_WEAK_HANDLER(IRQ25_Handler);
+CM4U_WEAK_HANDLER(IRQ26_Handler);
+CM4U_WEAK_HANDLER(IRQ27_Handler);
+CM4U_WEAK_HANDLER(IRQ28_Handler);
+CM4U_WEAK_HANDLER(IRQ29_Handler);
+CM4U_WEAK_HANDLER(IRQ30_Handler);
+CM4U_WEAK_HANDLER(IRQ31_Handler);
+CM4U_WEAK_HANDLER(IRQ32_Handler);
+CM4U_WEAK_HANDLER(IRQ33_Handler);
+CM4U_WEAK_HANDLER(IRQ34_Handler);
+CM4U_WEAK_HANDLER(IRQ35_Handler);
+CM4U_WEAK_HANDLER(IRQ36_Handler);
+CM4U_WEAK_HANDLER(IRQ37_Handler);
+CM4U_WEAK_HANDLER(IRQ38_Handler);
+CM4U_WEAK_HANDLER(IRQ39_Handler);
+CM4U_WEAK_HANDLER(IRQ40_Handler);
+CM4U_WEAK_HANDLER(IRQ41_Handler);
+CM4U_WEAK_HANDLER(IRQ42_Handler);
+CM4U_WEAK_HANDLER(IRQ43_Handler);
+CM4U_WEAK_HANDLER(IRQ44_Handler);
+CM4U_WEAK_HANDLER(IRQ45_Handler);
+CM4U_WEAK_HANDLER(IRQ46_Handler);
+CM4U_WEAK_HANDLER(IRQ47_Handler);
+CM4U_WEAK_HANDLER(IRQ48_Handler);
+CM4U_WEAK_HANDLER(IRQ49_Handler);
+CM4U_WEAK_HANDLER(IRQ50_Handler);
+CM4U_WEAK_HANDLER(IRQ51_Handler);
+CM4U_WEAK_HANDLER(IRQ52_Handler);
+CM4U_WEAK_HANDLER(IRQ53_Handler);
+CM4U_WEAK_HANDLER(IRQ54_Handler);
+CM4U_WEAK_HANDLER(IRQ55_Handler);
+CM4U_WEAK_HANDLER(IRQ56_Handler);
+CM4U_WEAK_HANDLER(IRQ57_Handler);
+CM4U_WEAK_HANDLER(IRQ58_Handler);
+CM4U_WEAK_HANDLER(IRQ59_Handler);
+CM4U_WEAK_HANDLER(IRQ60_Handler);
+CM4U_WEAK_HANDLER(IRQ61_Handler);
+CM4U_WEAK_HANDLER(IRQ62_Handler);
+CM4U_WEAK_HANDLER(IRQ63_Handler);
+
+typedef void (*cm4u_vector_t)(void);
+
+__attribute__((section(".isr_vector"), used))
+const cm4u_vector_t __isr_vector[16 + 64] = {
+    (cm4u_vector_t)(uintptr_t)&__StackTop,
+    Reset_Handler,
+    NMI_Handler,
+    HardFault_Handler,
+    MemManage_Handler,
+    BusFault_Handler,
+    UsageFault_Handler,
+    0, 0, 0, 0,
+    SVC_Handler,
+    DebugMon_Handler,
+    0,
+    PendSV_Handler,
+    SysTick_Handler,
+    IRQ0_Handler, IRQ1_Handler, IRQ2_Handler, IRQ3_Handler,
+    IRQ4_Handler, IRQ5_Handler, IRQ6_Handler, IRQ7_Handler,
+    IRQ8_Handler, IRQ9_Handler, IRQ10_Handler, IRQ11_Handler,
+    IRQ12_Handler, IRQ13_Handler, IRQ14_Handler, IRQ15_Handler,
+    IRQ16_Handler, IRQ17_Handler, IRQ18_Handler, IRQ19_Handler,
+    IRQ20_Handler, IRQ21_Handler, IRQ22_Handler, IRQ23_Handler,
+    IRQ24_Handler, IRQ25_Handler, IRQ26_Handler, IRQ27_Handler,
+    IRQ28_Handler, IRQ29_Handler, IRQ30_Handler, IRQ31_Handler,
+    IRQ32_Handler, IRQ33_Handler, IRQ34_Handler, IRQ35_Handler,
+    IRQ36_Handler, IRQ37_Handler, IRQ38_Handler, IRQ39_Handler,
+    IRQ40_Handler, IRQ41_Handler, IRQ42_Handler, IRQ43_Handler,
+    IRQ44_Handler, IRQ45_Handler, IRQ46_Handler, IRQ47_Handler,
+    IRQ48_Handler, IRQ49_Handler, IRQ50_Handler, IRQ51_Handler,
+    IRQ52_Handler, IRQ53_Handler, IRQ54_Handler, IRQ55_Handler,
+    IRQ56_Handler, IRQ57_Handler, IRQ58_Handler, IRQ59_Handler,
+    IRQ60_Handler, IRQ61_Handler, IRQ62_Handler, IRQ63_Handler,
+};
+
+void Reset_Handler(void)
+{
+    CM4U_BOOT_START();
+
+    /* Enable CP10/CP11 before any FP instruction (hard-float ABI) */
+    SCB->CPACR |= (0xFu << 20);
+    __DSB();
+    __ISB();
+    CM4U_BOOT_MARK("fpu");
+
+    cm4u_boot_copy(&__data_start__, &__data_end__, &__etext);
+    CM4U_BOOT_MARK("data");
+    cm4u_boot_zero(&__bss_start__, &__bss_end__);
+    CM4U_BOOT_MARK("bss");
+    cm4u_boot_fast_init();
+    CM4U_BOOT_MARK("fast");
+
+    __libc_init_array();
+    CM4U_BOOT_MARK("ctors");
+    exit(main());
+}
+
+/* newlib's crt0 is not linked (-nostartfiles); it expects these */
+void _init(void) {}
+void _fini(void) {}
@@ -0,0 +1,35 @@
+#if defined(CM4U_DEVICE_HEADER)
+#include CM4U_DEVICE_HEADER
+#endif
+#include "cm4u_core.h"
+
+/*
+ * Size probe: touches every configurable cm4u feature once, so building it
+ * under several cm4u_config.h settings shows what each feature costs in
+ * flash and RAM (cmake --build <dir> --target size_report).
+ */
+
+static cm4u_trace_t probe_trace;
+static volatile uint32_t probe_sink;
+
+#if (CM4U_CFG_ASSERT_LEVEL == CM4U_ASSERT_REPORT)
+void cm4u_assert_failed(const char *file, int line)
+{
+    (void)file;
+    probe_sink = (uint32_t)line;
+}
+#endif
+
+int main(void)
+{
+    (void)cm4u_dwt_init();
+
+    uint32_t start = cm4u_profile_cycles_start();
+    uint32_t mask = cm4u_critical_enter();
+    cm4u_trace_mark(&probe_trace, 1u);
+    cm4u_critical_exit(mask);
+    probe_sink = cm4u_profile_cycles_end(start);
+
+    CM4U_ASSERT(probe_sink < 0x80000000u);
+    return 0;
+}
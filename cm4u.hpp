@@ -0,0 +1,239 @@
+#ifndef CM4U_HPP
+#define CM4U_HPP
+
+/*
+ * C++17 layer over cm4u_core.h.
+ *
+ *   - RAII guards for critical sections and BASEPRI
+ *   - scoped profile timers
+ *   - strongly typed Cycles / Micros / Millis durations
+ *   - Clock<CoreHz>: conversions done at compile time for a fixed core clock
+ *
+ * Everything is inline and forwards to the C API, so it compiles to the same
+ * instructions as the hand-written C (see bench/bench_cpp.cpp and the
+ * zero_overhead_report build target).
+ */
+
+#include <stdint.h>
+#include "cm4u_core.h"
+
+namespace cm4u {
+
+/* --------------------------------------------------------------------------
+ *  Typed durations
+ * -------------------------------------------------------------------------- */
+
+class Cycles {
+public:
+    constexpr explicit Cycles(uint32_t count) : count_(count) {}
+    constexpr uint32_t count() const { return count_; }
+
+    constexpr Cycles operator+(Cycles o) const { return Cycles(count_ + o.count_); }
+    constexpr Cycles operator-(Cycles o) const { return Cycles(count_ - o.count_); }
+    constexpr bool operator==(Cycles o) const { return count_ == o.count_; }
+    constexpr bool operator!=(Cycles o) const { return count_ != o.count_; }
+    constexpr bool operator<(Cycles o) const { return count_ < o.count_; }
+    constexpr bool operator>(Cycles o) const { return count_ > o.count_; }
+    constexpr bool operator<=(Cycles o) const { return count_ <= o.count_; }
+    constexpr bool operator>=(Cycles o) const { return count_ >= o.count_; }
+
+private:
+    uint32_t count_;
+};
+
+class Micros {
+public:
+    constexpr explicit Micros(uint32_t count) : count_(count) {}
+    constexpr uint32_t count() const { return count_; }
+
+    constexpr Micros operator+(Micros o) const { return Micros(count_ + o.count_); }
+    constexpr bool operator==(Micros o) const { return count_ == o.count_; }
+    constexpr bool operator<(Micros o) const { return count_ < o.count_; }
+
+private:
+    uint32_t count_;
+};
+
+class Millis {
+public:
+    constexpr explicit Millis(uint32_t count) : count_(count) {}
+    constexpr uint32_t count() const { return count_; }
+
+    constexpr Millis operator+(Millis o) const { return Millis(count_ + o.count_); }
+    constexpr bool operator==(Millis o) const { return count_ == o.count_; }
+    constexpr bool operator<(Millis o) const { return count_ < o.count_; }
+
+private:
+    uint32_t count_;
+};
+
+namespace literals {
+constexpr Cycles operator""_cyc(unsigned long long v) { return Cycles(static_cast<uint32_t>(v)); }
+constexpr Micros operator""_us(unsigned long long v) { return Micros(static_cast<uint32_t>(v)); }
+constexpr Millis operator""_ms(unsigned long long v) { return Millis(static_cast<uint32_t>(v)); }
+} // namespace literals
+
+/* Runtime conversions (variable core clock), same math as the C API */
+inline Cycles to_cycles(Micros us, uint32_t core_clock_hz)
+{
+    return Cycles(cm4u_us_to_cycles(us.count(), core_clock_hz));
+}
+
+inline Cycles to_cycles(Millis ms, uint32_t core_clock_hz)
+{
+    return Cycles(cm4u_ms_to_cycles(ms.count(), core_clock_hz));
+}
+
+/* --------------------------------------------------------------------------
+ *  Compile-time core clock
+ * -------------------------------------------------------------------------- */
+
+/*
+ * Fixed core clock known at build time; every conversion is a constant.
+ *
+ * Usage:
+ *   using SysClock = cm4u::Clock<168000000u>;
+ *   SysClock::delay(10_us);                        // no runtime multiply/divide
+ *   constexpr auto c = SysClock::to_cycles(5_us);  // Cycles(840)
+ */
+template <uint32_t CoreHz>
+struct Clock {
+    static_assert(CoreHz > 0u, "core clock must be non-zero");
+
+    static constexpr uint32_t hz = CoreHz;
+
+    /* Would a delay of `us` / `ms` overflow 32-bit cycles at this clock? */
+    static constexpr bool fits(Micros us)
+    {
+        return ((static_cast<uint64_t>(CoreHz) * us.count()) / 1000000u) <= 0xFFFFFFFFu;
+    }
+
+    static constexpr bool fits(Millis ms)
+    {
+        return ((static_cast<uint64_t>(CoreHz) * ms.count()) / 1000u) <= 0xFFFFFFFFu;
+    }
+
+    static constexpr Cycles to_cycles(Micros us)
+    {
+        return Cycles(static_cast<uint32_t>((static_cast<uint64_t>(CoreHz) * us.count()) / 1000000u));
+    }
+
+    static constexpr Cycles to_cycles(Millis ms)
+    {
+        return Cycles(static_cast<uint32_t>((static_cast<uint64_t>(CoreHz) * ms.count()) / 1000u));
+    }
+
+    static constexpr Micros to_micros(Cycles c)
+    {
+        return Micros(static_cast<uint32_t>((static_cast<uint64_t>(c.count()) * 1000000u) / CoreHz));
+    }
+
+    /* Busy-wait (requires cm4u_dwt_init); inline callers get a constant count */
+    static inline void delay(Micros us) { cm4u_delay_cycles(to_cycles(us).count()); }
+    static inline void delay(Millis ms) { cm4u_delay_cycles(to_cycles(ms).count()); }
+
+    /* Constant delays: the count is an immediate and overflow is a compile error */
+    template <uint32_t Us>
+    static inline void delay_us()
+    {
+        static_assert(fits(Micros(Us)), "cm4u: delay overflows 32-bit cycles");
+        constexpr Cycles cycles = to_cycles(Micros(Us));
+        cm4u_delay_cycles(cycles.count());
+    }
+
+    template <uint32_t Ms>
+    static inline void delay_ms()
+    {
+        static_assert(fits(Millis(Ms)), "cm4u: delay overflows 32-bit cycles");
+        constexpr Cycles cycles = to_cycles(Millis(Ms));
+        cm4u_delay_cycles(cycles.count());
+    }
+
+    /* Elapsed time since a cm4u_profile_cycles_start() / cm4u_dwt_get_cycles() stamp */
+    static inline Micros since(uint32_t start_cycles)
+    {
+        return to_micros(Cycles(cm4u_profile_cycles_end(start_cycles)));
+    }
+};
+
+#if (CM4U_CFG_CORE_CLOCK_HZ != 0)
+/* The build-time clock from cm4u_config.h */
+using SystemClock = Clock<static_cast<uint32_t>(CM4U_CFG_CORE_CLOCK_HZ)>;
+#endif
+
+/* --------------------------------------------------------------------------
+ *  RAII guards
+ * -------------------------------------------------------------------------- */
+
+/* cm4u_critical_enter() in the constructor, cm4u_critical_exit() in the destructor */
+class CriticalSection {
+public:
+    CriticalSection() : saved_(cm4u_critical_enter()) {}
+    ~CriticalSection() { cm4u_critical_exit(saved_); }
+
+    CriticalSection(const CriticalSection &) = delete;
+    CriticalSection &operator=(const CriticalSection &) = delete;
+
+private:
+    uint32_t saved_;
+};
+
+/* Raise BASEPRI for the scope (never lowers it), restore the old value on exit */
+class BasepriGuard {
+public:
+    explicit BasepriGuard(uint32_t basepri) : saved_(cm4u_get_basepri())
+    {
+        cm4u_raise_basepri(basepri);
+    }
+    ~BasepriGuard() { cm4u_set_basepri(saved_); }
+
+    BasepriGuard(const BasepriGuard &) = delete;
+    BasepriGuard &operator=(const BasepriGuard &) = delete;
+
+private:
+    uint32_t saved_;
+};
+
+/*
+ * Measure the enclosing scope into `out` (cm4u_profile_cycles_start/end).
+ *
+ * Usage:
+ *   cm4u::Cycles spent{0};
+ *   { cm4u::ScopedProfile p(spent); work(); }
+ */
+class ScopedProfile {
+public:
+    explicit ScopedProfile(Cycles &out) : out_(out), start_(cm4u_profile_cycles_start()) {}
+    ~ScopedProfile() { out_ = Cycles(cm4u_profile_cycles_end(start_)); }
+
+    ScopedProfile(const ScopedProfile &) = delete;
+    ScopedProfile &operator=(const ScopedProfile &) = delete;
+
+private:
+    Cycles  &out_;
+    uint32_t start_;
+};
+
+/* Like ScopedProfile, but keeps the worst case seen in `max` */
+class ScopedMaxProfile {
+public:
+    explicit ScopedMaxProfile(Cycles &max) : max_(max), start_(cm4u_profile_cycles_start()) {}
+    ~ScopedMaxProfile()
+    {
+        Cycles spent(cm4u_profile_cycles_end(start_));
+        if (spent > max_) {
+            max_ = spent;
+        }
+    }
+
+    ScopedMaxProfile(const ScopedMaxProfile &) = delete;
+    ScopedMaxProfile &operator=(const ScopedMaxProfile &) = delete;
+
+private:
+    Cycles  &max_;
+    uint32_t start_;
+};
+
+} // namespace cm4u
+
+#endif /* CM4U_HPP */
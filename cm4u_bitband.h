@@ -0,0 +1,198 @@
+#ifndef CM4U_BITBAND_H
+#define CM4U_BITBAND_H
+
+/*
+ * Bit-band access for the Cortex-M4 SRAM and peripheral regions.
+ *
+ * Each bit of the first 1 MB of SRAM (0x20000000) and of the peripherals
+ * (0x40000000) has a 32-bit alias word (0x22000000 / 0x42000000). Writing
+ * 0 or 1 to that alias clears or sets just that bit. It is one store: the
+ * bus does the read-modify-write, so there is no LDREX loop and no
+ * cm4u_critical_enter(). Reading the alias returns the bit.
+ *
+ *   CM4U_BB_SET(&flags, 3);                     // alias computed, then one STR
+ *   CM4U_BB_PERIPH_WRITE(&GPIOA->ODR, 5, 1u);   // literal address: one STR
+ *
+ *   cm4u_bb_t rdy = cm4u_bb(&status, 7u);       // runtime address
+ *   cm4u_bb_write(rdy, 1u);
+ *
+ *   static uint32_t ev_words[CM4U_BB_FLAG_WORDS(64)];
+ *   cm4u_bb_flags_t ev;
+ *   cm4u_bb_flags_init(&ev, ev_words, 64u);
+ *   cm4u_bb_flag_set(&ev, 17u);                 // from any ISR
+ *
+ * Only integer-literal addresses (peripheral registers) fold into a
+ * constant alias. ELF/ARM has no relocation for (sym - base) * 32, so for a
+ * variable the compiler computes the alias at run time: a literal load, a
+ * shift and an add. On hot paths compute it once with cm4u_bb() and keep
+ * the cm4u_bb_t.
+ *
+ * Only memory in those two 1 MB windows is bit-bandable. CCM RAM
+ * (CM4U_FAST_DATA on STM32F4) is not. The host backend emulates the alias
+ * mapping on ordinary memory (see cm4u_host_bitband_write()).
+ */
+
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Address translation
+ * -------------------------------------------------------------------------- */
+
+#if defined(CM4U_HOST)
+/* Host emulation: base 0, unbounded window (alias = addr * 32 + bit * 4) */
+#define CM4U_BB_SRAM_BASE     ((uintptr_t)0u)
+#define CM4U_BB_SRAM_ALIAS    ((uintptr_t)0u)
+#define CM4U_BB_PERIPH_BASE   ((uintptr_t)0u)
+#define CM4U_BB_PERIPH_ALIAS  ((uintptr_t)0u)
+#else
+#define CM4U_BB_SRAM_BASE     ((uintptr_t)0x20000000u)
+#define CM4U_BB_SRAM_ALIAS    ((uintptr_t)0x22000000u)
+#define CM4U_BB_PERIPH_BASE   ((uintptr_t)0x40000000u)
+#define CM4U_BB_PERIPH_ALIAS  ((uintptr_t)0x42000000u)
+#endif
+#define CM4U_BB_REGION_SIZE   0x100000u
+
+/* Alias address of bit `bit` (0..31) of the word / byte at `addr` */
+#define CM4U_BITBAND_SRAM(addr, bit)                                            \
+    (CM4U_BB_SRAM_ALIAS + (((uintptr_t)(addr) - CM4U_BB_SRAM_BASE) << 5) +      \
+     ((uintptr_t)(bit) << 2))
+#define CM4U_BITBAND_PERIPH(addr, bit)                                          \
+    (CM4U_BB_PERIPH_ALIAS + (((uintptr_t)(addr) - CM4U_BB_PERIPH_BASE) << 5) +  \
+     ((uintptr_t)(bit) << 2))
+
+/* An alias address, as produced by the macros above or cm4u_bb() */
+typedef uintptr_t cm4u_bb_t;
+
+/* Is `addr` inside one of the bit-band windows? */
+static inline bool cm4u_bb_capable(const volatile void *addr)
+{
+#if defined(CM4U_HOST)
+    (void)addr;
+    return true;
+#else
+    uintptr_t a = (uintptr_t)addr;
+    return ((a - CM4U_BB_SRAM_BASE) < CM4U_BB_REGION_SIZE) ||
+           ((a - CM4U_BB_PERIPH_BASE) < CM4U_BB_REGION_SIZE);
+#endif
+}
+
+/* Alias of bit `bit` of the word at `addr`, picking the SRAM or peripheral window */
+static inline cm4u_bb_t cm4u_bb(const volatile void *addr, uint32_t bit)
+{
+    CM4U_ASSERT(cm4u_bb_capable(addr) && (bit < 32u));
+#if defined(CM4U_HOST)
+    return CM4U_BITBAND_SRAM(addr, bit);
+#else
+    return ((uintptr_t)addr >= CM4U_BB_PERIPH_BASE) ? CM4U_BITBAND_PERIPH(addr, bit)
+                                                    : CM4U_BITBAND_SRAM(addr, bit);
+#endif
+}
+
+/* --------------------------------------------------------------------------
+ *  Alias access
+ * -------------------------------------------------------------------------- */
+
+static inline void cm4u_bb_write(cm4u_bb_t alias, uint32_t value)
+{
+#if defined(CM4U_HOST)
+    cm4u_host_bitband_write(alias, value);
+#else
+    *(volatile uint32_t *)alias = value;
+#endif
+}
+
+static inline uint32_t cm4u_bb_read(cm4u_bb_t alias)
+{
+#if defined(CM4U_HOST)
+    return cm4u_host_bitband_read(alias);
+#else
+    return *(volatile const uint32_t *)alias;
+#endif
+}
+
+static inline void cm4u_bb_set(cm4u_bb_t alias)
+{
+    cm4u_bb_write(alias, 1u);
+}
+
+static inline void cm4u_bb_clear(cm4u_bb_t alias)
+{
+    cm4u_bb_write(alias, 0u);
+}
+
+/* Literal address and constant bit: one STR / LDR; a variable's alias is computed first */
+#define CM4U_BB_SRAM_WRITE(addr, bit, v)    cm4u_bb_write(CM4U_BITBAND_SRAM((addr), (bit)), (v))
+#define CM4U_BB_PERIPH_WRITE(addr, bit, v)  cm4u_bb_write(CM4U_BITBAND_PERIPH((addr), (bit)), (v))
+#define CM4U_BB_SRAM_READ(addr, bit)        cm4u_bb_read(CM4U_BITBAND_SRAM((addr), (bit)))
+#define CM4U_BB_PERIPH_READ(addr, bit)      cm4u_bb_read(CM4U_BITBAND_PERIPH((addr), (bit)))
+#define CM4U_BB_SET(addr, bit)              CM4U_BB_SRAM_WRITE((addr), (bit), 1u)
+#define CM4U_BB_CLEAR(addr, bit)            CM4U_BB_SRAM_WRITE((addr), (bit), 0u)
+
+/* --------------------------------------------------------------------------
+ *  Flag arrays
+ * -------------------------------------------------------------------------- */
+
+/* Backing words for `nbits` flags (place in the SRAM bit-band window) */
+#define CM4U_BB_FLAG_WORDS(nbits)  (((nbits) + 31u) / 32u)
+
+/*
+ * Flags over a word array. Flag i lives at alias + 4 * i, so set and clear
+ * are one store each from any context, with no shift or mask at run time.
+ * Scans read the backing words directly.
+ */
+typedef struct {
+    cm4u_bb_t alias;   /* alias of bit 0 of words[0] */
+    uint32_t *words;
+    uint32_t  nbits;
+} cm4u_bb_flags_t;
+
+static inline void cm4u_bb_flags_init(cm4u_bb_flags_t *f, uint32_t *words, uint32_t nbits)
+{
+    f->alias = cm4u_bb(words, 0u);
+    f->words = words;
+    f->nbits = nbits;
+    for (uint32_t i = 0u; i < CM4U_BB_FLAG_WORDS(nbits); i++) {
+        words[i] = 0u;
+    }
+}
+
+static inline void cm4u_bb_flag_set(const cm4u_bb_flags_t *f, uint32_t i)
+{
+    CM4U_ASSERT(i < f->nbits);
+    cm4u_bb_write(f->alias + ((uintptr_t)i << 2), 1u);
+}
+
+static inline void cm4u_bb_flag_clear(const cm4u_bb_flags_t *f, uint32_t i)
+{
+    CM4U_ASSERT(i < f->nbits);
+    cm4u_bb_write(f->alias + ((uintptr_t)i << 2), 0u);
+}
+
+static inline bool cm4u_bb_flag_get(const cm4u_bb_flags_t *f, uint32_t i)
+{
+    CM4U_ASSERT(i < f->nbits);
+    return cm4u_bb_read(f->alias + ((uintptr_t)i << 2)) != 0u;
+}
+
+/* Lowest set flag, or f->nbits if none (snapshot; flags may change meanwhile) */
+static inline uint32_t cm4u_bb_flags_first(const cm4u_bb_flags_t *f)
+{
+    for (uint32_t w = 0u; w < CM4U_BB_FLAG_WORDS(f->nbits); w++) {
+        uint32_t v = ((volatile const uint32_t *)f->words)[w];
+        if (v != 0u) {
+            uint32_t i = (w << 5) + (uint32_t)__CLZ(__RBIT(v));
+            return (i < f->nbits) ? i : f->nbits;
+        }
+    }
+    return f->nbits;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_BITBAND_H */
@@ -0,0 +1,289 @@
+#ifndef CM4U_BOOT_H
+#define CM4U_BOOT_H
+
+/*
+ * Boot-time profiler and startup memory init.
+ *
+ * CM4U_BOOT_START() is meant to be the first statement of Reset_Handler: it
+ * starts the cycle counter and stamps "reset". Each CM4U_BOOT_MARK("name")
+ * afterwards closes the phase called `name`, from the previous marker to
+ * now. The records live in .noinit (CM4U_NOINIT), so the .data copy and
+ * .bss zeroing they time do not wipe them.
+ *
+ *   void Reset_Handler(void)
+ *   {
+ *       CM4U_BOOT_START();
+ *       cm4u_boot_copy(&__data_start__, &__data_end__, &__etext);
+ *       CM4U_BOOT_MARK("data");
+ *       cm4u_boot_zero(&__bss_start__, &__bss_end__);
+ *       CM4U_BOOT_MARK("bss");
+ *       SystemInit();
+ *       CM4U_BOOT_MARK("clock");
+ *       __libc_init_array();
+ *       CM4U_BOOT_MARK("ctors");
+ *       main();
+ *   }
+ *
+ * Later, cm4u_boot_phases() returns the phases sorted longest first, with
+ * each phase's share of the total in per mille.
+ *
+ * With CM4U_CFG_BOOT_PROFILE = 0 the markers compile to nothing. The copy and
+ * zero routines, and cm4u_boot_fast_init() for the CM4U_FAST_* sections, are
+ * always available. They move 32 bytes per loop as LDM/STM bursts and need no
+ * stack data, globals or libc, so they are safe before .data exists.
+ *
+ * Timebase is DWT CYCCNT, or a free-running SysTick with
+ * CM4U_BOOT_TIMER_SYSTICK (24 bits: boots longer than 2^24 cycles wrap).
+ */
+
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Startup memory init
+ * -------------------------------------------------------------------------- */
+
+/* Copy [dst, dst_end) from src, word aligned (the .data load image) */
+static inline void cm4u_boot_copy(uint32_t *dst, uint32_t *dst_end, const uint32_t *src)
+{
+    uint32_t n = (uint32_t)((uintptr_t)dst_end - (uintptr_t)dst);
+#if defined(__ARM_ARCH) && !defined(CM4U_HOST)
+    /* 32 bytes per iteration; leaves n = remaining bytes (< 32) */
+    __asm volatile (
+        "   subs  %[n], %[n], #32\n"
+        "   blo   2f\n"
+        "1: ldmia %[s]!, {r3, r4, r5, r6}\n"
+        "   stmia %[d]!, {r3, r4, r5, r6}\n"
+        "   ldmia %[s]!, {r3, r4, r5, r6}\n"
+        "   stmia %[d]!, {r3, r4, r5, r6}\n"
+        "   subs  %[n], %[n], #32\n"
+        "   bhs   1b\n"
+        "2: adds  %[n], %[n], #32\n"
+        : [d] "+r" (dst), [s] "+r" (src), [n] "+r" (n)
+        :
+        : "r3", "r4", "r5", "r6", "cc", "memory");
+#else
+    for (; n >= 16u; n -= 16u) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = src[3];
+        dst += 4;
+        src += 4;
+    }
+#endif
+    for (; n >= 4u; n -= 4u) {
+        *dst++ = *src++;
+    }
+}
+
+/* Zero [dst, dst_end), word aligned (.bss) */
+static inline void cm4u_boot_zero(uint32_t *dst, uint32_t *dst_end)
+{
+    uint32_t n = (uint32_t)((uintptr_t)dst_end - (uintptr_t)dst);
+#if defined(__ARM_ARCH) && !defined(CM4U_HOST)
+    __asm volatile (
+        "   movs  r3, #0\n"
+        "   movs  r4, #0\n"
+        "   movs  r5, #0\n"
+        "   movs  r6, #0\n"
+        "   subs  %[n], %[n], #32\n"
+        "   blo   2f\n"
+        "1: stmia %[d]!, {r3, r4, r5, r6}\n"
+        "   stmia %[d]!, {r3, r4, r5, r6}\n"
+        "   subs  %[n], %[n], #32\n"
+        "   bhs   1b\n"
+        "2: adds  %[n], %[n], #32\n"
+        : [d] "+r" (dst), [n] "+r" (n)
+        :
+        : "r3", "r4", "r5", "r6", "cc", "memory");
+#else
+    for (; n >= 16u; n -= 16u) {
+        dst[0] = 0u;
+        dst[1] = 0u;
+        dst[2] = 0u;
+        dst[3] = 0u;
+        dst += 4;
+    }
+#endif
+    for (; n >= 4u; n -= 4u) {
+        *dst++ = 0u;
+    }
+}
+
+#if !defined(CM4U_HOST)
+/* From ld/cm4u_placement.ld */
+extern uint32_t __cm4u_ramfunc_start__[], __cm4u_ramfunc_end__[], __cm4u_ramfunc_load__[];
+extern uint32_t __cm4u_fastdata_start__[], __cm4u_fastdata_end__[], __cm4u_fastdata_load__[];
+extern uint32_t __cm4u_fastbss_start__[], __cm4u_fastbss_end__[];
+#endif
+
+/*
+ * Load CM4U_FAST_CODE / CM4U_FAST_DATA and zero CM4U_FAST_BSS; call from
+ * Reset_Handler next to the .data / .bss init (needs ld/cm4u_placement.ld).
+ * No-op on the host, where the attributes place nothing.
+ */
+static inline void cm4u_boot_fast_init(void)
+{
+#if !defined(CM4U_HOST)
+    cm4u_boot_copy(__cm4u_ramfunc_start__, __cm4u_ramfunc_end__, __cm4u_ramfunc_load__);
+    cm4u_boot_copy(__cm4u_fastdata_start__, __cm4u_fastdata_end__, __cm4u_fastdata_load__);
+    cm4u_boot_zero(__cm4u_fastbss_start__, __cm4u_fastbss_end__);
+    /* Code was written through the D-bus: finish it before fetching from it */
+    __DSB();
+    __ISB();
+#endif
+}
+
+/* --------------------------------------------------------------------------
+ *  Boot profiler (CM4U_CFG_BOOT_PROFILE)
+ * -------------------------------------------------------------------------- */
+
+#ifndef CM4U_BOOT_NOW
+#if defined(CM4U_BOOT_TIMER_SYSTICK)
+#define CM4U_BOOT_NOW()  (SysTick_LOAD_RELOAD_Msk - SysTick->VAL)
+#else
+#define CM4U_BOOT_NOW()  cm4u_dwt_get_cycles()
+#endif
+#endif
+
+typedef struct {
+    const char *name;    /* phase that ends here (string literal, in flash) */
+    uint32_t    cycles;  /* timestamp since CM4U_BOOT_START() */
+} cm4u_boot_mark_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t dropped;    /* markers past CM4U_CFG_BOOT_MARKS */
+    cm4u_boot_mark_t mark[CM4U_CFG_BOOT_MARKS];
+} cm4u_boot_prof_t;
+
+/* One phase of the report */
+typedef struct {
+    const char *name;
+    uint32_t    cycles;
+    uint32_t    permille;  /* share of cm4u_boot_total() */
+} cm4u_boot_phase_t;
+
+#if CM4U_CFG_BOOT_PROFILE
+
+__attribute__((weak)) cm4u_boot_prof_t cm4u_boot_prof CM4U_NOINIT;
+
+/* Start the timebase and stamp "reset"; first thing in Reset_Handler */
+static inline void cm4u_boot_start(void)
+{
+#if defined(CM4U_BOOT_TIMER_SYSTICK)
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL  = 0u;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+#else
+    (void)cm4u_dwt_init();
+#endif
+    cm4u_boot_prof.dropped        = 0u;
+    cm4u_boot_prof.mark[0].name   = "reset";
+    cm4u_boot_prof.mark[0].cycles = CM4U_BOOT_NOW();
+    cm4u_boot_prof.count          = 1u;
+}
+
+/* Close phase `name`; Thread mode, single-threaded boot code only */
+static inline void cm4u_boot_mark(const char *name)
+{
+    uint32_t now = CM4U_BOOT_NOW();
+    uint32_t i = cm4u_boot_prof.count;
+    if (i < CM4U_CFG_BOOT_MARKS) {
+        cm4u_boot_prof.mark[i].name   = name;
+        cm4u_boot_prof.mark[i].cycles = now;
+        cm4u_boot_prof.count = i + 1u;
+    } else {
+        cm4u_boot_prof.dropped++;
+    }
+}
+
+#define CM4U_BOOT_START()      cm4u_boot_start()
+#define CM4U_BOOT_MARK(name)   cm4u_boot_mark(name)
+
+/* Cycles from CM4U_BOOT_START() to the last marker */
+static inline uint32_t cm4u_boot_total(void)
+{
+    uint32_t n = cm4u_boot_prof.count;
+    if ((n < 2u) || (n > CM4U_CFG_BOOT_MARKS)) {
+        return 0u;
+    }
+    return cm4u_boot_prof.mark[n - 1u].cycles - cm4u_boot_prof.mark[0].cycles;
+}
+
+/*
+ * Fill `out` with the `max` longest phases (or all of them if fewer),
+ * longest first; returns how many.
+ *
+ * Usage:
+ *   cm4u_boot_phase_t p[CM4U_CFG_BOOT_MARKS];
+ *   uint32_t n = cm4u_boot_phases(p, CM4U_CFG_BOOT_MARKS);
+ *   for (uint32_t i = 0; i < n; i++)
+ *       printf("%-12s %8lu  %3lu.%lu%%\n", p[i].name, p[i].cycles,
+ *              p[i].permille / 10, p[i].permille % 10);
+ */
+static inline uint32_t cm4u_boot_phases(cm4u_boot_phase_t *out, uint32_t max)
+{
+    uint32_t n = cm4u_boot_prof.count;
+    uint32_t total = cm4u_boot_total();
+    uint32_t used = 0u;
+
+    if ((n < 2u) || (n > CM4U_CFG_BOOT_MARKS)) {
+        return 0u;  /* never started, or .noinit garbage */
+    }
+    if (max == 0u) {
+        return 0u;
+    }
+    for (uint32_t i = 1u; i < n; i++) {
+        cm4u_boot_phase_t p;
+        p.name     = cm4u_boot_prof.mark[i].name;
+        p.cycles   = cm4u_boot_prof.mark[i].cycles - cm4u_boot_prof.mark[i - 1u].cycles;
+        p.permille = (total != 0u) ? (uint32_t)(((uint64_t)p.cycles * 1000u) / total) : 0u;
+
+        /* insertion sort, descending by cycles; when full, the shortest drops out */
+        uint32_t j = used;
+        if (used == max) {
+            if (out[max - 1u].cycles >= p.cycles) {
+                continue;
+            }
+            j = max - 1u;
+        } else {
+            used++;
+        }
+        while ((j > 0u) && (out[j - 1u].cycles < p.cycles)) {
+            out[j] = out[j - 1u];
+            j--;
+        }
+        out[j] = p;
+    }
+    return used;
+}
+
+#else /* !CM4U_CFG_BOOT_PROFILE */
+
+#define CM4U_BOOT_START()      ((void)0)
+#define CM4U_BOOT_MARK(name)   ((void)0)
+
+static inline uint32_t cm4u_boot_total(void)
+{
+    return 0u;
+}
+
+static inline uint32_t cm4u_boot_phases(cm4u_boot_phase_t *out, uint32_t max)
+{
+    (void)out;
+    (void)max;
+    return 0u;
+}
+
+#endif /* CM4U_CFG_BOOT_PROFILE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_BOOT_H */
@@ -0,0 +1,253 @@
+#ifndef CM4U_BUS_H
+#define CM4U_BUS_H
+
+/*
+ * Static publish / subscribe event bus.
+ *
+ * Topics and subscribers are fixed at link time. Each subscription is a
+ * const record in the linker section "cm4u_sub_<topic>". The linker
+ * gathers the records of a topic into one array and defines
+ * __start_ / __stop_ symbols around it. So publishing walks exactly that
+ * topic's subscribers: no lookup, no registration code, no RAM per
+ * subscriber.
+ *
+ *   CM4U_TOPIC_DEFINE(adc_ready);                          // one .c file
+ *   CM4U_TOPIC_DECLARE(adc_ready);                         // users
+ *
+ *   CM4U_SUBSCRIBE(adc_ready, filter_sample, 0, CM4U_BUS_NOW);   // in the ISR
+ *   CM4U_SUBSCRIBE(adc_ready, log_sample, 0, 2u);                // PendSV, level 2
+ *
+ *   void ADC_IRQHandler(void) { cm4u_bus_publish(&adc_ready, ADC1->DR); }
+ *   CM4U_BUS_HANDLER(PendSV_Handler)
+ *
+ * Subscribers at CM4U_BUS_NOW run inside cm4u_bus_publish(), in the
+ * publisher's context. The others are queued on their level (1 = most
+ * urgent, up to CM4U_CFG_BUS_LEVELS) and PendSV delivers them, lowest
+ * level first, once no other exception is active. Queues are lock-free
+ * (LDREX/STREX reservation, as in cm4u_swi_post()), so any ISR may
+ * publish.
+ *
+ * Per-topic statistics: publish count and first / last CYCCNT stamp
+ * (average rate), shortest gap between publishes (peak rate), longest
+ * publish (immediate subscribers included), and publish-to-delivery
+ * latency of deferred subscribers. When a topic is published from
+ * several priorities, only `published` and `dropped` are exact. Stamps
+ * need CYCCNT running (cm4u_dwt_init()).
+ *
+ * The sections are orphans: leave them out of custom linker scripts, or
+ * the __start_ / __stop_ symbols are not defined. CM4U_TOPIC_DEFINE_TABLE()
+ * builds a topic from a plain const array instead.
+ */
+
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Subscriber callback: `data` is the published word */
+typedef void (*cm4u_bus_fn_t)(void *ctx, uint32_t data);
+
+/* Subscriber level: run inside cm4u_bus_publish() */
+#define CM4U_BUS_NOW  0u
+
+typedef struct cm4u_sub cm4u_sub_t;
+
+typedef struct {
+    const cm4u_sub_t *begin;
+    const cm4u_sub_t *end;
+
+    /* Statistics (cycles are CYCCNT) */
+    volatile uint32_t published;
+    volatile uint32_t dropped;        /* deferred deliveries lost: level queue full */
+    uint32_t          first_publish;
+    uint32_t          last_publish;
+    uint32_t          min_interval;   /* shortest gap between two publishes */
+    uint32_t          max_publish;    /* longest cm4u_bus_publish() */
+    uint32_t          delivered;      /* deferred deliveries made */
+    uint32_t          latency_max;    /* publish -> deferred subscriber called */
+    uint64_t          latency_sum;
+} cm4u_topic_t;
+
+struct cm4u_sub {
+    cm4u_topic_t  *topic;
+    cm4u_bus_fn_t  fn;
+    void          *ctx;
+    uint32_t       level;  /* CM4U_BUS_NOW or 1..CM4U_CFG_BUS_LEVELS */
+};
+
+#define CM4U_TOPIC__STATS  0u, 0u, 0u, 0u, 0xFFFFFFFFu, 0u, 0u, 0u, 0u
+
+#define CM4U_TOPIC_DECLARE(topic)  extern cm4u_topic_t topic
+
+/* Define a topic whose subscribers are the CM4U_SUBSCRIBE() records */
+#define CM4U_TOPIC_DEFINE(topic)                                                  \
+    extern const cm4u_sub_t __start_cm4u_sub_##topic[] __attribute__((weak));     \
+    extern const cm4u_sub_t __stop_cm4u_sub_##topic[] __attribute__((weak));      \
+    cm4u_topic_t topic = { __start_cm4u_sub_##topic, __stop_cm4u_sub_##topic,      \
+                           CM4U_TOPIC__STATS }
+
+/* Define a topic over a const cm4u_sub_t array (no linker sections) */
+#define CM4U_TOPIC_DEFINE_TABLE(topic, subs)                                      \
+    cm4u_topic_t topic = { (subs), (subs) + (sizeof(subs) / sizeof((subs)[0])),    \
+                           CM4U_TOPIC__STATS }
+
+/* Subscribe fn(ctx, data) to `topic` (declared or defined above) at `level` */
+#define CM4U_SUBSCRIBE(topic, fn, ctx, level)                                     \
+    static const cm4u_sub_t cm4u_sub__##topic##__##fn                              \
+        __attribute__((section("cm4u_sub_" #topic), used, aligned(sizeof(void *)))) = \
+        { &(topic), (fn), (ctx), (level) }
+
+/* --------------------------------------------------------------------------
+ *  Deferred queues (one per level, drained by PendSV)
+ * -------------------------------------------------------------------------- */
+
+typedef struct {
+    const cm4u_sub_t *volatile sub;  /* 0 = reserved, not written yet */
+    volatile uint32_t          data;
+    volatile uint32_t          stamp;
+} cm4u_bus_item_t;
+
+typedef struct {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    cm4u_bus_item_t   item[CM4U_CFG_BUS_DEPTH];
+} cm4u_bus_level_t;
+
+__attribute__((weak)) cm4u_bus_level_t cm4u_bus_level[CM4U_CFG_BUS_LEVELS];
+
+static inline bool cm4u_bus__defer(const cm4u_sub_t *s, uint32_t data, uint32_t stamp)
+{
+    cm4u_bus_level_t *q = &cm4u_bus_level[s->level - 1u];
+    uint32_t head;
+
+    CM4U_ASSERT(s->level <= CM4U_CFG_BUS_LEVELS);
+    if (!cm4u_ring_reserve(&q->head, &q->tail, CM4U_CFG_BUS_DEPTH, 1u, &s->topic->dropped, &head)) {
+        return false;
+    }
+
+    cm4u_bus_item_t *it = &q->item[head & (CM4U_CFG_BUS_DEPTH - 1u)];
+    it->data = data;
+    it->stamp = stamp;
+    __DMB();
+    it->sub = s;  /* publish */
+    return true;
+}
+
+/* --------------------------------------------------------------------------
+ *  API
+ * -------------------------------------------------------------------------- */
+
+/* Deliver `data` to every subscriber of `t` (any context) */
+static inline void cm4u_bus_publish(cm4u_topic_t *t, uint32_t data)
+{
+    uint32_t now = cm4u_dwt_get_cycles();
+    bool pend = false;
+
+    if (cm4u_atomic_inc(&t->published) == 1u) {
+        t->first_publish = now;
+    } else if ((now - t->last_publish) < t->min_interval) {
+        t->min_interval = now - t->last_publish;
+    }
+    t->last_publish = now;
+
+    for (const cm4u_sub_t *s = t->begin; s != t->end; s++) {
+        if (s->level == CM4U_BUS_NOW) {
+            s->fn(s->ctx, data);
+        } else {
+            pend = cm4u_bus__defer(s, data, now) || pend;
+        }
+    }
+    if (pend) {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    }
+
+    uint32_t took = cm4u_dwt_get_cycles() - now;
+    if (took > t->max_publish) {
+        t->max_publish = took;
+    }
+}
+
+/*
+ * Deliver every queued deferred event, most urgent level first. Call it
+ * (only) from PendSV. Stops at a slot a preempted publisher has reserved
+ * but not yet written; that publisher pends PendSV again once it has.
+ */
+static inline void cm4u_bus_run(void)
+{
+    uint32_t l = 0u;
+
+    while (l < CM4U_CFG_BUS_LEVELS) {
+        cm4u_bus_level_t *q = &cm4u_bus_level[l];
+        uint32_t tail = q->tail;
+        cm4u_bus_item_t *it = &q->item[tail & (CM4U_CFG_BUS_DEPTH - 1u)];
+        const cm4u_sub_t *s = (tail != q->head) ? it->sub : 0;
+        if (s == 0) {
+            l++;
+            continue;
+        }
+        uint32_t data = it->data;
+        uint32_t stamp = it->stamp;
+        it->sub = 0;
+        __DMB();
+        q->tail = tail + 1u;
+
+        cm4u_topic_t *t = s->topic;
+        uint32_t latency = cm4u_dwt_get_cycles() - stamp;
+        t->delivered++;
+        t->latency_sum += latency;
+        if (latency > t->latency_max) {
+            t->latency_max = latency;
+        }
+        s->fn(s->ctx, data);
+        l = 0u;  /* the subscriber may have queued more urgent work */
+    }
+}
+
+/* Define the PendSV handler: CM4U_BUS_HANDLER(PendSV_Handler) */
+#define CM4U_BUS_HANDLER(handler)  \
+    void handler(void)             \
+    {                              \
+        cm4u_bus_run();            \
+    }
+
+static inline uint32_t cm4u_topic_subscribers(const cm4u_topic_t *t)
+{
+    return (uint32_t)(t->end - t->begin);
+}
+
+/* Average publish rate in Hz over the stamps seen so far (0 = too few) */
+static inline uint32_t cm4u_topic_rate_hz(const cm4u_topic_t *t, uint32_t core_hz)
+{
+    uint32_t span = t->last_publish - t->first_publish;
+    if ((t->published < 2u) || (span == 0u)) {
+        return 0u;
+    }
+    return (uint32_t)(((uint64_t)(t->published - 1u) * core_hz) / span);
+}
+
+/* Mean publish -> deferred delivery latency in cycles */
+static inline uint32_t cm4u_topic_latency_avg(const cm4u_topic_t *t)
+{
+    return (t->delivered == 0u) ? 0u : (uint32_t)(t->latency_sum / t->delivered);
+}
+
+/* Start a new statistics window (CYCCNT wraps every 2^32 cycles) */
+static inline void cm4u_topic_reset_stats(cm4u_topic_t *t)
+{
+    t->published = 0u;
+    t->dropped = 0u;
+    t->first_publish = 0u;
+    t->last_publish = 0u;
+    t->min_interval = 0xFFFFFFFFu;
+    t->max_publish = 0u;
+    t->delivered = 0u;
+    t->latency_max = 0u;
+    t->latency_sum = 0u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_BUS_H */
@@ -0,0 +1,236 @@
+#ifndef CM4U_CONFIG_H
+#define CM4U_CONFIG_H
+
+/*
+ * cm4u compile-time configuration.
+ *
+ * Every option can be overridden with -D on the command line, or by pointing
+ * CM4U_USER_CONFIG at your own header:  -DCM4U_USER_CONFIG='"my_cm4u_cfg.h"'
+ * Disabled features compile to nothing (empty inline functions / macros).
+ */
+
+#if defined(CM4U_USER_CONFIG)
+#include CM4U_USER_CONFIG
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Core clock
+ * -------------------------------------------------------------------------- */
+
+/*
+ * Build-time core clock in Hz. Non-zero enables CM4U_DELAY_US() & co, whose
+ * conversions fold to constants; 0 = clock only known at runtime (pass
+ * core_clock_hz to cm4u_delay_us() etc. as before).
+ */
+#ifndef CM4U_CFG_CORE_CLOCK_HZ
+#define CM4U_CFG_CORE_CLOCK_HZ 0
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Profiling
+ * -------------------------------------------------------------------------- */
+
+/* 1 = cm4u_profile_* measure with DWT CYCCNT, 0 = they return 0 and vanish */
+#ifndef CM4U_CFG_PROFILING
+#define CM4U_CFG_PROFILING 1
+#endif
+
+/* Entries in a cm4u_trace_t ring (power of two), 0 = tracing compiled out */
+#ifndef CM4U_CFG_TRACE_DEPTH
+#define CM4U_CFG_TRACE_DEPTH 0
+#endif
+
+/* 1 = CM4U_BOOT_MARK() records boot phases (cm4u_boot.h), 0 = markers vanish */
+#ifndef CM4U_CFG_BOOT_PROFILE
+#define CM4U_CFG_BOOT_PROFILE 0
+#endif
+
+/* Boot markers kept, including the reset stamp; later ones are counted as dropped */
+#ifndef CM4U_CFG_BOOT_MARKS
+#define CM4U_CFG_BOOT_MARKS 16
+#endif
+
+/* Exceptions tracked by the cm4u_preempt.h matrix (Thread included), 0 = compiled out */
+#ifndef CM4U_CFG_PREEMPT_SLOTS
+#define CM4U_CFG_PREEMPT_SLOTS 0
+#endif
+
+/* Handlers tracked by the cm4u_stack.h MSP estimator, 0 = compiled out */
+#ifndef CM4U_CFG_STACK_SLOTS
+#define CM4U_CFG_STACK_SLOTS 0
+#endif
+
+/* Bytes painted below each instrumented handler's SP to measure its use */
+#ifndef CM4U_CFG_STACK_WINDOW
+#define CM4U_CFG_STACK_WINDOW 256
+#endif
+
+/* Largest input a cm4u_wcet.h run keeps a copy of (the worst one) */
+#ifndef CM4U_CFG_WCET_INPUT_BYTES
+#define CM4U_CFG_WCET_INPUT_BYTES 64
+#endif
+
+/* Block maxima kept for the cm4u_wcet.h tail estimate (even); full = blocks merge in pairs */
+#ifndef CM4U_CFG_WCET_BLOCKS
+#define CM4U_CFG_WCET_BLOCKS 64
+#endif
+
+/* Runs per block to start with */
+#ifndef CM4U_CFG_WCET_BLOCK
+#define CM4U_CFG_WCET_BLOCK 16
+#endif
+
+/* Flash ACR address (STM32F2/F4/F7 layout) whose ART cache and prefetch a WCET run resets, 0 = none */
+#ifndef CM4U_CFG_WCET_FLASH_ACR
+#define CM4U_CFG_WCET_FLASH_ACR 0
+#endif
+
+/* Words in the cm4u_log.h ring (power of two), 0 = CM4U_LOG() compiled out */
+#ifndef CM4U_CFG_LOG_WORDS
+#define CM4U_CFG_LOG_WORDS 0
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Software interrupts, tasks, fibers and messages
+ * -------------------------------------------------------------------------- */
+
+/* Work items queued per software-interrupt level (power of two) */
+#ifndef CM4U_CFG_SWI_DEPTH
+#define CM4U_CFG_SWI_DEPTH 16
+#endif
+
+/* 1 = pend levels with a single NVIC->STIR store, 0 = NVIC_SetPendingIRQ() */
+#ifndef CM4U_CFG_SWI_STIR
+#define CM4U_CFG_SWI_STIR 1
+#endif
+
+/* Events queued per cm4u_kernel.h task (power of two) */
+#ifndef CM4U_CFG_TASK_EVENTS
+#define CM4U_CFG_TASK_EVENTS 8
+#endif
+
+/*
+ * 1 = cm4u_fiber.h switches also save / restore S16-S31 (needed whenever
+ * the compiler may keep values in FPU registers); follows the build's FPU
+ * use by default
+ */
+#ifndef CM4U_CFG_FIBER_FPU
+#if defined(__ARM_FP) && defined(__thumb__)  /* not an AArch64 host */
+#define CM4U_CFG_FIBER_FPU 1
+#else
+#define CM4U_CFG_FIBER_FPU 0
+#endif
+#endif
+
+/* 1 = cm4u_msg.h tracks buffer ownership and checksums sent payloads (use-after-send) */
+#ifndef CM4U_CFG_MSG_DEBUG
+#define CM4U_CFG_MSG_DEBUG 0
+#endif
+
+/* Deferred delivery levels of cm4u_bus.h (PendSV runs level 1 first) */
+#ifndef CM4U_CFG_BUS_LEVELS
+#define CM4U_CFG_BUS_LEVELS 4
+#endif
+
+/* Deferred deliveries queued per level (power of two) */
+#ifndef CM4U_CFG_BUS_DEPTH
+#define CM4U_CFG_BUS_DEPTH 16
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Asserts
+ * -------------------------------------------------------------------------- */
+
+#define CM4U_ASSERT_OFF     0  /* CM4U_ASSERT() expands to nothing */
+#define CM4U_ASSERT_TRAP    1  /* BKPT / trap on failure, no strings in flash */
+#define CM4U_ASSERT_REPORT  2  /* call cm4u_assert_failed(file, line) */
+
+#ifndef CM4U_CFG_ASSERT_LEVEL
+#define CM4U_CFG_ASSERT_LEVEL CM4U_ASSERT_TRAP
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Critical sections
+ * -------------------------------------------------------------------------- */
+
+#define CM4U_CRITICAL_PRIMASK 0  /* mask everything but NMI / HardFault */
+#define CM4U_CRITICAL_BASEPRI 1  /* mask only priorities >= CM4U_CFG_CRITICAL_BASEPRI */
+
+#ifndef CM4U_CFG_CRITICAL_MODE
+#define CM4U_CFG_CRITICAL_MODE CM4U_CRITICAL_PRIMASK
+#endif
+
+/* Raw 8-bit BASEPRI value used in BASEPRI mode (e.g. 0x20 = priority 2 of 4 bits) */
+#ifndef CM4U_CFG_CRITICAL_BASEPRI
+#define CM4U_CFG_CRITICAL_BASEPRI 0x20u
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Sanity checks
+ * -------------------------------------------------------------------------- */
+
+#if (CM4U_CFG_CORE_CLOCK_HZ != 0) && ((CM4U_CFG_CORE_CLOCK_HZ % 1000) != 0)
+#error "CM4U_CFG_CORE_CLOCK_HZ must be a whole number of kHz"
+#endif
+
+#if (CM4U_CFG_TRACE_DEPTH & (CM4U_CFG_TRACE_DEPTH - 1)) != 0
+#error "CM4U_CFG_TRACE_DEPTH must be 0 or a power of two"
+#endif
+
+#if (CM4U_CFG_LOG_WORDS & (CM4U_CFG_LOG_WORDS - 1)) != 0
+#error "CM4U_CFG_LOG_WORDS must be 0 or a power of two"
+#endif
+
+#if (CM4U_CFG_PREEMPT_SLOTS == 1) || (CM4U_CFG_PREEMPT_SLOTS > 255)
+#error "CM4U_CFG_PREEMPT_SLOTS must be 0 or 2..255"
+#endif
+
+#if (CM4U_CFG_STACK_WINDOW < 16) || ((CM4U_CFG_STACK_WINDOW % 4) != 0)
+#error "CM4U_CFG_STACK_WINDOW must be a multiple of 4, at least 16"
+#endif
+
+#if (CM4U_CFG_WCET_INPUT_BYTES < 1)
+#error "CM4U_CFG_WCET_INPUT_BYTES must be at least 1"
+#endif
+
+#if (CM4U_CFG_WCET_BLOCKS < 8) || ((CM4U_CFG_WCET_BLOCKS % 2) != 0)
+#error "CM4U_CFG_WCET_BLOCKS must be even, at least 8"
+#endif
+
+#if (CM4U_CFG_WCET_BLOCK < 1)
+#error "CM4U_CFG_WCET_BLOCK must be at least 1"
+#endif
+
+#if (CM4U_CFG_SWI_DEPTH < 2) || ((CM4U_CFG_SWI_DEPTH & (CM4U_CFG_SWI_DEPTH - 1)) != 0)
+#error "CM4U_CFG_SWI_DEPTH must be a power of two, at least 2"
+#endif
+
+#if (CM4U_CFG_TASK_EVENTS < 2) || ((CM4U_CFG_TASK_EVENTS & (CM4U_CFG_TASK_EVENTS - 1)) != 0)
+#error "CM4U_CFG_TASK_EVENTS must be a power of two, at least 2"
+#endif
+
+#if (CM4U_CFG_BUS_LEVELS < 1) || (CM4U_CFG_BUS_LEVELS > 255)
+#error "CM4U_CFG_BUS_LEVELS must be 1..255"
+#endif
+
+#if (CM4U_CFG_BUS_DEPTH < 2) || ((CM4U_CFG_BUS_DEPTH & (CM4U_CFG_BUS_DEPTH - 1)) != 0)
+#error "CM4U_CFG_BUS_DEPTH must be a power of two, at least 2"
+#endif
+
+#if (CM4U_CFG_BOOT_PROFILE != 0) && (CM4U_CFG_BOOT_MARKS < 2)
+#error "CM4U_CFG_BOOT_MARKS must be at least 2 (reset stamp + one phase)"
+#endif
+
+#if (CM4U_CFG_ASSERT_LEVEL < CM4U_ASSERT_OFF) || (CM4U_CFG_ASSERT_LEVEL > CM4U_ASSERT_REPORT)
+#error "CM4U_CFG_ASSERT_LEVEL must be 0, 1 or 2"
+#endif
+
+#if (CM4U_CFG_CRITICAL_MODE != CM4U_CRITICAL_PRIMASK) && (CM4U_CFG_CRITICAL_MODE != CM4U_CRITICAL_BASEPRI)
+#error "CM4U_CFG_CRITICAL_MODE must be CM4U_CRITICAL_PRIMASK or CM4U_CRITICAL_BASEPRI"
+#endif
+
+#if (CM4U_CFG_CRITICAL_MODE == CM4U_CRITICAL_BASEPRI) && ((CM4U_CFG_CRITICAL_BASEPRI) == 0)
+#error "BASEPRI critical sections need a non-zero CM4U_CFG_CRITICAL_BASEPRI"
+#endif
+
+#endif /* CM4U_CONFIG_H */
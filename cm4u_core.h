@@ -8,10 +8,14 @@
  * Requires:
  *   - CMSIS-Core for Cortex-M4 (core_cm4.h)
  *   - Your device header should be included before this, or make sure core_cm4.h is available.
+ *
+ * Host builds: put host/ on the include path instead of CMSIS and the same
+ * code runs on Linux against simulated core registers (see host/core_cm4.h).
  */
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "cm4u_config.h"
 #include "core_cm4.h"
 
 #ifdef __cplusplus
@@ -27,6 +31,76 @@ typedef enum {
     CM4U_MODE_HANDLER = 1
 } cm4u_mode_t;
 
+/* --------------------------------------------------------------------------
+ *  Memory placement
+ * -------------------------------------------------------------------------- */
+
+/*
+ * Section attributes for the regions a Cortex-M4 part typically has; the
+ * output sections come from ld/cm4u_placement.ld, and cm4u_boot_fast_init()
+ * loads them at startup.
+ *
+ *   CM4U_FAST_CODE  function runs from RAM (SRAM, or CCM where it is on the
+ *                   I-bus): no flash wait states. Called with a long call.
+ *   CM4U_FAST_DATA  initialised data in zero-wait RAM (CCM), copied at boot
+ *   CM4U_FAST_BSS   zero-initialised data in zero-wait RAM (CCM)
+ *   CM4U_DMA_DATA   zero-initialised buffer in main SRAM, which DMA can
+ *                   reach (CCM cannot); lands in .bss with any linker script
+ *   CM4U_NOINIT     neither loaded nor zeroed by the startup code, so the
+ *                   contents survive a warm reset (NOLOAD .noinit section)
+ *
+ * Usage:
+ *   CM4U_FAST_CODE void ADC_IRQHandler(void) { ... }
+ *   static int16_t taps[64] CM4U_FAST_DATA = { ... };
+ *   static uint8_t rx_buf[512] CM4U_DMA_DATA;
+ */
+#if defined(CM4U_HOST)
+#define CM4U_FAST_CODE  __attribute__((noinline))
+#define CM4U_FAST_DATA
+#define CM4U_FAST_BSS
+#define CM4U_DMA_DATA   __attribute__((aligned(4)))
+#ifndef CM4U_NOINIT
+#define CM4U_NOINIT
+#endif
+#else
+#define CM4U_FAST_CODE  __attribute__((section(".ramfunc"), noinline, long_call))
+#define CM4U_FAST_DATA  __attribute__((section(".fastdata")))
+#define CM4U_FAST_BSS   __attribute__((section(".fastbss")))
+#define CM4U_DMA_DATA   __attribute__((section(".bss.cm4u_dma"), aligned(4)))
+#ifndef CM4U_NOINIT
+#define CM4U_NOINIT     __attribute__((section(".noinit")))
+#endif
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Asserts (CM4U_CFG_ASSERT_LEVEL)
+ * -------------------------------------------------------------------------- */
+
+#if (CM4U_CFG_ASSERT_LEVEL == CM4U_ASSERT_REPORT)
+/* Provided by the application; may log, then reset or halt */
+void cm4u_assert_failed(const char *file, int line);
+#define CM4U_ASSERT(expr) \
+    do { if (!(expr)) { cm4u_assert_failed(__FILE__, __LINE__); } } while (0)
+#elif (CM4U_CFG_ASSERT_LEVEL == CM4U_ASSERT_TRAP)
+#define CM4U_ASSERT(expr) \
+    do { if (!(expr)) { __BKPT(0); } } while (0)
+#else
+#define CM4U_ASSERT(expr) do { (void)sizeof(expr); } while (0)
+#endif
+
+/* Compile-time check usable at block or file scope */
+#if defined(__cplusplus)
+#define CM4U_STATIC_ASSERT(expr, msg) static_assert((expr), msg)
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define CM4U_STATIC_ASSERT(expr, msg) _Static_assert((expr), msg)
+#else
+#define CM4U_STATIC_ASSERT(expr, msg) \
+    CM4U_STATIC_ASSERT_(expr, __LINE__)
+#define CM4U_STATIC_ASSERT_(expr, line)  CM4U_STATIC_ASSERT__(expr, line)
+#define CM4U_STATIC_ASSERT__(expr, line) \
+    typedef char cm4u_static_assert_##line[(expr) ? 1 : -1]
+#endif
+
 /* --------------------------------------------------------------------------
  *  Core mode / exception helpers
  * -------------------------------------------------------------------------- */
@@ -71,18 +145,32 @@ static inline void cm4u_global_irq_enable(void)
     __enable_irq();
 }
 
-/* Enter critical section: returns previous PRIMASK value, then disables IRQs */
+/*
+ * Enter critical section: returns the previous mask state, then masks IRQs.
+ * PRIMASK mode (default) masks everything; BASEPRI mode (CM4U_CFG_CRITICAL_MODE)
+ * only raises BASEPRI to CM4U_CFG_CRITICAL_BASEPRI, so higher priorities still run.
+ */
 static inline uint32_t cm4u_critical_enter(void)
 {
+#if (CM4U_CFG_CRITICAL_MODE == CM4U_CRITICAL_BASEPRI)
+    uint32_t basepri = __get_BASEPRI();
+    __set_BASEPRI_MAX(CM4U_CFG_CRITICAL_BASEPRI);
+    return basepri;
+#else
     uint32_t primask = __get_PRIMASK();
     __disable_irq();
     return primask;
+#endif
 }
 
-/* Exit critical section: restore previous PRIMASK */
+/* Exit critical section: restore the mask state returned by cm4u_critical_enter */
 static inline void cm4u_critical_exit(uint32_t primask)
 {
+#if (CM4U_CFG_CRITICAL_MODE == CM4U_CRITICAL_BASEPRI)
+    __set_BASEPRI(primask);
+#else
     __set_PRIMASK(primask);
+#endif
 }
 
 /* Get / set PRIMASK (global IRQ mask) */
@@ -107,6 +195,12 @@ static inline void cm4u_set_basepri(uint32_t basepri)
     __set_BASEPRI(basepri);
 }
 
+/* Raise BASEPRI only (BASEPRI_MAX: ignored if it would lower the mask) */
+static inline void cm4u_raise_basepri(uint32_t basepri)
+{
+    __set_BASEPRI_MAX(basepri);
+}
+
 /* Get / set FAULTMASK (mask all except NMI and HardFault) */
 static inline uint32_t cm4u_get_faultmask(void)
 {
@@ -168,6 +262,46 @@ static inline void cm4u_isb(void) { __ISB(); }
 
 static inline void cm4u_nop(void) { __NOP(); }
 
+/* --------------------------------------------------------------------------
+ *  LDREX / STREX counters & ring reservation (any context, no masking)
+ * -------------------------------------------------------------------------- */
+
+/* *counter += 1; returns the new value */
+static inline uint32_t cm4u_atomic_inc(volatile uint32_t *counter)
+{
+    uint32_t c;
+    do {
+        c = __LDREXW(counter) + 1u;
+    } while (__STREXW(c, counter) != 0u);
+    return c;
+}
+
+/*
+ * Reserve `n` entries of a `depth`-entry ring with free-running head / tail
+ * indices: advances *head by `n` and returns its old value in *slot. If that
+ * would put more than `depth` entries between *tail and the head, nothing is
+ * reserved, *dropped (when given) is counted and false returned. The caller
+ * fills the entries and publishes them; the consumer must stop at a slot
+ * that is reserved but not yet published.
+ */
+static inline bool cm4u_ring_reserve(volatile uint32_t *head, const volatile uint32_t *tail, uint32_t depth,
+                                     uint32_t n, volatile uint32_t *dropped, uint32_t *slot)
+{
+    uint32_t h;
+    do {
+        h = __LDREXW(head);
+        if ((h + n - *tail) > depth) {
+            __CLREX();
+            if (dropped != 0) {
+                (void)cm4u_atomic_inc(dropped);
+            }
+            return false;
+        }
+    } while (__STREXW(h + n, head) != 0u);
+    *slot = h;
+    return true;
+}
+
 /* --------------------------------------------------------------------------
  *  System control (SCB / SYSTICK / PendSV / SVC)
  * -------------------------------------------------------------------------- */
@@ -192,7 +326,9 @@ static inline void cm4u_trigger_pendsv(void)
  */
 static inline void cm4u_trigger_svc(uint8_t imm8)
 {
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(CM4U_HOST)
+    cm4u_host_svc(imm8); /* host backend: host/core_cm4.h */
+#elif defined(__GNUC__) || defined(__clang__)
     __asm volatile ("svc %0" :: "I"(imm8) : "memory");
 #elif defined(__CC_ARM) || defined(__ARMCC_VERSION)
     __svc(imm8)();
@@ -291,6 +427,78 @@ static inline void cm4u_delay_ms(uint32_t ms, uint32_t core_clock_hz)
     cm4u_delay_cycles(cycles);
 }
 
+/* --------------------------------------------------------------------------
+ *  Fixed core clock (CM4U_CFG_CORE_CLOCK_HZ != 0)
+ * -------------------------------------------------------------------------- */
+
+#if (CM4U_CFG_CORE_CLOCK_HZ != 0)
+
+/*
+ * Constant-expression conversions for the build-time clock. With a literal
+ * argument these are immediates; use them in initialisers and case labels too.
+ */
+#define CM4U_US_TO_CYCLES(us) \
+    ((uint32_t)(((uint64_t)(CM4U_CFG_CORE_CLOCK_HZ) * (uint64_t)(us)) / 1000000u))
+#define CM4U_MS_TO_CYCLES(ms) \
+    ((uint32_t)(((uint64_t)(CM4U_CFG_CORE_CLOCK_HZ) * (uint64_t)(ms)) / 1000u))
+
+/* Does a delay of `us` / `ms` fit in 32-bit cycles at the build-time clock? */
+#define CM4U_US_FITS_CYCLES(us) \
+    ((((uint64_t)(CM4U_CFG_CORE_CLOCK_HZ) * (uint64_t)(us)) / 1000000u) <= 0xFFFFFFFFu)
+#define CM4U_MS_FITS_CYCLES(ms) \
+    ((((uint64_t)(CM4U_CFG_CORE_CLOCK_HZ) * (uint64_t)(ms)) / 1000u) <= 0xFFFFFFFFu)
+
+/*
+ * Delay by a compile-time constant: the cycle count is an immediate, and a
+ * delay that would overflow 32-bit cycles fails to compile.
+ *
+ * Usage:
+ *   CM4U_DELAY_US(10);
+ */
+#define CM4U_DELAY_US(us)                                                      \
+    do {                                                                       \
+        CM4U_STATIC_ASSERT(CM4U_US_FITS_CYCLES(us),                            \
+                           "cm4u: delay overflows 32-bit cycles");             \
+        cm4u_delay_cycles(CM4U_US_TO_CYCLES(us));                              \
+    } while (0)
+
+#define CM4U_DELAY_MS(ms)                                                      \
+    do {                                                                       \
+        CM4U_STATIC_ASSERT(CM4U_MS_FITS_CYCLES(ms),                            \
+                           "cm4u: delay overflows 32-bit cycles");             \
+        cm4u_delay_cycles(CM4U_MS_TO_CYCLES(ms));                              \
+    } while (0)
+
+/*
+ * Variable `us` at the build-time clock. Whole-MHz clocks need one 32-bit
+ * multiply; other clocks fall back to 64-bit math by a constant divisor.
+ */
+static inline uint32_t cm4u_us_to_cycles_fixed(uint32_t us)
+{
+#if ((CM4U_CFG_CORE_CLOCK_HZ % 1000000u) == 0u)
+    return us * (uint32_t)(CM4U_CFG_CORE_CLOCK_HZ / 1000000u);
+#else
+    return CM4U_US_TO_CYCLES(us);
+#endif
+}
+
+static inline uint32_t cm4u_ms_to_cycles_fixed(uint32_t ms)
+{
+    return ms * (uint32_t)(CM4U_CFG_CORE_CLOCK_HZ / 1000u);
+}
+
+static inline void cm4u_delay_us_fixed(uint32_t us)
+{
+    cm4u_delay_cycles(cm4u_us_to_cycles_fixed(us));
+}
+
+static inline void cm4u_delay_ms_fixed(uint32_t ms)
+{
+    cm4u_delay_cycles(cm4u_ms_to_cycles_fixed(ms));
+}
+
+#endif /* CM4U_CFG_CORE_CLOCK_HZ */
+
 /* --------------------------------------------------------------------------
  *  Simple NVIC helpers
  * -------------------------------------------------------------------------- */
@@ -322,6 +530,16 @@ static inline void cm4u_nvic_clear_pending(IRQn_Type irqn)
     NVIC_ClearPendingIRQ(irqn);
 }
 
+/*
+ * Pend an IRQ with a single NVIC->STIR store (no index / mask arithmetic).
+ * Unprivileged code needs SCB->CCR.USERSETMPEND. Like any pend, it takes
+ * effect a few cycles later; follow with __DSB()/__ISB() to wait for it.
+ */
+static inline void cm4u_nvic_trigger(IRQn_Type irqn)
+{
+    NVIC->STIR = (uint32_t)irqn;
+}
+
 /* --------------------------------------------------------------------------
  *  Small profiling helper
  * -------------------------------------------------------------------------- */
@@ -333,16 +551,69 @@ static inline void cm4u_nvic_clear_pending(IRQn_Type irqn)
  *   uint32_t cycles = cm4u_profile_cycles_start();
  *   // ... code ...
  *   cycles = cm4u_profile_cycles_end(cycles);
+ *
+ * With CM4U_CFG_PROFILING = 0 both return 0 and generate no code.
  */
 static inline uint32_t cm4u_profile_cycles_start(void)
 {
+#if CM4U_CFG_PROFILING
     return cm4u_dwt_get_cycles();
+#else
+    return 0u;
+#endif
 }
 
 static inline uint32_t cm4u_profile_cycles_end(uint32_t start_cycles)
 {
+#if CM4U_CFG_PROFILING
     uint32_t now = cm4u_dwt_get_cycles();
     return (uint32_t)(now - start_cycles);
+#else
+    (void)start_cycles;
+    return 0u;
+#endif
+}
+
+/* --------------------------------------------------------------------------
+ *  Tiny event trace (CM4U_CFG_TRACE_DEPTH entries, 0 = compiled out)
+ * -------------------------------------------------------------------------- */
+
+typedef struct {
+    uint32_t cycles;  /* CYCCNT at the mark */
+    uint32_t id;      /* user event id */
+} cm4u_trace_entry_t;
+
+/*
+ * Ring of the last CM4U_CFG_TRACE_DEPTH marks; place one wherever you like.
+ *
+ * Usage:
+ *   static cm4u_trace_t trace;
+ *   cm4u_trace_mark(&trace, 42u);
+ *   // inspect trace.entry[] / trace.head in the debugger
+ */
+typedef struct {
+#if (CM4U_CFG_TRACE_DEPTH > 0)
+    volatile uint32_t  head;   /* total marks written; slot = head % depth */
+    cm4u_trace_entry_t entry[CM4U_CFG_TRACE_DEPTH];
+#else
+    uint8_t unused;
+#endif
+} cm4u_trace_t;
+
+/* Record an event (safe from any context: slot claimed with PRIMASK held) */
+static inline void cm4u_trace_mark(cm4u_trace_t *trace, uint32_t id)
+{
+#if (CM4U_CFG_TRACE_DEPTH > 0)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t slot = trace->head++ & (CM4U_CFG_TRACE_DEPTH - 1u);
+    trace->entry[slot].cycles = cm4u_dwt_get_cycles();
+    trace->entry[slot].id     = id;
+    __set_PRIMASK(primask);
+#else
+    (void)trace;
+    (void)id;
+#endif
 }
 
 /* -------------------------------------------------------------------------- */
@@ -0,0 +1,238 @@
+#ifndef CM4U_FIBER_H
+#define CM4U_FIBER_H
+
+/*
+ * Stackful cooperative fibers.
+ *
+ * Each fiber has its own stack, so blocking-style code (protocol state
+ * machines, "send, wait for ACK, retry") can be written as straight-line
+ * C. A switch is a plain function call, not an exception: it pushes the
+ * callee-saved registers with one STMDB, swaps SP and pops the other
+ * fiber's registers, PC included, with one LDMIA. S16-S31 are added with
+ * VSTMDB / VLDMIA when CM4U_CFG_FIBER_FPU is set. Everything else is
+ * already saved by the caller under the AAPCS.
+ *
+ *   static uint32_t modem_stack[256];
+ *   static cm4u_fiber_t modem;
+ *
+ *   static void modem_main(void *arg)
+ *   {
+ *       for (;;) {
+ *           at_send("AT\r");
+ *           CM4U_FIBER_WAIT(at_reply_ready());  // yields until true
+ *           ...
+ *       }
+ *   }
+ *
+ *   cm4u_fiber_init(&modem, modem_stack, sizeof(modem_stack), modem_main, 0);
+ *   for (;;) {
+ *       cm4u_fiber_resume(&modem);              // runs until its next yield
+ *       ...
+ *   }
+ *
+ * Fibers are asymmetric coroutines: cm4u_fiber_resume() runs a fiber until
+ * it calls cm4u_fiber_yield() (or returns), then continues the resumer.
+ * Fibers may resume other fibers.
+ *
+ * Stacks are painted at init. cm4u_fiber_stack_used() reports the high
+ * water mark. Fibers run on whatever SP Thread mode uses (normally MSP),
+ * so interrupts taken while a fiber runs are stacked on the fiber's stack.
+ * Size stacks for that, or run Thread mode on PSP.
+ *
+ * The host backend switches with ucontext and, in STEP mode, charges the
+ * cycles of the target sequence (CM4U_FIBER_SWITCH_CYCLES).
+ */
+
+#include "cm4u_core.h"
+
+#if defined(CM4U_HOST)
+#include <ucontext.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Stack paint pattern */
+#define CM4U_FIBER_PAINT  0xA5A5A5A5u
+
+/* Words of the initial / saved context: [S16-S31] R4-R11 PC */
+#define CM4U_FIBER_FRAME_WORDS  (9u + ((CM4U_CFG_FIBER_FPU != 0) ? 16u : 0u))
+
+/*
+ * Cycles of one switch on a zero-wait-state Cortex-M4 (what STEP mode
+ * charges on the host): STMDB / LDMIA 1 + N each, +2 for the PC load
+ * (pipeline refill), STR 2, MOV 1, plus 1 + 16 for each FPU transfer.
+ */
+#define CM4U_FIBER_SWITCH_CYCLES  (10u + 2u + 1u + 12u + ((CM4U_CFG_FIBER_FPU != 0) ? 34u : 0u))
+
+typedef void (*cm4u_fiber_fn_t)(void *arg);
+
+typedef struct cm4u_fiber cm4u_fiber_t;
+
+struct cm4u_fiber {
+    uint32_t        *sp;          /* saved SP while suspended */
+    uint32_t        *caller_sp;   /* resumer's SP while running */
+    cm4u_fiber_t    *caller;      /* fiber (or 0 = Thread code) that resumed us */
+    cm4u_fiber_fn_t  fn;
+    void            *arg;
+    uint32_t        *stack;       /* lowest word of the stack */
+    uint32_t         stack_words;
+    volatile bool    done;        /* fn has returned; do not resume again */
+#if defined(CM4U_HOST)
+    ucontext_t       ctx;
+    ucontext_t       caller_ctx;
+#endif
+};
+
+/* Fiber running now, 0 in plain Thread / Handler code */
+__attribute__((weak)) cm4u_fiber_t *cm4u_fiber_current;
+
+/* --------------------------------------------------------------------------
+ *  Context switch
+ * -------------------------------------------------------------------------- */
+
+#if defined(CM4U_HOST)
+
+static inline void cm4u_fiber__switch_host(ucontext_t *save, const ucontext_t *load)
+{
+    cm4u_host_t *h = cm4u_host();
+    if (h->clock_mode == CM4U_HOST_CLOCK_STEP) {
+        cm4u_host_advance_cycles(CM4U_FIBER_SWITCH_CYCLES);
+    }
+    (void)swapcontext(save, load);
+}
+
+#else
+
+/* Save callee-saved state on this stack, *save = SP, SP = load, restore */
+__attribute__((naked, noinline, unused)) static void cm4u_fiber__switch(uint32_t **save, uint32_t *load)
+{
+    __asm volatile(
+        "stmdb   sp!, {r4-r11, lr}  \n"
+#if (CM4U_CFG_FIBER_FPU != 0)
+        "vstmdb  sp!, {s16-s31}     \n"
+#endif
+        "str     sp, [r0]           \n"
+        "mov     sp, r1             \n"
+#if (CM4U_CFG_FIBER_FPU != 0)
+        "vldmia  sp!, {s16-s31}     \n"
+#endif
+        "ldmia   sp!, {r4-r11, pc}  \n");
+}
+
+#endif /* CM4U_HOST */
+
+/* First code run on a new fiber's stack */
+__attribute__((unused)) static void cm4u_fiber__main(void)
+{
+    cm4u_fiber_t *f = cm4u_fiber_current;
+    f->fn(f->arg);
+    f->done = true;
+    for (;;) {
+#if defined(CM4U_HOST)
+        cm4u_fiber__switch_host(&f->ctx, &f->caller_ctx);
+#else
+        cm4u_fiber__switch(&f->sp, f->caller_sp);
+#endif
+    }
+}
+
+/* --------------------------------------------------------------------------
+ *  API
+ * -------------------------------------------------------------------------- */
+
+/*
+ * Set up `f` to run fn(arg) on `stack` (`stack_bytes`, word aligned) at
+ * its first cm4u_fiber_resume(). Paints the whole stack.
+ */
+static inline void cm4u_fiber_init(cm4u_fiber_t *f, uint32_t *stack, uint32_t stack_bytes,
+                                   cm4u_fiber_fn_t fn, void *arg)
+{
+    uint32_t words = stack_bytes / 4u;
+
+    CM4U_ASSERT((fn != 0) && (words > (CM4U_FIBER_FRAME_WORDS + 2u)));
+    for (uint32_t i = 0u; i < words; i++) {
+        stack[i] = CM4U_FIBER_PAINT;
+    }
+    f->fn = fn;
+    f->arg = arg;
+    f->stack = stack;
+    f->stack_words = words;
+    f->caller = 0;
+    f->caller_sp = 0;
+    f->done = false;
+
+#if defined(CM4U_HOST)
+    f->sp = 0;
+    (void)getcontext(&f->ctx);
+    f->ctx.uc_stack.ss_sp = stack;
+    f->ctx.uc_stack.ss_size = (size_t)words * 4u;
+    f->ctx.uc_link = 0;
+    makecontext(&f->ctx, cm4u_fiber__main, 0);
+#else
+    /* AAPCS: SP 8-byte aligned when cm4u_fiber__main starts */
+    uint32_t *top = (uint32_t *)((uintptr_t)(stack + words) & ~(uintptr_t)7u);
+    uint32_t *sp = top - CM4U_FIBER_FRAME_WORDS;
+    for (uint32_t i = 0u; i < (CM4U_FIBER_FRAME_WORDS - 1u); i++) {
+        sp[i] = 0u;  /* S16-S31, R4-R11 */
+    }
+    sp[CM4U_FIBER_FRAME_WORDS - 1u] = (uint32_t)(uintptr_t)&cm4u_fiber__main;
+    f->sp = sp;
+#endif
+}
+
+/* Run `f` until it yields or returns */
+static inline void cm4u_fiber_resume(cm4u_fiber_t *f)
+{
+    CM4U_ASSERT(!f->done && (f != cm4u_fiber_current));
+    f->caller = cm4u_fiber_current;
+    cm4u_fiber_current = f;
+#if defined(CM4U_HOST)
+    cm4u_fiber__switch_host(&f->caller_ctx, &f->ctx);
+#else
+    cm4u_fiber__switch(&f->caller_sp, f->sp);
+#endif
+    cm4u_fiber_current = f->caller;
+}
+
+/* From inside a fiber: go back to whoever resumed it */
+static inline void cm4u_fiber_yield(void)
+{
+    cm4u_fiber_t *f = cm4u_fiber_current;
+    CM4U_ASSERT(f != 0);
+#if defined(CM4U_HOST)
+    cm4u_fiber__switch_host(&f->ctx, &f->caller_ctx);
+#else
+    cm4u_fiber__switch(&f->sp, f->caller_sp);
+#endif
+}
+
+/* Block (cooperatively) until `cond` holds */
+#define CM4U_FIBER_WAIT(cond)        \
+    do {                             \
+        while (!(cond)) {            \
+            cm4u_fiber_yield();      \
+        }                            \
+    } while (0)
+
+static inline bool cm4u_fiber_done(const cm4u_fiber_t *f)
+{
+    return f->done;
+}
+
+/* Deepest stack use so far, in bytes (paint high-water mark) */
+static inline uint32_t cm4u_fiber_stack_used(const cm4u_fiber_t *f)
+{
+    uint32_t untouched = 0u;
+    while ((untouched < f->stack_words) && (f->stack[untouched] == CM4U_FIBER_PAINT)) {
+        untouched++;
+    }
+    return (f->stack_words - untouched) * 4u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_FIBER_H */
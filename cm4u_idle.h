@@ -0,0 +1,362 @@
+#ifndef CM4U_IDLE_H
+#define CM4U_IDLE_H
+
+/*
+ * Low-power idle manager for Cortex-M4.
+ *
+ * Picks the deepest sleep whose measured wake-up latency still fits before
+ * the next deadline:
+ *
+ *   CM4U_SLEEP_NONE  - deadline too close, return immediately
+ *   CM4U_SLEEP_WFE   - WFE (returns at once if an event is already latched)
+ *   CM4U_SLEEP_WFI   - WFI, core clock gated
+ *   CM4U_SLEEP_DEEP  - WFI with SCR.SLEEPDEEP (device stop mode)
+ *
+ * Deadlines and latencies are in DWT cycles (requires cm4u_dwt_init).
+ * Residency per mode and missed wake-ups are accounted in cm4u_idle_t.
+ *
+ * CYCCNT usually stops in deep sleep. Give the manager a deep_elapsed hook
+ * (e.g. reading an LPTIM / RTC, converted to core cycles) so DEEP residency
+ * and lateness are still right.
+ *
+ * The second half of this file drives purely interrupt-driven designs with
+ * SCR.SLEEPONEXIT (cm4u_soe_*).
+ */
+
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CM4U_SLEEP_NONE = 0,
+    CM4U_SLEEP_WFE  = 1,
+    CM4U_SLEEP_WFI  = 2,
+    CM4U_SLEEP_DEEP = 3,
+    CM4U_SLEEP_NUM_MODES
+} cm4u_sleep_mode_t;
+
+/* Pass as deadline when nothing is scheduled: always the deepest allowed mode */
+#define CM4U_IDLE_NO_DEADLINE  0xFFFFFFFFu
+
+typedef struct cm4u_idle cm4u_idle_t;
+
+struct cm4u_idle {
+    /* Configuration */
+    uint32_t wake_latency[CM4U_SLEEP_NUM_MODES]; /* cycles from wake event to code running */
+    uint32_t margin_cycles;     /* extra budget required, and allowed lateness */
+    cm4u_sleep_mode_t deepest;  /* cap, e.g. CM4U_SLEEP_WFI while a DMA is running */
+    bool     adapt_latency;     /* raise wake_latency[] when a wake-up is observed slower */
+
+    /* Deep sleep hooks (optional): clock teardown / restore, elapsed time */
+    void     (*deep_enter)(void *ctx);
+    void     (*deep_exit)(void *ctx);
+    uint32_t (*deep_elapsed)(void *ctx);  /* cycles slept, from an always-on timer */
+    void     *hook_ctx;
+
+    /* Statistics */
+    uint64_t residency_cycles[CM4U_SLEEP_NUM_MODES]; /* time spent per mode */
+    uint32_t entries[CM4U_SLEEP_NUM_MODES];          /* times each mode was chosen */
+    uint32_t missed_wakeups;    /* woke later than deadline + margin */
+    uint32_t worst_lateness;    /* largest lateness seen, cycles */
+};
+
+/*
+ * Initialise with per-mode wake-up latencies (cycles, indexed by
+ * cm4u_sleep_mode_t; NONE is ignored). Pass NULL to start at 0 and let
+ * adapt_latency learn them.
+ */
+static inline void cm4u_idle_init(cm4u_idle_t *idle, const uint32_t *wake_latency, uint32_t margin_cycles)
+{
+    uint8_t *p = (uint8_t *)idle;
+    for (uint32_t i = 0u; i < sizeof(*idle); i++) {
+        p[i] = 0u;
+    }
+    if (wake_latency != 0) {
+        for (uint32_t m = 0u; m < (uint32_t)CM4U_SLEEP_NUM_MODES; m++) {
+            idle->wake_latency[m] = wake_latency[m];
+        }
+    }
+    idle->wake_latency[CM4U_SLEEP_NONE] = 0u;
+    idle->margin_cycles = margin_cycles;
+    idle->deepest       = CM4U_SLEEP_DEEP;
+    idle->adapt_latency = (wake_latency == 0);
+}
+
+static inline void cm4u_idle_reset_stats(cm4u_idle_t *idle)
+{
+    for (uint32_t m = 0u; m < (uint32_t)CM4U_SLEEP_NUM_MODES; m++) {
+        idle->residency_cycles[m] = 0u;
+        idle->entries[m] = 0u;
+    }
+    idle->missed_wakeups = 0u;
+    idle->worst_lateness = 0u;
+}
+
+/*
+ * SCB->SCR sleep behaviour:
+ *   sleeponexit - sleep again on return from the last ISR (interrupt-driven mode)
+ *   sevonpend   - any newly pending IRQ (even disabled/masked) wakes WFE
+ */
+static inline void cm4u_idle_config_scr(bool sleeponexit, bool sevonpend)
+{
+    uint32_t scr = SCB->SCR & ~(SCB_SCR_SLEEPONEXIT_Msk | SCB_SCR_SEVONPEND_Msk);
+    if (sleeponexit) scr |= SCB_SCR_SLEEPONEXIT_Msk;
+    if (sevonpend)   scr |= SCB_SCR_SEVONPEND_Msk;
+    SCB->SCR = scr;
+}
+
+/* Any enabled IRQ pending? With PRIMASK set it would be taken on unmask */
+static inline bool cm4u_idle__irq_pending(void)
+{
+    for (uint32_t w = 0u; w < 8u; w++) {
+        if ((NVIC->ISPR[w] & NVIC->ISER[w]) != 0u) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Deepest mode whose wake latency + margin fits in `budget` cycles */
+static inline cm4u_sleep_mode_t cm4u_idle_select(const cm4u_idle_t *idle, uint32_t budget)
+{
+    for (int32_t m = (int32_t)idle->deepest; m > (int32_t)CM4U_SLEEP_NONE; m--) {
+        uint64_t need = (uint64_t)idle->wake_latency[m] + idle->margin_cycles;
+        if (need <= budget) {
+            return (cm4u_sleep_mode_t)m;
+        }
+    }
+    return CM4U_SLEEP_NONE;
+}
+
+/*
+ * Sleep until an interrupt (or event) wakes the core, choosing the depth
+ * from the absolute CYCCNT `deadline` (or CM4U_IDLE_NO_DEADLINE). Call from
+ * the Thread-mode idle loop; something (a timer) must be armed to fire at the
+ * deadline. Interrupts are masked across the sleep so a wake-up between the
+ * decision and WFI is not lost; the waking ISR runs before this returns.
+ * SCR.SEVONPEND is set for the call so WFE wakes on IRQs masked by PRIMASK,
+ * and SCR is restored on return.
+ *
+ * Returns the mode used.
+ */
+static inline cm4u_sleep_mode_t cm4u_idle_enter(cm4u_idle_t *idle, uint32_t deadline)
+{
+    /* SEVONPEND before masking: an IRQ pending from here on latches an event */
+    uint32_t scr = SCB->SCR;
+    if (idle->deepest >= CM4U_SLEEP_WFE) {
+        SCB->SCR = scr | SCB_SCR_SEVONPEND_Msk;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t now = cm4u_dwt_get_cycles();
+    uint32_t budget;
+    if (deadline == CM4U_IDLE_NO_DEADLINE) {
+        budget = CM4U_IDLE_NO_DEADLINE;
+    } else {
+        int32_t left = (int32_t)(deadline - now);
+        budget = (left > 0) ? (uint32_t)left : 0u;
+    }
+
+    cm4u_sleep_mode_t mode = cm4u_idle_select(idle, budget);
+    idle->entries[mode]++;
+    if (mode == CM4U_SLEEP_NONE) {
+        SCB->SCR = scr;
+        __set_PRIMASK(primask);
+        return mode;
+    }
+
+    if (mode == CM4U_SLEEP_DEEP) {
+        if (idle->deep_enter != 0) {
+            idle->deep_enter(idle->hook_ctx);
+        }
+        SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    }
+
+    uint32_t t0 = cm4u_dwt_get_cycles();
+    __DSB();
+    if (mode == CM4U_SLEEP_WFE) {
+        /*
+         * SEV + WFE clears a stale event without sleeping. That may also
+         * eat the event of an IRQ that pended after masking, so look at
+         * the pending bits once more: anything pending from here on
+         * latches a fresh event and the second WFE returns at once.
+         */
+        __SEV();
+        __WFE();
+        if (!cm4u_idle__irq_pending()) {
+            __WFE();
+        }
+    } else {
+        __WFI();
+    }
+    uint32_t slept = (uint32_t)(cm4u_dwt_get_cycles() - t0);
+
+    if (mode == CM4U_SLEEP_DEEP) {
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+        if (idle->deep_elapsed != 0) {
+            slept = idle->deep_elapsed(idle->hook_ctx);
+        }
+        if (idle->deep_exit != 0) {
+            idle->deep_exit(idle->hook_ctx);
+        }
+    }
+    idle->residency_cycles[mode] += slept;
+
+    if (deadline != CM4U_IDLE_NO_DEADLINE) {
+        int32_t lateness = (int32_t)((t0 + slept) - deadline);
+        if (lateness > 0) {
+            /* Woken by (or after) the deadline: this is the wake-up latency */
+            if ((uint32_t)lateness > idle->worst_lateness) {
+                idle->worst_lateness = (uint32_t)lateness;
+            }
+            if (idle->adapt_latency && (uint32_t)lateness > idle->wake_latency[mode]) {
+                idle->wake_latency[mode] = (uint32_t)lateness;
+            }
+            if ((uint32_t)lateness > idle->margin_cycles) {
+                idle->missed_wakeups++;
+            }
+        }
+    }
+
+    SCB->SCR = scr;
+    __set_PRIMASK(primask);
+    return mode;
+}
+
+/* --------------------------------------------------------------------------
+ *  Sleep-on-exit (interrupt-driven) execution
+ * -------------------------------------------------------------------------- */
+
+/*
+ * With SCR.SLEEPONEXIT set, returning from the last active ISR puts the core
+ * straight back to sleep: no unstacking, no Thread-mode loop, no WFI, and no
+ * stacking on the next wake-up. Thread mode only runs when an ISR asks for
+ * deferred work with cm4u_soe_request_thread().
+ *
+ * Usage:
+ *   static cm4u_soe_t soe;
+ *
+ *   void ADC_IRQHandler(void) {
+ *       ...
+ *       if (buffer_full) cm4u_soe_request_thread(&soe);
+ *       cm4u_soe_isr_exit(&soe);
+ *   }
+ *
+ *   int main(void) {
+ *       ...
+ *       cm4u_soe_init(&soe, process_buffer, NULL);
+ *       cm4u_soe_run(&soe);   // never returns unless soe.stop is set
+ *   }
+ */
+
+/* Default cost of one ISR -> Thread -> WFI -> ISR round trip avoided, cycles
+ * (exception return + re-entry stacking + loop). Measure yours with
+ * bench/bench_sleeponexit.c and set cm4u_soe_t.roundtrip_cycles. */
+#ifndef CM4U_SOE_ROUNDTRIP_CYCLES
+#define CM4U_SOE_ROUNDTRIP_CYCLES 30u
+#endif
+
+typedef struct {
+    void (*work)(void *ctx);        /* deferred Thread-mode work */
+    void *ctx;
+    uint32_t roundtrip_cycles;      /* cost saved per ISR that returned into sleep */
+    volatile uint32_t requests;     /* bumped by cm4u_soe_request_thread() */
+    uint32_t served;                /* requests handled by cm4u_soe_run() */
+    volatile uint32_t isr_exits;    /* bumped by cm4u_soe_isr_exit() */
+    uint32_t thread_runs;           /* times Thread mode actually ran */
+    volatile bool stop;             /* make cm4u_soe_run() return */
+} cm4u_soe_t;
+
+static inline void cm4u_soe_init(cm4u_soe_t *soe, void (*work)(void *ctx), void *ctx)
+{
+    soe->work             = work;
+    soe->ctx              = ctx;
+    soe->roundtrip_cycles = CM4U_SOE_ROUNDTRIP_CYCLES;
+    soe->requests         = 0u;
+    soe->served           = 0u;
+    soe->isr_exits        = 0u;
+    soe->thread_runs      = 0u;
+    soe->stop             = false;
+}
+
+static inline void cm4u_soe_enable(void)
+{
+    SCB->SCR |= SCB_SCR_SLEEPONEXIT_Msk;
+}
+
+static inline void cm4u_soe_disable(void)
+{
+    SCB->SCR &= ~SCB_SCR_SLEEPONEXIT_Msk;
+    __DSB();
+}
+
+/* From an ISR: leave sleep-on-exit so Thread mode runs soe->work once */
+static inline void cm4u_soe_request_thread(cm4u_soe_t *soe)
+{
+    (void)cm4u_atomic_inc(&soe->requests);
+    cm4u_soe_disable();
+}
+
+/* From an ISR, last thing before returning: accounting only */
+static inline void cm4u_soe_isr_exit(cm4u_soe_t *soe)
+{
+    (void)cm4u_atomic_inc(&soe->isr_exits);
+}
+
+/*
+ * Thread-mode driver. Sleeps with SLEEPONEXIT set; ISRs run and drop the core
+ * back to sleep on return. When one requests Thread mode, runs soe->work with
+ * interrupts enabled, then goes back to sleep-on-exit. The check-then-sleep
+ * step runs with PRIMASK set, so a request can't slip in between.
+ */
+static inline void cm4u_soe_run(cm4u_soe_t *soe)
+{
+    while (!soe->stop) {
+        __disable_irq();
+        if (soe->requests == soe->served && !soe->stop) {
+            cm4u_soe_enable();
+            __DSB();
+            __WFI();
+        }
+        __enable_irq();  /* pending ISRs run here; Thread resumes only on request */
+
+        soe->thread_runs++;
+        while (soe->served != soe->requests) {
+            soe->served++;
+            if (soe->work != 0) {
+                soe->work(soe->ctx);
+            }
+        }
+    }
+    cm4u_soe_disable();
+}
+
+/* Cycles saved versus a main-loop-with-WFI design, by the accounting above */
+static inline uint64_t cm4u_soe_cycles_saved(const cm4u_soe_t *soe)
+{
+    uint32_t exits = soe->isr_exits;
+    uint32_t avoided = (exits > soe->thread_runs) ? (exits - soe->thread_runs) : 0u;
+    return (uint64_t)avoided * soe->roundtrip_cycles;
+}
+
+/* Share of total idle time spent in `mode`, in 1/1000 */
+static inline uint32_t cm4u_idle_residency_permille(const cm4u_idle_t *idle, cm4u_sleep_mode_t mode)
+{
+    uint64_t total = 0u;
+    for (uint32_t m = 0u; m < (uint32_t)CM4U_SLEEP_NUM_MODES; m++) {
+        total += idle->residency_cycles[m];
+    }
+    if (total == 0u) {
+        return 0u;
+    }
+    return (uint32_t)((idle->residency_cycles[mode] * 1000u) / total);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_IDLE_H */
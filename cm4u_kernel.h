@@ -0,0 +1,223 @@
+#ifndef CM4U_KERNEL_H
+#define CM4U_KERNEL_H
+
+/*
+ * Run-to-completion task kernel scheduled by the NVIC.
+ *
+ * Every task is a spare device vector at the task's priority. Activating
+ * a task is a pend. Preemption, priority order and tail-chaining come from
+ * the exception hardware, so there is no scheduler code, no ready list and
+ * no per-task stack: all tasks run to completion on the MSP. Thread mode
+ * is the idle loop.
+ *
+ *   static cm4u_task_t ctl, ui;
+ *   static cm4u_res_t  spi_bus;
+ *   CM4U_TASK_HANDLER(TIM6_IRQHandler, ctl)
+ *   CM4U_TASK_HANDLER(TIM7_IRQHandler, ui)
+ *
+ *   cm4u_task_init(&ctl, TIM6_IRQn, 2u, ctl_event, &ctl_state);
+ *   cm4u_task_init(&ui,  TIM7_IRQn, 6u, ui_event,  &ui_state);
+ *   cm4u_res_init(&spi_bus);
+ *   cm4u_res_use(&spi_bus, &ctl);               // ceiling = priority 2
+ *   cm4u_res_use(&spi_bus, &ui);
+ *
+ *   cm4u_task_post(&ui, EV_REDRAW);             // from anywhere
+ *
+ *   static void ui_event(void *ctx, uint32_t ev)
+ *   {
+ *       uint32_t key = cm4u_res_lock(&spi_bus); // ctl cannot preempt here
+ *       ...
+ *       cm4u_res_unlock(key);
+ *   }
+ *
+ * Each task has a lock-free queue of CM4U_CFG_TASK_EVENTS event words. Its
+ * handler calls fn(ctx, event) once per event, in order. Event 0 is
+ * reserved. Posting works like cm4u_swi_post(): the producer reserves a
+ * slot with LDREX/STREX, writes the event, then pends the vector.
+ *
+ * Mutual exclusion uses the immediate priority ceiling (stack resource
+ * policy). cm4u_res_lock() raises BASEPRI to the highest priority of the
+ * tasks that use the resource. It never blocks, so neither deadlock nor
+ * unbounded priority inversion can happen. BASEPRI cannot mask priority 0,
+ * so tasks sharing a resource need priorities of 1 or more. Ceilings
+ * compare group priorities; with PRIGROUP subpriority bits, give the tasks
+ * distinct group priorities.
+ *
+ * Tasks with equal priority never preempt each other, so they may share
+ * data without locks.
+ */
+
+#include <string.h>
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event handler: called once per event, runs to completion */
+typedef void (*cm4u_task_fn_t)(void *ctx, uint32_t event);
+
+/* Reserved event value: marks a queue slot as reserved but not yet written */
+#define CM4U_TASK_NO_EVENT  0u
+
+typedef struct {
+    cm4u_task_fn_t    fn;
+    void             *ctx;
+    IRQn_Type         irqn;
+    uint32_t          priority;   /* NVIC priority, as for NVIC_SetPriority() */
+    volatile uint32_t head;       /* events reserved by producers (free running) */
+    volatile uint32_t tail;       /* events taken by the handler (free running) */
+
+    /* Statistics */
+    volatile uint32_t dropped;    /* posts refused, queue full */
+    uint32_t          runs;       /* events handled */
+    uint32_t          max_depth;  /* deepest queue seen on activation */
+
+    volatile uint32_t event[CM4U_CFG_TASK_EVENTS];
+} cm4u_task_t;
+
+/* A shared resource and its priority ceiling (raw BASEPRI value, 0 = no user yet) */
+typedef struct {
+    uint32_t basepri;
+} cm4u_res_t;
+
+/* NVIC priority -> raw BASEPRI / IP value */
+#define CM4U_KERNEL_BASEPRI(prio)  (((uint32_t)(prio) << (8u - __NVIC_PRIO_BITS)) & 0xFFu)
+
+/* --------------------------------------------------------------------------
+ *  Tasks
+ * -------------------------------------------------------------------------- */
+
+/*
+ * Bind `task` to vector `irqn` at `priority` and enable it. Call with
+ * interrupts masked if events may be posted before every task is set up.
+ */
+static inline void cm4u_task_init(cm4u_task_t *task, IRQn_Type irqn, uint32_t priority,
+                                  cm4u_task_fn_t fn, void *ctx)
+{
+    CM4U_ASSERT(((int32_t)irqn >= 0) && (fn != 0));
+    cm4u_nvic_disable_irq(irqn);
+    memset(task, 0, sizeof(*task));
+    task->fn = fn;
+    task->ctx = ctx;
+    task->irqn = irqn;
+    task->priority = priority;
+    cm4u_nvic_set_priority(irqn, priority);
+    cm4u_nvic_clear_pending(irqn);
+    cm4u_nvic_enable_irq(irqn);
+}
+
+/* Activate the task without queueing anything (it runs any queued events) */
+static inline void cm4u_task_activate(const cm4u_task_t *task)
+{
+#if (CM4U_CFG_SWI_STIR != 0)
+    cm4u_nvic_trigger(task->irqn);
+#else
+    cm4u_nvic_set_pending(task->irqn);
+#endif
+}
+
+/*
+ * Queue `event` (non-zero) for `task` and activate it. Safe from any
+ * context. Returns false (and counts a drop) when the queue is full.
+ */
+static inline bool cm4u_task_post(cm4u_task_t *task, uint32_t event)
+{
+    uint32_t head;
+
+    CM4U_ASSERT(event != CM4U_TASK_NO_EVENT);
+    if (!cm4u_ring_reserve(&task->head, &task->tail, CM4U_CFG_TASK_EVENTS, 1u, &task->dropped, &head)) {
+        return false;
+    }
+
+    task->event[head & (CM4U_CFG_TASK_EVENTS - 1u)] = event;  /* publish */
+    cm4u_task_activate(task);
+    return true;
+}
+
+/*
+ * Handle every queued event. Call it (only) from the task's vector handler.
+ * Stops at a slot a preempted producer has reserved but not yet written;
+ * that producer activates the task again once it has.
+ */
+static inline void cm4u_task_run(cm4u_task_t *task)
+{
+    uint32_t tail = task->tail;
+    uint32_t depth = task->head - tail;
+
+    if (depth > task->max_depth) {
+        task->max_depth = depth;
+    }
+    while (tail != task->head) {
+        volatile uint32_t *slot = &task->event[tail & (CM4U_CFG_TASK_EVENTS - 1u)];
+        uint32_t ev = *slot;
+        if (ev == CM4U_TASK_NO_EVENT) {
+            break;
+        }
+        *slot = CM4U_TASK_NO_EVENT;
+        __DMB();
+        task->tail = ++tail;  /* free the slot first: the handler may post to itself */
+        task->runs++;
+        task->fn(task->ctx, ev);
+    }
+}
+
+/* Events waiting (or being written) right now */
+static inline uint32_t cm4u_task_queued(const cm4u_task_t *task)
+{
+    return task->head - task->tail;
+}
+
+/* Define the vector handler for a task: CM4U_TASK_HANDLER(TIM6_IRQHandler, ctl) */
+#define CM4U_TASK_HANDLER(handler, task)  \
+    void handler(void)                    \
+    {                                     \
+        cm4u_task_run(&(task));           \
+    }
+
+/* --------------------------------------------------------------------------
+ *  Resources (immediate priority ceiling via BASEPRI)
+ * -------------------------------------------------------------------------- */
+
+static inline void cm4u_res_init(cm4u_res_t *res)
+{
+    res->basepri = 0u;
+}
+
+/* Declare that code at NVIC priority `priority` locks `res` (ISRs too) */
+static inline void cm4u_res_use_priority(cm4u_res_t *res, uint32_t priority)
+{
+    uint32_t b = CM4U_KERNEL_BASEPRI(priority);
+    CM4U_ASSERT(b != 0u);  /* BASEPRI cannot mask priority 0 */
+    if ((res->basepri == 0u) || (b < res->basepri)) {
+        res->basepri = b;
+    }
+}
+
+/* Declare that `task` locks `res` */
+static inline void cm4u_res_use(cm4u_res_t *res, const cm4u_task_t *task)
+{
+    cm4u_res_use_priority(res, task->priority);
+}
+
+/*
+ * Enter the resource: raise BASEPRI to its ceiling (never lowers it, so
+ * locks nest). Returns the key for cm4u_res_unlock().
+ */
+static inline uint32_t cm4u_res_lock(const cm4u_res_t *res)
+{
+    uint32_t key = cm4u_get_basepri();
+    cm4u_raise_basepri(res->basepri);
+    return key;
+}
+
+static inline void cm4u_res_unlock(uint32_t key)
+{
+    cm4u_set_basepri(key);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_KERNEL_H */
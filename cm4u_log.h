@@ -0,0 +1,215 @@
+#ifndef CM4U_LOG_H
+#define CM4U_LOG_H
+
+/*
+ * Deferred-formatting binary logger.
+ *
+ * A log call stores no text and does no formatting. It appends one record
+ * of raw 32-bit words to a lock-free ring:
+ *
+ *   word 0   header: format ID << 8 | nargs << 1 | 1 (valid)
+ *   word 1   timestamp (DWT CYCCNT)
+ *   word 2.. arguments, as uint32_t
+ *
+ * Each format string lives in the `cm4u_log_fmt` section. ld/cm4u_log.ld
+ * makes that section INFO (not loaded, no flash) at address 0, so the
+ * string's address is its ID, resolved by the linker. tools/cm4u_log_decode.py
+ * reads the strings back from the ELF and formats the records on the host.
+ *
+ *   CM4U_LOG("adc ch%u = %d", ch, value);        // from any context
+ *   CM4U_LOG("gain %f", cm4u_log_f32(gain));     // floats as raw bits
+ *
+ *   // background task: drain to UART / RTT / semihosting
+ *   uint32_t buf[32];
+ *   uint32_t n = cm4u_log_read(&cm4u_log_ring, buf, 32);
+ *   uart_write(buf, n * 4);
+ *
+ * Up to 6 arguments; %d %i %u %x %X %o %c %p and %f/%e/%g (via
+ * cm4u_log_f32()) are understood by the decoder. %s is not (the pointer
+ * would refer to target RAM).
+ *
+ * Producers reserve space with LDREX/STREX on the head index and write the
+ * header last, so ISRs of any priority may log concurrently. There is a
+ * single consumer, cm4u_log_read(). When the ring is full, records are
+ * dropped and counted. CM4U_CFG_LOG_WORDS = 0 compiles every call away.
+ */
+
+#include <string.h>
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CM4U_LOG_MAX_ARGS  6u
+#define CM4U_LOG_SECTION   "cm4u_log_fmt"
+
+/* Timestamp source */
+#ifndef CM4U_LOG_NOW
+#define CM4U_LOG_NOW()     cm4u_dwt_get_cycles()
+#endif
+
+/* Header word fields */
+#define CM4U_LOG_HDR(id, nargs)   (((uint32_t)(id) << 8) | ((uint32_t)(nargs) << 1) | 1u)
+#define CM4U_LOG_HDR_ID(h)        ((h) >> 8)
+#define CM4U_LOG_HDR_NARGS(h)     (((h) >> 1) & 7u)
+
+/* Float argument for %f / %e / %g: passed as its IEEE-754 bits */
+static inline uint32_t cm4u_log_f32(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+#if (CM4U_CFG_LOG_WORDS > 0)
+
+typedef struct {
+    volatile uint32_t head;     /* words reserved by producers (free running) */
+    volatile uint32_t tail;     /* words consumed by the reader (free running) */
+    volatile uint32_t dropped;  /* records lost to a full ring */
+    volatile uint32_t word[CM4U_CFG_LOG_WORDS];
+} cm4u_log_t;
+
+/* The ring the CM4U_LOG() macro writes to */
+__attribute__((weak)) cm4u_log_t cm4u_log_ring;
+
+/*
+ * Format string -> ID. On the target the section sits at address 0, so this
+ * is a link-time constant; host binaries need the offset from the section
+ * start instead.
+ */
+#if defined(CM4U_HOST)
+extern const char __start_cm4u_log_fmt[] __attribute__((weak));
+#define CM4U_LOG_ID(fmt)  ((uint32_t)((uintptr_t)(fmt) - (uintptr_t)__start_cm4u_log_fmt))
+#else
+#define CM4U_LOG_ID(fmt)  ((uint32_t)(uintptr_t)(fmt))
+#endif
+
+/* Append one record; `args` holds `nargs` words. Safe from any context. */
+static inline void cm4u_log_put(cm4u_log_t *log, uint32_t id, uint32_t nargs, const uint32_t *args)
+{
+    uint32_t len = 2u + nargs;
+    uint32_t head;
+
+    if (!cm4u_ring_reserve(&log->head, &log->tail, CM4U_CFG_LOG_WORDS, len, &log->dropped, &head)) {
+        return;
+    }
+
+    log->word[(head + 1u) & (CM4U_CFG_LOG_WORDS - 1u)] = CM4U_LOG_NOW();
+    for (uint32_t i = 0u; i < nargs; i++) {
+        log->word[(head + 2u + i) & (CM4U_CFG_LOG_WORDS - 1u)] = args[i];
+    }
+    __DMB();
+    /* Header last: the reader stops at a zero header (reserved, not yet written) */
+    log->word[head & (CM4U_CFG_LOG_WORDS - 1u)] = CM4U_LOG_HDR(id, nargs);
+}
+
+/*
+ * Move complete records (whole records only) into `out`, up to `max` words.
+ * Returns the number of words written. Single consumer, Thread mode.
+ */
+static inline uint32_t cm4u_log_read(cm4u_log_t *log, uint32_t *out, uint32_t max)
+{
+    uint32_t tail = log->tail;
+    uint32_t n = 0u;
+
+    while (tail != log->head) {
+        uint32_t hdr = log->word[tail & (CM4U_CFG_LOG_WORDS - 1u)];
+        if (hdr == 0u) {
+            break;  /* a producer has reserved this record but not finished it */
+        }
+        uint32_t len = 2u + CM4U_LOG_HDR_NARGS(hdr);
+        if ((n + len) > max) {
+            break;
+        }
+        __DMB();
+        for (uint32_t i = 0u; i < len; i++) {
+            volatile uint32_t *w = &log->word[(tail + i) & (CM4U_CFG_LOG_WORDS - 1u)];
+            out[n++] = *w;
+            *w = 0u;  /* any word may become the next header slot */
+        }
+        tail += len;
+        __DMB();
+        log->tail = tail;
+    }
+    return n;
+}
+
+static inline void cm4u_log_put0(uint32_t id)
+{
+    cm4u_log_put(&cm4u_log_ring, id, 0u, 0);
+}
+
+static inline void cm4u_log_put1(uint32_t id, uint32_t a)
+{
+    const uint32_t args[1] = { a };
+    cm4u_log_put(&cm4u_log_ring, id, 1u, args);
+}
+
+static inline void cm4u_log_put2(uint32_t id, uint32_t a, uint32_t b)
+{
+    const uint32_t args[2] = { a, b };
+    cm4u_log_put(&cm4u_log_ring, id, 2u, args);
+}
+
+static inline void cm4u_log_put3(uint32_t id, uint32_t a, uint32_t b, uint32_t c)
+{
+    const uint32_t args[3] = { a, b, c };
+    cm4u_log_put(&cm4u_log_ring, id, 3u, args);
+}
+
+static inline void cm4u_log_put4(uint32_t id, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    const uint32_t args[4] = { a, b, c, d };
+    cm4u_log_put(&cm4u_log_ring, id, 4u, args);
+}
+
+static inline void cm4u_log_put5(uint32_t id, uint32_t a, uint32_t b, uint32_t c, uint32_t d,
+                                 uint32_t e)
+{
+    const uint32_t args[5] = { a, b, c, d, e };
+    cm4u_log_put(&cm4u_log_ring, id, 5u, args);
+}
+
+static inline void cm4u_log_put6(uint32_t id, uint32_t a, uint32_t b, uint32_t c, uint32_t d,
+                                 uint32_t e, uint32_t f)
+{
+    const uint32_t args[6] = { a, b, c, d, e, f };
+    cm4u_log_put(&cm4u_log_ring, id, 6u, args);
+}
+
+#define CM4U_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define CM4U_LOG_NARGS(...)  CM4U_LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define CM4U_LOG_CAT_(a, b)  a##b
+#define CM4U_LOG_CAT(a, b)   CM4U_LOG_CAT_(a, b)
+#define CM4U_LOG_U32(x)      ((uint32_t)(x))
+#define CM4U_LOG_MAP0()
+#define CM4U_LOG_MAP1(a)                 , CM4U_LOG_U32(a)
+#define CM4U_LOG_MAP2(a, b)              CM4U_LOG_MAP1(a) CM4U_LOG_MAP1(b)
+#define CM4U_LOG_MAP3(a, b, c)           CM4U_LOG_MAP2(a, b) CM4U_LOG_MAP1(c)
+#define CM4U_LOG_MAP4(a, b, c, d)        CM4U_LOG_MAP3(a, b, c) CM4U_LOG_MAP1(d)
+#define CM4U_LOG_MAP5(a, b, c, d, e)     CM4U_LOG_MAP4(a, b, c, d) CM4U_LOG_MAP1(e)
+#define CM4U_LOG_MAP6(a, b, c, d, e, f)  CM4U_LOG_MAP5(a, b, c, d, e) CM4U_LOG_MAP1(f)
+
+/* Log `fmt` (a string literal) with up to 6 integer-convertible arguments */
+#define CM4U_LOG(fmt, ...)                                                            \
+    do {                                                                              \
+        __attribute__((section(CM4U_LOG_SECTION), used))                              \
+        static const char cm4u_log_fmt_[] = fmt;                                      \
+        CM4U_LOG_CAT(cm4u_log_put, CM4U_LOG_NARGS(__VA_ARGS__))(                      \
+            CM4U_LOG_ID(cm4u_log_fmt_)                                                \
+            CM4U_LOG_CAT(CM4U_LOG_MAP, CM4U_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__));    \
+    } while (0)
+
+#else /* CM4U_CFG_LOG_WORDS == 0 */
+
+#define CM4U_LOG(fmt, ...)  do { } while (0)
+
+#endif /* CM4U_CFG_LOG_WORDS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_LOG_H */
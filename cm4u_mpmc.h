@@ -0,0 +1,155 @@
+#ifndef CM4U_MPMC_H
+#define CM4U_MPMC_H
+
+/*
+ * Bounded lock-free multi-producer / multi-consumer queue of 32-bit words,
+ * for work queues filled and drained at several priorities.
+ *
+ * Each slot carries a sequence number (D. Vyukov's bounded MPMC queue):
+ *   seq == pos        free for the push at position `pos`
+ *   seq == pos + 1    holds the value for the pop at `pos`
+ * A push claims `head` with LDREX/STREX when its slot is free, writes the
+ * value, then releases the slot with seq = pos + 1. A pop claims `tail`
+ * the same way, reads the value, then frees the slot for the next lap
+ * with seq = pos + depth.
+ *
+ *   static cm4u_mpmc_slot_t work_slots[16];
+ *   static cm4u_mpmc_t work;
+ *
+ *   cm4u_mpmc_init(&work, work_slots, 16u);
+ *   (void)cm4u_mpmc_push(&work, job);             // any priority
+ *   uint32_t job;
+ *   while (cm4u_mpmc_pop(&work, &job)) { ... }    // any priority
+ *
+ * Progress on a single core:
+ *   - Without preemption, push and pop finish in one pass: wait-free.
+ *   - A pass only retries when an exception came in between its LDREX and
+ *     STREX, or when a preempting handler moved head / tail. Exception
+ *     entry clears the exclusive monitor. So retries are bounded by the
+ *     number of preemptions the call suffers; `retries` counts them.
+ *   - A call never waits for a context it preempted. A slot claimed by
+ *     a preempted push, but not yet released, makes pop report "empty".
+ *     A slot still being popped by a preempted pop makes push report
+ *     "full". Both are correct answers at that instant.
+ *
+ * CM4U_MPMC_STEP() marks the algorithm's steps. It expands to nothing
+ * unless defined before this header is included. bench/bench_mpmc.c
+ * defines it on the host to inject preemption at every step.
+ */
+
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CM4U_MPMC_STEP
+#define CM4U_MPMC_STEP()  do { } while (0)
+#endif
+
+typedef struct {
+    volatile uint32_t seq;
+    volatile uint32_t value;
+} cm4u_mpmc_slot_t;
+
+typedef struct {
+    cm4u_mpmc_slot_t *slot;
+    uint32_t          mask;
+    volatile uint32_t head;     /* next push position */
+    volatile uint32_t tail;     /* next pop position */
+    volatile uint32_t retries;  /* passes repeated because of preemption */
+} cm4u_mpmc_t;
+
+/* `slots`: `depth` slots, depth a power of two */
+static inline void cm4u_mpmc_init(cm4u_mpmc_t *q, cm4u_mpmc_slot_t *slots, uint32_t depth)
+{
+    CM4U_ASSERT((depth >= 2u) && ((depth & (depth - 1u)) == 0u));
+    for (uint32_t i = 0u; i < depth; i++) {
+        slots[i].seq = i;
+        slots[i].value = 0u;
+    }
+    q->slot = slots;
+    q->mask = depth - 1u;
+    q->head = 0u;
+    q->tail = 0u;
+    q->retries = 0u;
+}
+
+/* Append `value`; false when the queue is full */
+static inline bool cm4u_mpmc_push(cm4u_mpmc_t *q, uint32_t value)
+{
+    cm4u_mpmc_slot_t *s;
+    uint32_t pos;
+
+    for (;;) {
+        pos = __LDREXW(&q->head);
+        CM4U_MPMC_STEP();
+        s = &q->slot[pos & q->mask];
+        int32_t diff = (int32_t)(s->seq - pos);
+        CM4U_MPMC_STEP();
+        if (diff == 0) {
+            if (__STREXW(pos + 1u, &q->head) == 0u) {
+                break;
+            }
+        } else {
+            __CLREX();
+            if (diff < 0) {
+                return false;  /* full (or the slot's pop was preempted) */
+            }
+        }
+        CM4U_MPMC_STEP();
+        (void)cm4u_atomic_inc(&q->retries);
+    }
+    CM4U_MPMC_STEP();
+    s->value = value;
+    CM4U_MPMC_STEP();
+    __DMB();
+    s->seq = pos + 1u;  /* release to the pop at `pos` */
+    return true;
+}
+
+/* Remove the oldest value into *value; false when the queue is empty */
+static inline bool cm4u_mpmc_pop(cm4u_mpmc_t *q, uint32_t *value)
+{
+    cm4u_mpmc_slot_t *s;
+    uint32_t pos;
+
+    for (;;) {
+        pos = __LDREXW(&q->tail);
+        CM4U_MPMC_STEP();
+        s = &q->slot[pos & q->mask];
+        int32_t diff = (int32_t)(s->seq - (pos + 1u));
+        CM4U_MPMC_STEP();
+        if (diff == 0) {
+            if (__STREXW(pos + 1u, &q->tail) == 0u) {
+                break;
+            }
+        } else {
+            __CLREX();
+            if (diff < 0) {
+                return false;  /* empty (or the slot's push was preempted) */
+            }
+        }
+        CM4U_MPMC_STEP();
+        (void)cm4u_atomic_inc(&q->retries);
+    }
+    __DMB();
+    CM4U_MPMC_STEP();
+    *value = s->value;
+    CM4U_MPMC_STEP();
+    __DMB();
+    s->seq = pos + q->mask + 1u;  /* free for the push one lap later */
+    return true;
+}
+
+/* Values queued (or being pushed / popped) right now */
+static inline uint32_t cm4u_mpmc_count(const cm4u_mpmc_t *q)
+{
+    return q->head - q->tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_MPMC_H */
@@ -0,0 +1,343 @@
+#ifndef CM4U_MSG_H
+#define CM4U_MSG_H
+
+/*
+ * Zero-copy messages: fixed-size buffer pools and pointer mailboxes.
+ *
+ * A message is a pool buffer. The sender fills it in place and sends the
+ * pointer. Ownership moves with the pointer: after cm4u_mbox_send() the
+ * buffer belongs to the mailbox, and then to whoever receives it. The
+ * receiver gives it back with cm4u_msg_free(). Payload bytes are written
+ * once and never copied, whatever the message size.
+ *
+ *   static uint32_t rx_store[CM4U_POOL_WORDS(256u, 8u)] __attribute__((aligned(8)));
+ *   static cm4u_pool_t rx_pool;
+ *   static void *rx_slots[8];
+ *   static cm4u_mbox_t rx_mbox;
+ *
+ *   cm4u_pool_init(&rx_pool, rx_store, 256u, 8u);
+ *   cm4u_mbox_init(&rx_mbox, rx_slots, 8u);
+ *
+ *   // DMA-complete ISR
+ *   uint8_t *frame = cm4u_msg_alloc(&rx_pool);
+ *   ...fill frame...
+ *   if (!cm4u_mbox_send(&rx_mbox, frame, n)) cm4u_msg_free(frame);
+ *
+ *   // consumer
+ *   void *batch[4];
+ *   uint32_t got = cm4u_mbox_recv_batch(&rx_mbox, batch, 4u);
+ *   for (uint32_t i = 0u; i < got; i++) {
+ *       parse(batch[i], cm4u_msg_len(batch[i]));
+ *       cm4u_msg_free(batch[i]);
+ *   }
+ *
+ * Alloc, free and send are lock-free and safe from any ISR, at any
+ * priority. The pool is a LIFO free list of block indices updated with
+ * LDREX/STREX. Exception entry and return clear the exclusive monitor, so
+ * a pop preempted by a pop / push pair always retries: no ABA. Sending
+ * reserves a mailbox slot like cm4u_swi_post() does and then publishes the
+ * pointer (0 = reserved, not written yet). Each mailbox has one consumer
+ * context. cm4u_mbox_recv_batch() takes every ready message up to `max`
+ * and advances the tail once.
+ *
+ * Mailboxes do not wake anyone. Pair one with a cm4u_task_t (post an event
+ * after sending) or poll it.
+ *
+ * With CM4U_CFG_MSG_DEBUG set, every buffer in use carries an ownership
+ * state (in its free-list link, which is idle then):
+ *   - send, receive and free check it (double free, sending a free or
+ *     in-flight buffer),
+ *   - send checksums the payload, and receive checks it again. A mismatch
+ *     means someone wrote the buffer after giving it away (use-after-send).
+ * Violations are counted in the pool and reported with CM4U_ASSERT(). The
+ * checksum reads the payload twice per message: debug builds only.
+ */
+
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cm4u_pool cm4u_pool_t;
+
+/* Block header, right before the payload (a multiple of 8 bytes) */
+typedef struct {
+    cm4u_pool_t      *pool;
+    volatile uint32_t next;   /* free: index + 1 of the next free block; in use: state (debug) */
+    uint16_t          index;  /* position in the pool */
+    uint16_t          len;    /* payload bytes, set by cm4u_mbox_send() */
+    uint32_t          check;  /* payload checksum at send (debug) */
+} cm4u_msg_hdr_t;
+
+/* `next` of a buffer in use (debug); free-list links are at most 0xFFFF */
+#define CM4U_MSG_OWNED  0xFFFF0A0Au
+#define CM4U_MSG_SENT   0xFFFF5E5Eu
+
+/* Bytes one block of `payload_bytes` takes (payloads stay 8-byte aligned) */
+#define CM4U_POOL_BLOCK_BYTES(payload_bytes) \
+    ((uint32_t)sizeof(cm4u_msg_hdr_t) + ((((uint32_t)(payload_bytes)) + 7u) & ~7u))
+
+/* uint32_t words of storage for `count` blocks */
+#define CM4U_POOL_WORDS(payload_bytes, count) \
+    ((CM4U_POOL_BLOCK_BYTES(payload_bytes) * (uint32_t)(count)) / 4u)
+
+struct cm4u_pool {
+    uint8_t          *base;
+    uint32_t          block_bytes;
+    uint32_t          payload_bytes;
+    uint32_t          count;
+    volatile uint32_t free;            /* index + 1 of the first free block, 0 = empty */
+    volatile uint32_t alloc_failures;
+    volatile uint32_t violations;      /* ownership errors seen (debug) */
+    const void       *last_violation;  /* payload of the latest one (debug) */
+};
+
+typedef struct {
+    void *volatile   *slot;
+    uint32_t          mask;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;    /* sends refused: mailbox full */
+    uint32_t          max_depth;  /* deepest queue seen by a receive */
+} cm4u_mbox_t;
+
+/* --------------------------------------------------------------------------
+ *  Buffers
+ * -------------------------------------------------------------------------- */
+
+static inline cm4u_msg_hdr_t *cm4u_msg__hdr(const void *msg)
+{
+    return (cm4u_msg_hdr_t *)(uintptr_t)msg - 1;
+}
+
+static inline cm4u_msg_hdr_t *cm4u_pool__block(const cm4u_pool_t *pool, uint32_t index)
+{
+    return (cm4u_msg_hdr_t *)(void *)(pool->base + index * pool->block_bytes);
+}
+
+#if (CM4U_CFG_MSG_DEBUG != 0)
+
+static inline void cm4u_msg__violation(const void *msg)
+{
+    cm4u_pool_t *pool = cm4u_msg__hdr(msg)->pool;
+    (void)cm4u_atomic_inc(&pool->violations);
+    pool->last_violation = msg;
+    CM4U_ASSERT(0);
+}
+
+/* Cheap order-sensitive checksum of the first `len` payload bytes */
+static inline uint32_t cm4u_msg__checksum(const void *msg, uint32_t len)
+{
+    const uint32_t *w = (const uint32_t *)msg;
+    const uint8_t *b = (const uint8_t *)msg;
+    uint32_t sum = len;
+    uint32_t i = 0u;
+    for (; (i + 4u) <= len; i += 4u) {
+        sum = ((sum << 5) | (sum >> 27)) ^ w[i / 4u];
+    }
+    for (; i < len; i++) {
+        sum = ((sum << 5) | (sum >> 27)) ^ b[i];
+    }
+    return sum;
+}
+
+#endif /* CM4U_CFG_MSG_DEBUG */
+
+/*
+ * Carve `storage` (CM4U_POOL_WORDS(payload_bytes, count) words, 8-byte
+ * aligned for 8-byte payload fields) into `count` free buffers
+ */
+static inline void cm4u_pool_init(cm4u_pool_t *pool, uint32_t *storage,
+                                  uint32_t payload_bytes, uint32_t count)
+{
+    CM4U_ASSERT((count != 0u) && (count <= 0xFFFFu) && (payload_bytes <= 0xFFFFu));
+    pool->base = (uint8_t *)storage;
+    pool->block_bytes = CM4U_POOL_BLOCK_BYTES(payload_bytes);
+    pool->payload_bytes = payload_bytes;
+    pool->count = count;
+    pool->alloc_failures = 0u;
+    pool->violations = 0u;
+    pool->last_violation = 0;
+    for (uint32_t i = 0u; i < count; i++) {
+        cm4u_msg_hdr_t *h = cm4u_pool__block(pool, i);
+        h->pool = pool;
+        h->next = (i + 1u < count) ? (i + 2u) : 0u;
+        h->index = (uint16_t)i;
+        h->len = 0u;
+        h->check = 0u;
+    }
+    pool->free = 1u;
+}
+
+/* Take a buffer (now owned by the caller), 0 if the pool is empty */
+static inline void *cm4u_msg_alloc(cm4u_pool_t *pool)
+{
+    uint32_t top;
+    cm4u_msg_hdr_t *h;
+
+    do {
+        top = __LDREXW(&pool->free);
+        if (top == 0u) {
+            __CLREX();
+            (void)cm4u_atomic_inc(&pool->alloc_failures);
+            return 0;
+        }
+        h = cm4u_pool__block(pool, top - 1u);
+    } while (__STREXW(h->next, &pool->free) != 0u);
+
+#if (CM4U_CFG_MSG_DEBUG != 0)
+    h->next = CM4U_MSG_OWNED;
+#endif
+    return h + 1;
+}
+
+/* Give an owned (allocated or received) buffer back to its pool */
+static inline void cm4u_msg_free(void *msg)
+{
+    cm4u_msg_hdr_t *h = cm4u_msg__hdr(msg);
+    cm4u_pool_t *pool = h->pool;
+    uint32_t top;
+
+#if (CM4U_CFG_MSG_DEBUG != 0)
+    if (h->next != CM4U_MSG_OWNED) {
+        cm4u_msg__violation(msg);  /* double free, or freed while in flight */
+        return;
+    }
+#endif
+    do {
+        top = __LDREXW(&pool->free);
+        h->next = top;
+    } while (__STREXW(h->index + 1u, &pool->free) != 0u);
+}
+
+/* Payload bytes the sender declared */
+static inline uint32_t cm4u_msg_len(const void *msg)
+{
+    return cm4u_msg__hdr(msg)->len;
+}
+
+/* Payload capacity of a buffer */
+static inline uint32_t cm4u_msg_capacity(const void *msg)
+{
+    return cm4u_msg__hdr(msg)->pool->payload_bytes;
+}
+
+/* --------------------------------------------------------------------------
+ *  Mailboxes
+ * -------------------------------------------------------------------------- */
+
+/* `slots`: `depth` pointers, depth a power of two */
+static inline void cm4u_mbox_init(cm4u_mbox_t *mb, void **slots, uint32_t depth)
+{
+    CM4U_ASSERT((depth >= 2u) && ((depth & (depth - 1u)) == 0u));
+    for (uint32_t i = 0u; i < depth; i++) {
+        slots[i] = 0;
+    }
+    mb->slot = (void *volatile *)slots;
+    mb->mask = depth - 1u;
+    mb->head = 0u;
+    mb->tail = 0u;
+    mb->dropped = 0u;
+    mb->max_depth = 0u;
+}
+
+/*
+ * Hand an owned buffer holding `len` payload bytes to the mailbox. Returns
+ * false when it is full: the caller still owns `msg`.
+ */
+static inline bool cm4u_mbox_send(cm4u_mbox_t *mb, void *msg, uint32_t len)
+{
+    cm4u_msg_hdr_t *h = cm4u_msg__hdr(msg);
+    uint32_t head;
+
+    CM4U_ASSERT(len <= h->pool->payload_bytes);
+#if (CM4U_CFG_MSG_DEBUG != 0)
+    if (h->next != CM4U_MSG_OWNED) {
+        cm4u_msg__violation(msg);  /* sending a free or in-flight buffer */
+        return false;
+    }
+#endif
+    if (!cm4u_ring_reserve(&mb->head, &mb->tail, mb->mask + 1u, 1u, &mb->dropped, &head)) {
+        return false;
+    }
+
+    h->len = (uint16_t)len;
+#if (CM4U_CFG_MSG_DEBUG != 0)
+    h->check = cm4u_msg__checksum(msg, len);
+    h->next = CM4U_MSG_SENT;
+#endif
+    __DMB();  /* payload and header before the pointer */
+    mb->slot[head & mb->mask] = msg;  /* publish: ownership leaves the sender */
+    return true;
+}
+
+/* Take ownership of a received buffer */
+static inline void cm4u_mbox__accept(void *msg)
+{
+#if (CM4U_CFG_MSG_DEBUG != 0)
+    cm4u_msg_hdr_t *h = cm4u_msg__hdr(msg);
+    if ((h->next != CM4U_MSG_SENT) || (h->check != cm4u_msg__checksum(msg, h->len))) {
+        cm4u_msg__violation(msg);  /* written after send */
+    }
+    h->next = CM4U_MSG_OWNED;
+#else
+    (void)msg;
+#endif
+}
+
+/*
+ * Receive up to `max` messages into out[] (consumer context only). Returns
+ * how many; each one is now owned by the caller. Stops at a slot a
+ * preempted sender has reserved but not yet written.
+ */
+static inline uint32_t cm4u_mbox_recv_batch(cm4u_mbox_t *mb, void **out, uint32_t max)
+{
+    uint32_t tail = mb->tail;
+    uint32_t depth = mb->head - tail;
+    uint32_t n = 0u;
+
+    if (depth > mb->max_depth) {
+        mb->max_depth = depth;
+    }
+    if (max > depth) {
+        max = depth;
+    }
+    while (n < max) {
+        void *volatile *slot = &mb->slot[(tail + n) & mb->mask];
+        void *msg = *slot;
+        if (msg == 0) {
+            break;
+        }
+        *slot = 0;
+        out[n++] = msg;
+    }
+    if (n != 0u) {
+        __DMB();  /* read every payload pointer before the slots are reused */
+        mb->tail = tail + n;
+        for (uint32_t i = 0u; i < n; i++) {
+            cm4u_mbox__accept(out[i]);
+        }
+    }
+    return n;
+}
+
+/* Receive one message, 0 if none is ready */
+static inline void *cm4u_mbox_recv(cm4u_mbox_t *mb)
+{
+    void *msg = 0;
+    (void)cm4u_mbox_recv_batch(mb, &msg, 1u);
+    return msg;
+}
+
+/* Messages waiting (or being written) right now */
+static inline uint32_t cm4u_mbox_queued(const cm4u_mbox_t *mb)
+{
+    return mb->head - mb->tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_MSG_H */
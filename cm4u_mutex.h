@@ -0,0 +1,223 @@
+#ifndef CM4U_MUTEX_H
+#define CM4U_MUTEX_H
+
+/*
+ * Mutex with priority inheritance and priority-inversion detection, for
+ * code that runs at different NVIC priorities (ISRs, cm4u_kernel.h tasks,
+ * Thread mode).
+ *
+ * The uncontended path is a single LDREX/STREX pair for lock and another
+ * for unlock:
+ *
+ *   if (cm4u_mutex_lock(&i2c_mutex)) {
+ *       ...
+ *       cm4u_mutex_unlock(&i2c_mutex);
+ *   }
+ *
+ * Handlers cannot wait for a context they have preempted. So a contended
+ * lock from Handler mode does not block. It returns false and does three
+ * things:
+ *   - records the caller as a waiter,
+ *   - raises BASEPRI to the caller's priority (the inheritance). BASEPRI is
+ *     not stacked, so the preempted owner resumes at the waiter's priority,
+ *     and nothing between the two priorities can delay it any further,
+ *   - starts the blocking clock (DWT CYCCNT).
+ *
+ * The handler simply returns. cm4u_mutex_unlock() in the owner then
+ * restores BASEPRI and pends every waiter's vector again. The waiter
+ * re-runs and can lock. For a cm4u_task_t, leave the event handling to a
+ * later activation: keep state in ctx and return without consuming work.
+ *
+ * In Thread mode (fibers), a false return just means "try later":
+ *   CM4U_FIBER_WAIT(cm4u_mutex_lock(&m));
+ *
+ * Identities are exception numbers (0 = Thread mode, 16 + n = IRQn n). A
+ * waiter blocked longer than `inversion_cycles` counts as a priority
+ * inversion. The latest one is kept in `last_inversion` with owner, waiter
+ * and duration.
+ *
+ * Waiting needs a vector that can be pended again (PendSV, SysTick or an
+ * IRQ) and a priority that BASEPRI can express (1 or more). Other callers
+ * (SVCall, fault handlers, priority 0) are refused without inheritance. Locks are not recursive. Unlock
+ * in the context that locked, after undoing any BASEPRI changes made while
+ * holding the mutex.
+ */
+
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Distinct waiters remembered per mutex (one per preemption level) */
+#ifndef CM4U_MUTEX_MAX_WAITERS
+#define CM4U_MUTEX_MAX_WAITERS  4u
+#endif
+
+/* Exception number of Thread mode */
+#define CM4U_MUTEX_THREAD  0u
+
+typedef struct {
+    uint16_t owner;    /* exception number holding the mutex */
+    uint16_t waiter;   /* most urgent exception number that was kept waiting */
+    uint32_t cycles;   /* how long it waited */
+} cm4u_mutex_inversion_t;
+
+typedef struct {
+    volatile uint32_t owner;       /* exception number + 1 of the holder, 0 = free */
+
+    /* Contention (changed with interrupts masked) */
+    volatile uint32_t nwait;
+    uint16_t          waiter[CM4U_MUTEX_MAX_WAITERS];
+    uint32_t          wait_start;  /* CYCCNT when the first waiter arrived */
+    uint32_t          basepri;     /* owner's BASEPRI before inheritance */
+
+    /* Detection and statistics */
+    uint32_t          inversion_cycles;  /* threshold, 0 = every contention counts */
+    uint32_t          contentions;
+    uint32_t          inversions;
+    uint32_t          max_block_cycles;
+    uint32_t          waiter_overflow;   /* waiters beyond CM4U_MUTEX_MAX_WAITERS */
+    cm4u_mutex_inversion_t last_inversion;
+} cm4u_mutex_t;
+
+/* Flag waits longer than `inversion_cycles` as priority inversions */
+static inline void cm4u_mutex_init(cm4u_mutex_t *m, uint32_t inversion_cycles)
+{
+    uint8_t *p = (uint8_t *)m;
+    for (uint32_t i = 0u; i < sizeof(*m); i++) {
+        p[i] = 0u;
+    }
+    m->inversion_cycles = inversion_cycles;
+}
+
+/* Exception number that currently holds `m`, or -1 if it is free */
+static inline int32_t cm4u_mutex_owner(const cm4u_mutex_t *m)
+{
+    uint32_t o = m->owner;
+    return (o == 0u) ? -1 : (int32_t)(o - 1u);
+}
+
+/* Contended lock: register the caller, lend the owner its priority */
+static inline bool cm4u_mutex__wait(cm4u_mutex_t *m, uint32_t self)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+
+    if (m->owner == 0u) {
+        /* Released between our LDREX and here (Thread-mode fibers): try again later */
+        __set_PRIMASK(pm);
+        return false;
+    }
+    m->contentions++;
+    if (self == CM4U_MUTEX_THREAD) {
+        __set_PRIMASK(pm);
+        return false;  /* Thread mode is the lowest priority: nobody to boost */
+    }
+
+    if (self < 14u) {
+        __set_PRIMASK(pm);
+        return false;  /* SVCall, faults, NMI: cannot be pended again */
+    }
+    uint32_t prio = NVIC_GetPriority((IRQn_Type)((int32_t)self - 16)) << (8u - __NVIC_PRIO_BITS);
+    prio &= 0xFFu;
+    if (prio == 0u) {
+        __set_PRIMASK(pm);
+        return false;  /* priority 0: BASEPRI cannot express it */
+    }
+
+    uint32_t n = m->nwait;
+    bool known = false;
+    for (uint32_t i = 0u; i < n; i++) {
+        known = known || (m->waiter[i] == self);
+    }
+    if (!known) {
+        if (n == 0u) {
+            m->wait_start = cm4u_dwt_get_cycles();
+            m->basepri = __get_BASEPRI();
+        }
+        if (n < CM4U_MUTEX_MAX_WAITERS) {
+            m->waiter[n] = (uint16_t)self;
+            m->nwait = n + 1u;
+        } else {
+            m->waiter_overflow++;
+        }
+    }
+    __set_BASEPRI_MAX(prio);
+    __set_PRIMASK(pm);
+    return false;
+}
+
+/*
+ * Take `m`. Returns true when it is ours. False means it is held: from
+ * Handler mode, the caller's vector is pended again once it is released.
+ */
+static inline bool cm4u_mutex_lock(cm4u_mutex_t *m)
+{
+    uint32_t self = cm4u_get_exception_number();
+
+    do {
+        if (__LDREXW(&m->owner) != 0u) {
+            __CLREX();
+            return cm4u_mutex__wait(m, self);
+        }
+    } while (__STREXW(self + 1u, &m->owner) != 0u);
+    __DMB();
+    return true;
+}
+
+/* Contended unlock: account the wait, drop inheritance, wake the waiters */
+static inline void cm4u_mutex__release(cm4u_mutex_t *m)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t n = m->nwait;
+    uint32_t blocked = cm4u_dwt_get_cycles() - m->wait_start;
+    if (blocked > m->max_block_cycles) {
+        m->max_block_cycles = blocked;
+    }
+    if (blocked > m->inversion_cycles) {
+        m->inversions++;
+        m->last_inversion.owner = (uint16_t)(m->owner - 1u);
+        m->last_inversion.waiter = m->waiter[n - 1u];  /* the last to arrive preempted the rest */
+        m->last_inversion.cycles = blocked;
+    }
+
+    __DMB();
+    m->owner = 0u;
+    m->nwait = 0u;
+    for (uint32_t i = 0u; i < n; i++) {
+        uint32_t exc = m->waiter[i];
+        if (exc == 14u) {
+            SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+        } else if (exc == 15u) {
+            SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+        } else if (exc >= 16u) {
+            NVIC_SetPendingIRQ((IRQn_Type)((int32_t)exc - 16));
+        }
+    }
+    __set_BASEPRI(m->basepri);
+    __set_PRIMASK(pm);  /* the waiters preempt from here, most urgent first */
+}
+
+/* Release `m` (from the context that locked it) */
+static inline void cm4u_mutex_unlock(cm4u_mutex_t *m)
+{
+    CM4U_ASSERT(m->owner == (cm4u_get_exception_number() + 1u));
+    __DMB();
+    do {
+        (void)__LDREXW(&m->owner);
+        if (m->nwait != 0u) {
+            __CLREX();
+            cm4u_mutex__release(m);
+            return;
+        }
+    } while (__STREXW(0u, &m->owner) != 0u);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_MUTEX_H */
@@ -0,0 +1,326 @@
+#ifndef CM4U_PREEMPT_H
+#define CM4U_PREEMPT_H
+
+/*
+ * Exception preemption matrix: which handler preempts which, how often and
+ * for how long.
+ *
+ * Each instrumented handler brackets its body with CM4U_PREEMPT_ENTER() /
+ * CM4U_PREEMPT_EXIT(), or is wrapped with CM4U_PREEMPT_WRAP(). Enter reads
+ * the exception number (cm4u_get_exception_number()) and pushes it with a
+ * CYCCNT stamp on a nesting stack. Its victim is whatever was on top: Thread
+ * mode or the handler it preempted. Exit pops it and charges the elapsed
+ * cycles, including everything nested inside, to cell[victim][preemptor]:
+ *
+ *   count    preemptions of `victim` by `preemptor`
+ *   cycles   total cycles `victim` lost to them
+ *   max      the longest single one (the latency spike)
+ *
+ * plus the deepest nesting seen. Exceptions get matrix slots in the order
+ * they first run; slot 0 is Thread mode. The last slot is reserved: it
+ * collects the exceptions that found no free slot (exc[] =
+ * CM4U_PREEMPT_OTHER, as for slots not used yet).
+ *
+ *   CM4U_PREEMPT_WRAP(USART1_IRQHandler, usart1_isr)
+ *
+ *   void TIM2_IRQHandler(void)
+ *   {
+ *       CM4U_PREEMPT_ENTER();
+ *       ...
+ *       CM4U_PREEMPT_EXIT();
+ *   }
+ *
+ *   cm4u_preempt_reset();          // Thread mode, before enabling the IRQs
+ *   ...
+ *   static cm4u_preempt_t copy;
+ *   cm4u_preempt_snapshot(&copy);  // then send CM4U_PREEMPT_EXPORT_BYTES
+ *
+ * Every slot also keeps an execution profile for response-time analysis:
+ *
+ *   runs      activations
+ *   exec_max  longest run, the handlers nested inside it subtracted
+ *   gap_min   shortest time between two activations (entry to entry)
+ *   first / last  CYCCNT of the first and the latest activation
+ *   crit_max  longest critical section the context ran, taken through
+ *             CM4U_PREEMPT_CRITICAL_ENTER() / _EXIT() (nesting: outermost)
+ *
+ *   uint32_t key = CM4U_PREEMPT_CRITICAL_ENTER();
+ *   ...
+ *   CM4U_PREEMPT_CRITICAL_EXIT(key);
+ *
+ * These are cm4u_critical_enter() / _exit() plus the timing; the time a
+ * higher-priority handler steals from a BASEPRI section is not counted.
+ * The snapshot adds the NVIC priorities and PRIGROUP.
+ *
+ * The first CM4U_PREEMPT_EXPORT_BYTES of cm4u_preempt_t are little-endian
+ * 32-bit words (magic, slots, max_depth, overflow, exc[], cell[][], then
+ * prigroup, prio_bits, crit_mode, crit_basepri, prof[]). Dump them from the
+ * debugger or a UART and read them with tools/cm4u_preempt_report.py (the
+ * matrix) or tools/cm4u_rta.py (response times).
+ *
+ * Each enter / exit masks PRIMASK for a few instructions. The times leave out
+ * exception entry / exit and the handler code before CM4U_PREEMPT_ENTER().
+ * gap_min is measured at entry, so it includes release jitter: the rate it
+ * implies is an upper bound. CM4U_CFG_PREEMPT_SLOTS = 0 compiles the macros
+ * away (the critical-section macros fall back to cm4u_critical_enter() /
+ * _exit()).
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CM4U_PREEMPT_MAGIC  0x584D5250u  /* "PRMX" */
+#define CM4U_PREEMPT_OTHER  0xFFFFFFFFu  /* exc[] of the last and of unused slots */
+
+/* Timestamp source */
+#ifndef CM4U_PREEMPT_NOW
+#define CM4U_PREEMPT_NOW()  cm4u_dwt_get_cycles()
+#endif
+
+#if (CM4U_CFG_PREEMPT_SLOTS > 0)
+
+/* Nesting levels: one per preemption priority, plus NMI and HardFault */
+#define CM4U_PREEMPT_STACK  ((1u << __NVIC_PRIO_BITS) + 2u)
+
+typedef struct {
+    uint32_t count;   /* preemptions of the row by the column */
+    uint32_t cycles;  /* total cycles the row lost to them */
+    uint32_t max;     /* longest single preemption */
+} cm4u_preempt_cell_t;
+
+typedef struct {
+    int32_t  priority;    /* NVIC_GetPriority() (snapshot only; NMI -2, HardFault -1, Thread 0) */
+    uint32_t runs;        /* activations */
+    uint32_t exec_max;    /* longest run, nested handlers excluded */
+    uint32_t gap_min;     /* shortest entry-to-entry interval; 0 = fewer than two runs */
+    uint32_t first;       /* timestamp of the first activation */
+    uint32_t last;        /* timestamp of the latest activation */
+    uint32_t crit_max;    /* longest outermost critical section */
+    uint32_t crit_count;  /* critical sections timed */
+} cm4u_preempt_prof_t;
+
+typedef struct {
+    /* exported */
+    uint32_t magic;      /* CM4U_PREEMPT_MAGIC after cm4u_preempt_reset() */
+    uint32_t slots;      /* CM4U_CFG_PREEMPT_SLOTS */
+    uint32_t max_depth;  /* deepest nesting of instrumented handlers */
+    uint32_t overflow;   /* entries folded into the last slot, or nested too deep */
+    uint32_t exc[CM4U_CFG_PREEMPT_SLOTS];  /* exception number per slot; 0 = Thread */
+    cm4u_preempt_cell_t cell[CM4U_CFG_PREEMPT_SLOTS][CM4U_CFG_PREEMPT_SLOTS];  /* [victim][preemptor] */
+    uint32_t prigroup;      /* NVIC_GetPriorityGrouping() (snapshot only) */
+    uint32_t prio_bits;     /* __NVIC_PRIO_BITS */
+    uint32_t crit_mode;     /* CM4U_CFG_CRITICAL_MODE */
+    uint32_t crit_basepri;  /* CM4U_CFG_CRITICAL_BASEPRI (register value) */
+    cm4u_preempt_prof_t prof[CM4U_CFG_PREEMPT_SLOTS];
+
+    /* bookkeeping */
+    uint32_t used;       /* slots assigned */
+    uint32_t depth;      /* handlers on the stack */
+    uint8_t  stack_slot[CM4U_PREEMPT_STACK + 1u];   /* [0] = Thread */
+    uint32_t stack_start[CM4U_PREEMPT_STACK + 1u];
+    uint32_t stack_nested[CM4U_PREEMPT_STACK + 1u]; /* cycles of the handlers nested in each level */
+    uint32_t crit_start[CM4U_PREEMPT_STACK + 1u];   /* open critical section per level */
+    uint32_t crit_nested[CM4U_PREEMPT_STACK + 1u];  /* stack_nested[] when it opened */
+    uint8_t  map[256];   /* exception number -> slot, 0 = none yet */
+} cm4u_preempt_t;
+
+#define CM4U_PREEMPT_EXPORT_BYTES  ((uint32_t)offsetof(cm4u_preempt_t, used))
+
+__attribute__((weak)) cm4u_preempt_t cm4u_preempt;
+
+/* Clear the matrix; call in Thread mode */
+static inline void cm4u_preempt_reset(void)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    memset(&cm4u_preempt, 0, sizeof(cm4u_preempt));
+    for (uint32_t i = 1u; i < CM4U_CFG_PREEMPT_SLOTS; i++) {
+        cm4u_preempt.exc[i] = CM4U_PREEMPT_OTHER;
+    }
+    cm4u_preempt.slots = CM4U_CFG_PREEMPT_SLOTS;
+    cm4u_preempt.prio_bits = __NVIC_PRIO_BITS;
+    cm4u_preempt.crit_mode = CM4U_CFG_CRITICAL_MODE;
+    cm4u_preempt.crit_basepri = CM4U_CFG_CRITICAL_BASEPRI;
+    cm4u_preempt.used = 1u;
+    cm4u_preempt.magic = CM4U_PREEMPT_MAGIC;
+    __set_PRIMASK(pm);
+}
+
+/* Slot of exception `exc`, assigning one on first use; PRIMASK set */
+static inline uint32_t cm4u_preempt__slot(cm4u_preempt_t *p, uint32_t exc)
+{
+    if (exc > 255u) {
+        exc = 255u;
+    }
+    uint32_t s = p->map[exc];
+    if (s == 0u) {
+        if (p->used < (CM4U_CFG_PREEMPT_SLOTS - 1u)) {
+            s = p->used++;
+            p->exc[s] = exc;
+            p->map[exc] = (uint8_t)s;
+        } else {
+            s = CM4U_CFG_PREEMPT_SLOTS - 1u;
+            p->overflow++;
+        }
+    }
+    return s;
+}
+
+/* First statement of an instrumented handler */
+static inline void cm4u_preempt_enter(void)
+{
+    cm4u_preempt_t *p = &cm4u_preempt;
+    uint32_t exc = cm4u_get_exception_number();
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t d = p->depth + 1u;
+    p->depth = d;
+    if (d > p->max_depth) {
+        p->max_depth = d;
+    }
+    if (d <= CM4U_PREEMPT_STACK) {
+        uint32_t s = cm4u_preempt__slot(p, exc);
+        uint32_t now = CM4U_PREEMPT_NOW();
+        cm4u_preempt_prof_t *f = &p->prof[s];
+        if (f->runs == 0u) {
+            f->first = now;
+        } else if ((f->gap_min == 0u) || ((now - f->last) < f->gap_min)) {
+            f->gap_min = now - f->last;
+        }
+        f->runs++;
+        f->last = now;
+        p->stack_slot[d] = (uint8_t)s;
+        p->stack_start[d] = now;
+        p->stack_nested[d] = 0u;
+    } else {
+        p->overflow++;
+    }
+    __set_PRIMASK(pm);
+}
+
+/* Last statement of an instrumented handler */
+static inline void cm4u_preempt_exit(void)
+{
+    cm4u_preempt_t *p = &cm4u_preempt;
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t now = CM4U_PREEMPT_NOW();
+    uint32_t d = p->depth;
+    if ((d > 0u) && (d <= CM4U_PREEMPT_STACK)) {
+        uint32_t took = now - p->stack_start[d];
+        cm4u_preempt_cell_t *c = &p->cell[p->stack_slot[d - 1u]][p->stack_slot[d]];
+        c->count++;
+        c->cycles += took;
+        if (took > c->max) {
+            c->max = took;
+        }
+        cm4u_preempt_prof_t *f = &p->prof[p->stack_slot[d]];
+        if ((took - p->stack_nested[d]) > f->exec_max) {
+            f->exec_max = took - p->stack_nested[d];
+        }
+        p->stack_nested[d - 1u] += took;
+    }
+    if (d > 0u) {
+        p->depth = d - 1u;
+    }
+    __set_PRIMASK(pm);
+}
+
+/* Key of an outermost critical section (the mask was weaker before) */
+static inline bool cm4u_preempt__outermost(uint32_t key)
+{
+#if (CM4U_CFG_CRITICAL_MODE == CM4U_CRITICAL_BASEPRI)
+    return (key == 0u) || (key > (uint32_t)(CM4U_CFG_CRITICAL_BASEPRI));
+#else
+    return key == 0u;
+#endif
+}
+
+/* cm4u_critical_enter(), timed against the running context */
+static inline uint32_t cm4u_preempt_critical_enter(void)
+{
+    uint32_t key = cm4u_critical_enter();
+    cm4u_preempt_t *p = &cm4u_preempt;
+    uint32_t d = p->depth;
+    if (cm4u_preempt__outermost(key) && (d <= CM4U_PREEMPT_STACK)) {
+        /* Stamp first: a preemption in between inflates, never hides, the time */
+        p->crit_start[d] = CM4U_PREEMPT_NOW();
+        p->crit_nested[d] = p->stack_nested[d];
+    }
+    return key;
+}
+
+/* cm4u_critical_exit(), charging the section to the running context */
+static inline void cm4u_preempt_critical_exit(uint32_t key)
+{
+    cm4u_preempt_t *p = &cm4u_preempt;
+    uint32_t d = p->depth;
+    if (cm4u_preempt__outermost(key) && (d <= CM4U_PREEMPT_STACK)) {
+        uint32_t took = (CM4U_PREEMPT_NOW() - p->crit_start[d]) - (p->stack_nested[d] - p->crit_nested[d]);
+        cm4u_preempt_prof_t *f = &p->prof[p->stack_slot[d]];
+        if (took > f->crit_max) {
+            f->crit_max = took;
+        }
+        f->crit_count++;
+    }
+    cm4u_critical_exit(key);
+}
+
+/* Consistent copy of the whole record (masks PRIMASK for the copy), completed with priorities */
+static inline void cm4u_preempt_snapshot(cm4u_preempt_t *out)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    memcpy(out, &cm4u_preempt, CM4U_PREEMPT_EXPORT_BYTES);
+    __set_PRIMASK(pm);
+
+    out->prigroup = NVIC_GetPriorityGrouping();
+    for (uint32_t i = 0u; i < CM4U_CFG_PREEMPT_SLOTS; i++) {
+        uint32_t exc = out->exc[i];
+        if (exc == 2u) {
+            out->prof[i].priority = -2;
+        } else if (exc == 3u) {
+            out->prof[i].priority = -1;
+        } else if ((exc >= 4u) && (exc != CM4U_PREEMPT_OTHER)) {
+            out->prof[i].priority = (int32_t)NVIC_GetPriority((IRQn_Type)((int32_t)exc - 16));
+        }
+    }
+}
+
+#define CM4U_PREEMPT_ENTER()  cm4u_preempt_enter()
+#define CM4U_PREEMPT_EXIT()   cm4u_preempt_exit()
+#define CM4U_PREEMPT_CRITICAL_ENTER()     cm4u_preempt_critical_enter()
+#define CM4U_PREEMPT_CRITICAL_EXIT(key)   cm4u_preempt_critical_exit(key)
+
+#else /* CM4U_CFG_PREEMPT_SLOTS == 0 */
+
+#define CM4U_PREEMPT_ENTER()  ((void)0)
+#define CM4U_PREEMPT_EXIT()   ((void)0)
+#define CM4U_PREEMPT_CRITICAL_ENTER()     cm4u_critical_enter()
+#define CM4U_PREEMPT_CRITICAL_EXIT(key)   cm4u_critical_exit(key)
+
+static inline void cm4u_preempt_reset(void)
+{
+}
+
+#endif /* CM4U_CFG_PREEMPT_SLOTS */
+
+/* Define vector `handler` as `fn()` bracketed by enter / exit */
+#define CM4U_PREEMPT_WRAP(handler, fn)  \
+    void handler(void)                  \
+    {                                   \
+        CM4U_PREEMPT_ENTER();           \
+        fn();                           \
+        CM4U_PREEMPT_EXIT();            \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_PREEMPT_H */
@@ -0,0 +1,304 @@
+#ifndef CM4U_SNAPSHOT_H
+#define CM4U_SNAPSHOT_H
+
+/*
+ * Core-state snapshot for fast warm restarts.
+ *
+ * After the first (cold) bring-up, cm4u_snapshot_save() copies the core
+ * configuration into a struct in retained RAM:
+ *
+ *   - NVIC priorities (IP[]) and enables (ISER)
+ *   - VTOR, PRIGROUP, SCR, CCR, SHCSR fault enables, system handler priorities
+ *   - SysTick LOAD / CTRL
+ *   - DEMCR / DWT_CTRL
+ *   - MPU_CTRL and every MPU region
+ *
+ * After a watchdog or cm4u_system_reset() the struct survives (it is not in
+ * .data/.bss), so the boot code can check it and replay it with word
+ * stores instead of redoing the whole NVIC_SetPriority() / MPU set-up:
+ *
+ *   static cm4u_snapshot_t boot_state CM4U_SNAPSHOT_RETAINED;
+ *
+ *   if (!cm4u_snapshot_try_restore(&boot_state)) {
+ *       full_core_init();
+ *       cm4u_snapshot_save(&boot_state, CM4U_SNAPSHOT_ALL);
+ *   }
+ *
+ * Only core registers are covered; device clocks and peripherals still need
+ * their own (warm) init. Call cm4u_snapshot_invalidate() whenever the core
+ * configuration is changed on purpose, so the next reset does a cold init.
+ * bench/bench_snapshot.c measures cold init against the restore. Its host
+ * numbers only count register accesses; the saving has to be measured on
+ * QEMU or the target.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Device IRQs covered (multiple of 32, at most 224) */
+#ifndef CM4U_SNAPSHOT_NUM_IRQS
+#define CM4U_SNAPSHOT_NUM_IRQS 96u
+#endif
+
+/* MPU regions covered (Cortex-M4: 8) */
+#ifndef CM4U_SNAPSHOT_MPU_REGIONS
+#define CM4U_SNAPSHOT_MPU_REGIONS 8u
+#endif
+
+#if ((CM4U_SNAPSHOT_NUM_IRQS % 32u) != 0u) || (CM4U_SNAPSHOT_NUM_IRQS > 224u)
+#error "CM4U_SNAPSHOT_NUM_IRQS must be a multiple of 32, at most 224"
+#endif
+
+/* Placement for the snapshot: a NOLOAD section the startup code leaves alone */
+#ifndef CM4U_SNAPSHOT_RETAINED
+#define CM4U_SNAPSHOT_RETAINED CM4U_NOINIT
+#endif
+
+#define CM4U_SNAPSHOT_MAGIC    0x534E5032u  /* "SNP2", bump when the layout changes */
+
+/* Parts to capture / replay (cm4u_snapshot_save() `parts`) */
+#define CM4U_SNAPSHOT_NVIC     (1u << 0)
+#define CM4U_SNAPSHOT_SCB      (1u << 1)
+#define CM4U_SNAPSHOT_SYSTICK  (1u << 2)
+#define CM4U_SNAPSHOT_DWT      (1u << 3)
+#define CM4U_SNAPSHOT_MPU      (1u << 4)
+#define CM4U_SNAPSHOT_ALL      (0x1Fu)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;        /* sizeof(cm4u_snapshot_t) of the firmware that saved it */
+    uint32_t parts;       /* CM4U_SNAPSHOT_* captured */
+
+    /* SCB */
+    uint32_t vtor;
+    uint32_t aircr;       /* PRIGROUP only, VECTKEY added on restore */
+    uint32_t scr;
+    uint32_t ccr;
+    uint32_t shcsr;       /* MEM/BUS/USGFAULTENA */
+    uint32_t shp[3];      /* SHP[0..11] as words */
+
+    /* NVIC */
+    uint32_t iser[CM4U_SNAPSHOT_NUM_IRQS / 32u];
+    uint32_t ip[CM4U_SNAPSHOT_NUM_IRQS / 4u];
+
+    /* SysTick, DWT */
+    uint32_t systick_load;
+    uint32_t systick_ctrl;
+    uint32_t demcr;
+    uint32_t dwt_ctrl;
+
+    /* MPU */
+    uint32_t mpu_ctrl;
+    uint32_t mpu_regions; /* regions implemented (MPU_TYPE.DREGION, capped) */
+    uint32_t mpu_rbar[CM4U_SNAPSHOT_MPU_REGIONS];
+    uint32_t mpu_rasr[CM4U_SNAPSHOT_MPU_REGIONS];
+
+    uint32_t check;       /* cm4u_snapshot_checksum() of everything above */
+} cm4u_snapshot_t;
+
+/*
+ * Word-wise check: a Fletcher-style pair of 32-bit sums, two adds per word.
+ * `b` weights each word by its position, so swapped or shifted words are
+ * caught as well as flipped bits. Far weaker than a CRC against crafted
+ * damage, but the snapshot only has to catch lost retention and layout
+ * changes, and the check runs on every warm boot.
+ */
+static inline uint32_t cm4u_snapshot_checksum(const uint32_t *words, uint32_t n)
+{
+    uint32_t a = 0xFFFFFFFFu;  /* all-zero RAM must not check out */
+    uint32_t b = 0u;
+    for (uint32_t i = 0u; i < n; i++) {
+        a += words[i];
+        b += a;
+    }
+    return a ^ ((b << 16) | (b >> 16));
+}
+
+static inline uint32_t cm4u_snapshot__check(const cm4u_snapshot_t *s)
+{
+    return cm4u_snapshot_checksum((const uint32_t *)(const void *)s,
+                                  (uint32_t)(offsetof(cm4u_snapshot_t, check) / sizeof(uint32_t)));
+}
+
+/* Does `s` hold a snapshot written by this firmware layout? */
+static inline bool cm4u_snapshot_valid(const cm4u_snapshot_t *s)
+{
+    return (s->magic == CM4U_SNAPSHOT_MAGIC) &&
+           (s->size == (uint32_t)sizeof(cm4u_snapshot_t)) &&
+           (s->check == cm4u_snapshot__check(s));
+}
+
+/* Forget the snapshot: the next boot takes the cold path */
+static inline void cm4u_snapshot_invalidate(cm4u_snapshot_t *s)
+{
+    s->magic = 0u;
+    s->check = 0u;
+}
+
+/* Capture the current core configuration (`parts` = CM4U_SNAPSHOT_* mask) */
+static inline void cm4u_snapshot_save(cm4u_snapshot_t *s, uint32_t parts)
+{
+    memset((void *)s, 0, sizeof(*s));
+    s->magic = CM4U_SNAPSHOT_MAGIC;
+    s->size  = (uint32_t)sizeof(cm4u_snapshot_t);
+
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+
+    if ((parts & CM4U_SNAPSHOT_SCB) != 0u) {
+        const volatile uint32_t *shp = (const volatile uint32_t *)(const volatile void *)&SCB->SHP[0];
+        s->vtor  = SCB->VTOR;
+        s->aircr = SCB->AIRCR & SCB_AIRCR_PRIGROUP_Msk;
+        s->scr   = SCB->SCR;
+        s->ccr   = SCB->CCR;
+        s->shcsr = SCB->SHCSR & (SCB_SHCSR_USGFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk |
+                                 SCB_SHCSR_MEMFAULTENA_Msk);
+        for (uint32_t i = 0u; i < 3u; i++) {
+            s->shp[i] = shp[i];
+        }
+    }
+
+    if ((parts & CM4U_SNAPSHOT_NVIC) != 0u) {
+        const volatile uint32_t *ip = (const volatile uint32_t *)(const volatile void *)&NVIC->IP[0];
+        for (uint32_t i = 0u; i < (CM4U_SNAPSHOT_NUM_IRQS / 32u); i++) {
+            s->iser[i] = NVIC->ISER[i];
+        }
+        for (uint32_t i = 0u; i < (CM4U_SNAPSHOT_NUM_IRQS / 4u); i++) {
+            s->ip[i] = ip[i];
+        }
+    }
+
+    if ((parts & CM4U_SNAPSHOT_SYSTICK) != 0u) {
+        s->systick_load = SysTick->LOAD;
+        s->systick_ctrl = SysTick->CTRL & (SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk |
+                                           SysTick_CTRL_ENABLE_Msk);
+    }
+
+#if defined(DWT) && defined(CoreDebug)
+    if ((parts & CM4U_SNAPSHOT_DWT) != 0u) {
+        s->demcr    = CoreDebug->DEMCR;
+        s->dwt_ctrl = DWT->CTRL;
+    }
+#endif
+
+#if defined(MPU)
+    if ((parts & CM4U_SNAPSHOT_MPU) != 0u) {
+        uint32_t regions = (MPU->TYPE & MPU_TYPE_DREGION_Msk) >> MPU_TYPE_DREGION_Pos;
+        if (regions > CM4U_SNAPSHOT_MPU_REGIONS) {
+            regions = CM4U_SNAPSHOT_MPU_REGIONS;
+        }
+        s->mpu_ctrl    = MPU->CTRL;
+        s->mpu_regions = regions;
+        for (uint32_t r = 0u; r < regions; r++) {
+            MPU->RNR = r;
+            s->mpu_rbar[r] = MPU->RBAR & MPU_RBAR_ADDR_Msk;
+            s->mpu_rasr[r] = MPU->RASR;
+        }
+    }
+#endif
+
+    __set_PRIMASK(pm);
+
+    s->parts = parts;
+    s->check = cm4u_snapshot__check(s);
+}
+
+/*
+ * Replay a snapshot with interrupts masked. Priorities go in before the
+ * enables, and the MPU is off while its regions are rewritten. Expects the
+ * core to be in its reset state (nothing else enabled yet).
+ */
+static inline void cm4u_snapshot_restore(const cm4u_snapshot_t *s)
+{
+    uint32_t parts = s->parts;
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+
+    if ((parts & CM4U_SNAPSHOT_SCB) != 0u) {
+        volatile uint32_t *shp = (volatile uint32_t *)(volatile void *)&SCB->SHP[0];
+        SCB->VTOR  = s->vtor;
+        SCB->AIRCR = (0x5FAUL << SCB_AIRCR_VECTKEY_Pos) | s->aircr;
+        for (uint32_t i = 0u; i < 3u; i++) {
+            shp[i] = s->shp[i];
+        }
+        SCB->CCR   = s->ccr;
+        SCB->SHCSR = s->shcsr;
+    }
+
+    if ((parts & CM4U_SNAPSHOT_DWT) != 0u) {
+#if defined(DWT) && defined(CoreDebug)
+        CoreDebug->DEMCR = s->demcr;
+        DWT->CTRL        = s->dwt_ctrl;
+#endif
+    }
+
+#if defined(MPU)
+    if ((parts & CM4U_SNAPSHOT_MPU) != 0u) {
+        MPU->CTRL = 0u;
+        __DMB();
+        for (uint32_t r = 0u; r < s->mpu_regions; r++) {
+            MPU->RBAR = s->mpu_rbar[r] | MPU_RBAR_VALID_Msk | r;  /* selects region r */
+            MPU->RASR = s->mpu_rasr[r];
+        }
+        MPU->CTRL = s->mpu_ctrl;
+    }
+#endif
+
+    if ((parts & CM4U_SNAPSHOT_SYSTICK) != 0u) {
+        SysTick->LOAD = s->systick_load;
+        SysTick->VAL  = 0u;
+        SysTick->CTRL = s->systick_ctrl;
+    }
+
+    if ((parts & CM4U_SNAPSHOT_NVIC) != 0u) {
+        volatile uint32_t *ip = (volatile uint32_t *)(volatile void *)&NVIC->IP[0];
+        for (uint32_t i = 0u; i < (CM4U_SNAPSHOT_NUM_IRQS / 4u); i++) {
+            ip[i] = s->ip[i];
+        }
+        /* Set / clear only the bits that differ, one NVIC_*IRQ() call each */
+        for (uint32_t i = 0u; i < (CM4U_SNAPSHOT_NUM_IRQS / 32u); i++) {
+            uint32_t now = NVIC->ISER[i];
+            uint32_t off = now & ~s->iser[i];
+            uint32_t on  = s->iser[i] & ~now;
+            while (off != 0u) {
+                uint32_t b = (uint32_t)__CLZ(__RBIT(off));
+                NVIC_DisableIRQ((IRQn_Type)((i << 5) + b));
+                off &= off - 1u;
+            }
+            while (on != 0u) {
+                uint32_t b = (uint32_t)__CLZ(__RBIT(on));
+                NVIC_EnableIRQ((IRQn_Type)((i << 5) + b));
+                on &= on - 1u;
+            }
+        }
+    }
+
+    if ((parts & CM4U_SNAPSHOT_SCB) != 0u) {
+        SCB->SCR = s->scr;  /* last: SLEEPONEXIT must not fire half-configured */
+    }
+
+    __DSB();
+    __ISB();
+    __set_PRIMASK(pm);
+}
+
+/* Warm-boot entry point: replay `s` if it is intact, else return false */
+static inline bool cm4u_snapshot_try_restore(const cm4u_snapshot_t *s)
+{
+    if (!cm4u_snapshot_valid(s)) {
+        return false;
+    }
+    cm4u_snapshot_restore(s);
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_SNAPSHOT_H */
@@ -0,0 +1,406 @@
+#ifndef CM4U_STACK_H
+#define CM4U_STACK_H
+
+/*
+ * Worst-case MSP depth across interrupt priority levels.
+ *
+ * Every handler runs on the one MSP, and a handler can be preempted by any
+ * handler of a higher preemption priority. So the worst case is one handler
+ * from each priority level stacked on top of each other, on top of Thread
+ * mode's own MSP use. This header measures each handler's share and adds
+ * them up:
+ *
+ *   frame   exception frame pushed on entry: 32 bytes, 104 with FP state
+ *           (EXC_RETURN bit 4), +4 when the SP had to be realigned
+ *   body    what the handler itself used below the frame: prologue, locals,
+ *           callees. At CM4U_STACK_ENTER() the handler paints
+ *           CM4U_CFG_STACK_WINDOW bytes below its SP, and at
+ *           CM4U_STACK_EXIT() it finds the deepest word that changed.
+ *           Runs that were preempted also see the nested handlers' frames;
+ *           they are kept apart (body_nested) and used only when a handler
+ *           never ran undisturbed.
+ *   thread  MSP depth of Thread mode at the moments it was preempted
+ *
+ *   CM4U_STACK_WRAP(ADC_IRQHandler, adc_isr)
+ *
+ *   void TIM2_IRQHandler(void)
+ *   {
+ *       CM4U_STACK_ENTER();
+ *       ...
+ *       CM4U_STACK_EXIT();
+ *   }
+ *
+ *   cm4u_stack_init((uint32_t)&__StackLimit, (uint32_t)&__StackTop);  // paints the MSP
+ *   ...
+ *   static cm4u_stack_t copy;
+ *   cm4u_stack_snapshot(&copy);     // adds NVIC priorities and the painted high water
+ *   uint32_t worst = cm4u_stack_estimate(&copy, true);   // FP frames everywhere
+ *
+ * cm4u_stack_estimate() takes, per preemption priority (NVIC priority with
+ * PRIGROUP applied), the largest frame + body, and adds Thread's share.
+ * With `fp_frames` every frame counts as a 108-byte FP frame. Any context
+ * that has used the FPU gets one, even if it was not observed. Compare the
+ * result with the reserved size (top - limit) and with the painted high
+ * water (`used`), which is only what actually happened. Window repaints
+ * would erase part of that history, so each handler scans its window
+ * before repainting it, and the deepest word found there is kept apart.
+ *
+ * The first CM4U_STACK_EXPORT_BYTES of cm4u_stack_t are little-endian
+ * 32-bit words; tools/cm4u_stack_report.py reads a dump of them and prints
+ * the per-level breakdown. CM4U_CFG_STACK_SLOTS = 0 compiles the macros
+ * away.
+ *
+ * Cost: painting and scanning the window, CM4U_CFG_STACK_WINDOW / 4 words
+ * each (the scan before painting stops at the known high water), outside
+ * any mask; the bookkeeping masks PRIMASK for a few
+ * instructions. The macros must expand in the handler itself: they read its
+ * CFA (the SP right after stacking) and its LR (EXC_RETURN).
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CM4U_STACK_MAGIC  0x4B545350u  /* "PSTK" */
+#define CM4U_STACK_PAINT  0xA5A5A5A5u
+
+/* Stack word at address `addr` (the host bench maps these onto an array) */
+#ifndef CM4U_STACK_WORD
+#define CM4U_STACK_WORD(addr)  (*(volatile uint32_t *)(uintptr_t)(addr))
+#endif
+
+/* The handler's SP right after exception entry, and its EXC_RETURN */
+#if defined(CM4U_HOST)
+#define CM4U_STACK_FRAME_SP()    __get_MSP()
+#define CM4U_STACK_EXC_RETURN()  (cm4u_host()->exc_return)
+#else
+#define CM4U_STACK_FRAME_SP()    ((uint32_t)(uintptr_t)__builtin_dwarf_cfa())
+#define CM4U_STACK_EXC_RETURN()  ((uint32_t)(uintptr_t)__builtin_return_address(0))
+#endif
+
+/* Frame assumed by cm4u_stack_estimate(fp_frames): FP frame + alignment pad */
+#define CM4U_STACK_FRAME_FP  108u
+
+#if (CM4U_CFG_STACK_SLOTS > 0)
+
+/* Nesting levels: one per preemption priority, plus NMI and HardFault */
+#define CM4U_STACK_NEST  ((1u << __NVIC_PRIO_BITS) + 2u)
+
+typedef struct {
+    uint32_t exc;          /* exception number */
+    int32_t  priority;     /* NVIC_GetPriority() (snapshot only; NMI -2, HardFault -1) */
+    uint32_t frame_max;    /* largest frame seen, bytes */
+    uint32_t body_clean;   /* deepest use below the frame, runs not preempted */
+    uint32_t body_nested;  /* the same for preempted runs (includes nested frames) */
+    uint32_t runs_clean;
+    uint32_t runs_nested;
+    uint32_t saturated;    /* clean runs that used the whole window */
+} cm4u_stack_isr_t;
+
+typedef struct {
+    /* exported */
+    uint32_t magic;        /* CM4U_STACK_MAGIC after cm4u_stack_init() */
+    uint32_t slots;        /* CM4U_CFG_STACK_SLOTS */
+    uint32_t prigroup;     /* NVIC_GetPriorityGrouping() (snapshot only) */
+    uint32_t prio_bits;    /* __NVIC_PRIO_BITS */
+    uint32_t limit;        /* lowest MSP address */
+    uint32_t top;          /* initial MSP */
+    uint32_t used;         /* painted high water, bytes (snapshot only) */
+    uint32_t thread_max;   /* Thread mode's MSP use when preempted, bytes */
+    uint32_t max_depth;    /* deepest nesting of instrumented handlers */
+    uint32_t overflow;     /* handlers without a slot, or nested too deep */
+    uint32_t window;       /* CM4U_CFG_STACK_WINDOW */
+    uint32_t fpu;          /* 1 = CP10/CP11 enabled (snapshot only) */
+    cm4u_stack_isr_t isr[CM4U_CFG_STACK_SLOTS];
+
+    /* bookkeeping */
+    uint32_t depth;
+    uint32_t low;          /* deepest word seen dirty before a window repaint */
+    struct {
+        uint32_t slot;     /* CM4U_CFG_STACK_SLOTS = none */
+        uint32_t frame_sp; /* SP right after stacking */
+        uint32_t sp;       /* SP when the window was painted */
+        uint32_t bottom;   /* window bottom */
+        uint32_t nested;   /* preempted while running */
+    } level[CM4U_STACK_NEST + 1u];  /* [0] = Thread */
+} cm4u_stack_t;
+
+#define CM4U_STACK_EXPORT_BYTES  ((uint32_t)offsetof(cm4u_stack_t, depth))
+
+__attribute__((weak)) cm4u_stack_t cm4u_stack;
+
+static inline void cm4u_stack__paint(uint32_t from, uint32_t to)
+{
+    for (uint32_t a = from; a < to; a += 4u) {
+        CM4U_STACK_WORD(a) = CM4U_STACK_PAINT;
+    }
+}
+
+/* First address in [from, to) that is not paint, or `to` */
+static inline uint32_t cm4u_stack__dirty(uint32_t from, uint32_t to)
+{
+    uint32_t a = from;
+    while ((a < to) && (CM4U_STACK_WORD(a) == CM4U_STACK_PAINT)) {
+        a += 4u;
+    }
+    return a;
+}
+
+/*
+ * Paint the free MSP below the caller and clear the record; Thread mode,
+ * before enabling the IRQs. `limit` / `top`: the MSP region (8-byte aligned).
+ */
+static inline void cm4u_stack_init(uint32_t limit, uint32_t top)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    memset(&cm4u_stack, 0, sizeof(cm4u_stack));
+    cm4u_stack.slots = CM4U_CFG_STACK_SLOTS;
+    cm4u_stack.prio_bits = __NVIC_PRIO_BITS;
+    cm4u_stack.limit = limit;
+    cm4u_stack.top = top;
+    cm4u_stack.window = CM4U_CFG_STACK_WINDOW;
+    cm4u_stack.low = top;
+    cm4u_stack.level[0].slot = CM4U_CFG_STACK_SLOTS;
+    cm4u_stack__paint(limit, __get_MSP() & ~3u);
+    cm4u_stack.magic = CM4U_STACK_MAGIC;
+    __set_PRIMASK(pm);
+}
+
+/* Keep the deepest dirty word of [from, to) before it is repainted */
+static inline void cm4u_stack__keep(cm4u_stack_t *s, uint32_t from, uint32_t to)
+{
+    if (to > s->low) {
+        to = s->low;  /* nothing above the known high water can be deeper */
+    }
+    uint32_t a = cm4u_stack__dirty(from, to);
+    if (a < to) {
+        uint32_t pm = __get_PRIMASK();
+        __disable_irq();
+        if (a < s->low) {
+            s->low = a;
+        }
+        __set_PRIMASK(pm);
+    }
+}
+
+/* Record of exception `exc`, assigning a slot on first use; PRIMASK set */
+static inline uint32_t cm4u_stack__slot(cm4u_stack_t *s, uint32_t exc)
+{
+    for (uint32_t i = 0u; i < CM4U_CFG_STACK_SLOTS; i++) {
+        if (s->isr[i].exc == exc) {
+            return i;
+        }
+        if (s->isr[i].exc == 0u) {
+            s->isr[i].exc = exc;
+            return i;
+        }
+    }
+    s->overflow++;
+    return CM4U_CFG_STACK_SLOTS;
+}
+
+static inline void cm4u_stack_enter(uint32_t frame_sp, uint32_t exc_return)
+{
+    cm4u_stack_t *s = &cm4u_stack;
+    uint32_t exc = cm4u_get_exception_number();
+    uint32_t frame = ((exc_return & 0x10u) != 0u) ? 32u : 104u;
+#if !defined(CM4U_HOST)
+    if ((CM4U_STACK_WORD(frame_sp + 28u) & (1u << 9)) != 0u) {
+        frame += 4u;  /* stacked xPSR bit 9: SP was realigned */
+    }
+#endif
+
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t d = s->depth + 1u;
+    s->depth = d;
+    if (d > s->max_depth) {
+        s->max_depth = d;
+    }
+    if (d > CM4U_STACK_NEST) {
+        s->overflow++;
+        __set_PRIMASK(pm);
+        return;
+    }
+    s->level[d - 1u].nested = 1u;
+    uint32_t slot = cm4u_stack__slot(s, exc);
+    if (slot < CM4U_CFG_STACK_SLOTS) {
+        if (frame > s->isr[slot].frame_max) {
+            s->isr[slot].frame_max = frame;
+        }
+    }
+    /* From Thread on MSP: how deep Thread was */
+    if ((exc_return & 0xCu) == 0x8u) {
+        uint32_t thread = s->top - (frame_sp + frame);
+        if (thread > s->thread_max) {
+            s->thread_max = thread;
+        }
+    }
+    uint32_t sp = __get_MSP() & ~3u;
+    uint32_t bottom = (sp - s->limit > CM4U_CFG_STACK_WINDOW) ? sp - CM4U_CFG_STACK_WINDOW : s->limit;
+    s->level[d].slot = slot;
+    s->level[d].frame_sp = frame_sp;
+    s->level[d].sp = sp;
+    s->level[d].bottom = bottom;
+    s->level[d].nested = 0u;
+    __set_PRIMASK(pm);
+
+    cm4u_stack__keep(s, bottom, sp);
+    cm4u_stack__paint(bottom, sp);
+}
+
+static inline void cm4u_stack_exit(void)
+{
+    cm4u_stack_t *s = &cm4u_stack;
+    uint32_t d = s->depth;
+    if ((d == 0u) || (d > CM4U_STACK_NEST)) {
+        uint32_t pm = __get_PRIMASK();
+        __disable_irq();
+        if (d > 0u) {
+            s->depth = d - 1u;
+        }
+        __set_PRIMASK(pm);
+        return;
+    }
+    uint32_t deepest = cm4u_stack__dirty(s->level[d].bottom, s->level[d].sp);
+    uint32_t body = s->level[d].frame_sp - deepest;
+
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t slot = s->level[d].slot;
+    if (slot < CM4U_CFG_STACK_SLOTS) {
+        cm4u_stack_isr_t *r = &s->isr[slot];
+        if (s->level[d].nested != 0u) {
+            r->runs_nested++;
+            if (body > r->body_nested) {
+                r->body_nested = body;
+            }
+        } else {
+            r->runs_clean++;
+            if (body > r->body_clean) {
+                r->body_clean = body;
+            }
+            if (deepest == s->level[d].bottom) {
+                r->saturated++;
+            }
+        }
+    }
+    s->depth = d - 1u;
+    __set_PRIMASK(pm);
+}
+
+/* Painted MSP high water, bytes, including what window repaints erased */
+static inline uint32_t cm4u_stack_used(void)
+{
+    uint32_t a = cm4u_stack__dirty(cm4u_stack.limit, cm4u_stack.top);
+    if (cm4u_stack.low < a) {
+        a = cm4u_stack.low;
+    }
+    return cm4u_stack.top - a;
+}
+
+/* Copy of the exported record, completed with priorities and the painted high water */
+static inline void cm4u_stack_snapshot(cm4u_stack_t *out)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    memcpy(out, &cm4u_stack, CM4U_STACK_EXPORT_BYTES);
+    __set_PRIMASK(pm);
+
+    out->prigroup = NVIC_GetPriorityGrouping();
+    out->used = cm4u_stack_used();
+    out->fpu = ((SCB->CPACR & (0xFu << 20)) != 0u) ? 1u : 0u;
+    for (uint32_t i = 0u; i < CM4U_CFG_STACK_SLOTS; i++) {
+        uint32_t exc = out->isr[i].exc;
+        if (exc == 2u) {
+            out->isr[i].priority = -2;
+        } else if (exc == 3u) {
+            out->isr[i].priority = -1;
+        } else if (exc >= 4u) {
+            out->isr[i].priority = (int32_t)NVIC_GetPriority((IRQn_Type)((int32_t)exc - 16));
+        }
+    }
+}
+
+/* Preemption priority of a snapshot record (PRIGROUP applied) */
+static inline int32_t cm4u_stack_group(const cm4u_stack_t *s, const cm4u_stack_isr_t *r)
+{
+    if (r->priority < 0) {
+        return r->priority;
+    }
+    uint32_t group = s->prigroup & 7u;
+    uint32_t sub = ((group + s->prio_bits) < 7u) ? 0u : (group - 7u) + s->prio_bits;
+    return r->priority >> sub;
+}
+
+/* Bytes one run of `r` needs: frame + body */
+static inline uint32_t cm4u_stack_need(const cm4u_stack_isr_t *r, bool fp_frames)
+{
+    uint32_t frame = fp_frames ? CM4U_STACK_FRAME_FP : r->frame_max;
+    return frame + ((r->runs_clean != 0u) ? r->body_clean : r->body_nested);
+}
+
+/*
+ * Worst-case MSP bytes from a snapshot: Thread's share plus, per preemption
+ * priority, the largest need of that level's handlers.
+ */
+static inline uint32_t cm4u_stack_estimate(const cm4u_stack_t *s, bool fp_frames)
+{
+    uint32_t total = s->thread_max;
+    for (uint32_t i = 0u; i < CM4U_CFG_STACK_SLOTS; i++) {
+        const cm4u_stack_isr_t *r = &s->isr[i];
+        if (r->exc == 0u) {
+            break;
+        }
+        /* Count a level once, at its neediest handler (first one on ties) */
+        int32_t g = cm4u_stack_group(s, r);
+        uint32_t need = cm4u_stack_need(r, fp_frames);
+        bool top = true;
+        for (uint32_t j = 0u; (j < CM4U_CFG_STACK_SLOTS) && (s->isr[j].exc != 0u) && top; j++) {
+            if ((j != i) && (cm4u_stack_group(s, &s->isr[j]) == g)) {
+                uint32_t other = cm4u_stack_need(&s->isr[j], fp_frames);
+                top = (other < need) || ((other == need) && (j > i));
+            }
+        }
+        if (top) {
+            total += need;
+        }
+    }
+    return total;
+}
+
+#define CM4U_STACK_ENTER()  cm4u_stack_enter(CM4U_STACK_FRAME_SP(), CM4U_STACK_EXC_RETURN())
+#define CM4U_STACK_EXIT()   cm4u_stack_exit()
+
+#else /* CM4U_CFG_STACK_SLOTS == 0 */
+
+#define CM4U_STACK_ENTER()  ((void)0)
+#define CM4U_STACK_EXIT()   ((void)0)
+
+static inline void cm4u_stack_init(uint32_t limit, uint32_t top)
+{
+    (void)limit;
+    (void)top;
+}
+
+#endif /* CM4U_CFG_STACK_SLOTS */
+
+/* Define vector `handler` as `fn()` bracketed by enter / exit */
+#define CM4U_STACK_WRAP(handler, fn)  \
+    void handler(void)                \
+    {                                 \
+        CM4U_STACK_ENTER();           \
+        fn();                         \
+        CM4U_STACK_EXIT();            \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_STACK_H */
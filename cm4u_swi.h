@@ -0,0 +1,182 @@
+#ifndef CM4U_SWI_H
+#define CM4U_SWI_H
+
+/*
+ * Software-interrupt levels on spare NVIC vectors.
+ *
+ * PendSV is a single deferred level. Any device IRQ the application does
+ * not use works just as well as a software interrupt, at any priority, so
+ * a handful of them make a ladder of preemptible deferred-work levels.
+ * The NVIC then does the scheduling: posting to a more urgent level
+ * preempts at once, and posting to a less urgent one runs when everything
+ * above it has returned. There is no scheduler code and no extra stack.
+ *
+ *   static cm4u_swi_t swi[3];
+ *   static const IRQn_Type swi_irq[3] = { TIM6_IRQn, TIM7_IRQn, I2C3_EV_IRQn };
+ *   CM4U_SWI_HANDLER(TIM6_IRQHandler, swi[0])      // most urgent
+ *   CM4U_SWI_HANDLER(TIM7_IRQHandler, swi[1])
+ *   CM4U_SWI_HANDLER(I2C3_EV_IRQHandler, swi[2])
+ *
+ *   cm4u_swi_ladder_init(swi, swi_irq, 3u, 4u);    // priorities 4, 5, 6
+ *
+ *   void ADC_IRQHandler(void)                      // priority 1..3
+ *   {
+ *       cm4u_swi_post(&swi[1], filter_block, &adc, ADC1->DR);
+ *   }
+ *
+ * Each level has a lock-free queue of CM4U_CFG_SWI_DEPTH work items
+ * (fn, ctx, arg). Producers in any context reserve a slot with
+ * LDREX/STREX and publish it by writing fn last. The level's handler is
+ * the single consumer and runs the items in FIFO order. Posting pends the
+ * vector with one NVIC->STIR store (CM4U_CFG_SWI_STIR), or with
+ * cm4u_nvic_set_pending().
+ *
+ * Levels only preempt each other if their *group* priorities differ (see
+ * PRIGROUP). Pick vectors whose peripheral stays disabled, so that nothing
+ * but software ever pends them. Unprivileged code can write STIR only if
+ * SCB->CCR.USERSETMPEND is set.
+ */
+
+#include <string.h>
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Deferred work: fn(ctx, arg), run by the level's handler */
+typedef void (*cm4u_swi_fn_t)(void *ctx, uint32_t arg);
+
+typedef struct {
+    cm4u_swi_fn_t fn;   /* 0 = slot reserved, not yet written */
+    void         *ctx;
+    uint32_t      arg;
+} cm4u_swi_item_t;
+
+typedef struct {
+    IRQn_Type         irqn;
+    volatile uint32_t head;       /* items reserved by producers (free running) */
+    volatile uint32_t tail;       /* items taken by the handler (free running) */
+
+    /* Statistics */
+    volatile uint32_t dropped;    /* posts refused, queue full */
+    uint32_t          run;        /* items executed */
+    uint32_t          max_depth;  /* deepest queue seen on handler entry */
+
+    volatile cm4u_swi_item_t item[CM4U_CFG_SWI_DEPTH];
+} cm4u_swi_t;
+
+/* Pend the level's vector */
+static inline void cm4u_swi_pend(const cm4u_swi_t *s)
+{
+#if (CM4U_CFG_SWI_STIR != 0)
+    cm4u_nvic_trigger(s->irqn);
+#else
+    cm4u_nvic_set_pending(s->irqn);
+#endif
+}
+
+/*
+ * Claim `irqn` as a software level with NVIC priority `priority`: empties
+ * the queue, clears any stale pend and enables the vector.
+ */
+static inline void cm4u_swi_init(cm4u_swi_t *s, IRQn_Type irqn, uint32_t priority)
+{
+    CM4U_ASSERT((int32_t)irqn >= 0);
+    cm4u_nvic_disable_irq(irqn);
+    memset(s, 0, sizeof(*s));
+    s->irqn = irqn;
+    cm4u_nvic_set_priority(irqn, priority);
+    cm4u_nvic_clear_pending(irqn);
+    cm4u_nvic_enable_irq(irqn);
+}
+
+/*
+ * Claim `n` vectors as a ladder: levels[0] gets `top_priority` (most
+ * urgent), each following level the next lower priority.
+ */
+static inline void cm4u_swi_ladder_init(cm4u_swi_t *levels, const IRQn_Type *irqn, uint32_t n,
+                                        uint32_t top_priority)
+{
+    for (uint32_t i = 0u; i < n; i++) {
+        cm4u_swi_init(&levels[i], irqn[i], top_priority + i);
+    }
+}
+
+/*
+ * Queue fn(ctx, arg) on level `s` and pend it. Safe from any context,
+ * including other levels and the level's own work items. Returns false
+ * (and counts a drop) when the queue is full.
+ */
+static inline bool cm4u_swi_post(cm4u_swi_t *s, cm4u_swi_fn_t fn, void *ctx, uint32_t arg)
+{
+    uint32_t head;
+
+    CM4U_ASSERT(fn != 0);
+    if (!cm4u_ring_reserve(&s->head, &s->tail, CM4U_CFG_SWI_DEPTH, 1u, &s->dropped, &head)) {
+        return false;
+    }
+
+    volatile cm4u_swi_item_t *it = &s->item[head & (CM4U_CFG_SWI_DEPTH - 1u)];
+    it->ctx = ctx;
+    it->arg = arg;
+    __DMB();
+    it->fn = fn;  /* publish */
+    cm4u_swi_pend(s);
+    return true;
+}
+
+/*
+ * Run everything queued on level `s`. Call it (only) from the level's
+ * handler. Stops early at a slot that a preempted producer has reserved
+ * but not yet written; that producer pends the level again when it is done.
+ */
+static inline void cm4u_swi_run(cm4u_swi_t *s)
+{
+    uint32_t tail = s->tail;
+    uint32_t depth = s->head - tail;
+
+    if (depth > s->max_depth) {
+        s->max_depth = depth;
+    }
+    while (tail != s->head) {
+        volatile cm4u_swi_item_t *it = &s->item[tail & (CM4U_CFG_SWI_DEPTH - 1u)];
+        cm4u_swi_fn_t fn = it->fn;
+        if (fn == 0) {
+            break;
+        }
+        __DMB();
+        void *ctx = it->ctx;
+        uint32_t arg = it->arg;
+        it->fn = 0;
+        __DMB();
+        s->tail = ++tail;  /* frees the slot before fn runs, so fn may re-post */
+        s->run++;
+        fn(ctx, arg);
+    }
+}
+
+/* Items posted so far (head is free running) */
+static inline uint32_t cm4u_swi_posted(const cm4u_swi_t *s)
+{
+    return s->head;
+}
+
+/* Items waiting (or being written) right now */
+static inline uint32_t cm4u_swi_queued(const cm4u_swi_t *s)
+{
+    return s->head - s->tail;
+}
+
+/* Define the vector handler for a level: CM4U_SWI_HANDLER(TIM7_IRQHandler, swi[1]) */
+#define CM4U_SWI_HANDLER(handler, swi)  \
+    void handler(void)                  \
+    {                                   \
+        cm4u_swi_run(&(swi));           \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_SWI_H */
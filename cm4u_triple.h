@@ -0,0 +1,116 @@
+#ifndef CM4U_TRIPLE_H
+#define CM4U_TRIPLE_H
+
+/*
+ * Lock-free triple buffer: latest-value sharing between one producer and
+ * one consumer (ISR -> control loop, or the other way round).
+ *
+ * Three copies of the value: one the producer writes, one the consumer
+ * reads, one in the middle. Publishing swaps the producer's copy with the
+ * middle one; fetching swaps the middle one with the consumer's. Each swap
+ * is a single LDREXB/STREXB exchange of a packed state byte
+ * (middle index | CM4U_TRIPLE_FRESH). Neither side ever waits for the
+ * other, and interrupts are never masked. The producer always has a free
+ * copy to write. The consumer always gets the latest complete one; older
+ * unread ones are simply overwritten.
+ *
+ *   typedef struct { float pos, vel; uint32_t stamp; } sample_t;
+ *   static CM4U_TRIPLE(sample_t) encoder;
+ *
+ *   CM4U_TRIPLE_INIT(&encoder);
+ *
+ *   // producer (encoder ISR)
+ *   sample_t *w = CM4U_TRIPLE_WRITE_BUF(&encoder);
+ *   w->pos = ...;
+ *   CM4U_TRIPLE_PUBLISH(&encoder);
+ *
+ *   // consumer (control loop)
+ *   if (CM4U_TRIPLE_FETCH(&encoder)) {      // false: nothing newer
+ *       const sample_t *r = CM4U_TRIPLE_READ_BUF(&encoder);
+ *       ...
+ *   }
+ *
+ * The read copy stays valid, and unchanged, until the next fetch. The
+ * write copy holds stale data after a publish: write every field again.
+ * Cost per side is one exchange plus a DMB, whatever the value's size.
+ */
+
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* State byte flag: the middle copy was published and not fetched yet */
+#define CM4U_TRIPLE_FRESH  0x40u
+
+typedef struct {
+    volatile uint8_t state;  /* middle copy index | CM4U_TRIPLE_FRESH */
+    uint8_t          write;  /* producer's copy (producer only) */
+    uint8_t          read;   /* consumer's copy (consumer only) */
+    uint8_t          reserved;
+} cm4u_triple_t;
+
+/* Triple buffer of `type` values */
+#define CM4U_TRIPLE(type)        \
+    struct {                     \
+        cm4u_triple_t ctl;       \
+        type          buf[3];    \
+    }
+
+static inline void cm4u_triple_init(cm4u_triple_t *t)
+{
+    t->write = 0u;
+    t->state = 1u;
+    t->read = 2u;
+    t->reserved = 0u;
+}
+
+static inline uint8_t cm4u_triple__exchange(volatile uint8_t *state, uint8_t value)
+{
+    uint8_t old;
+    do {
+        old = __LDREXB(state);
+    } while (__STREXB(value, state) != 0u);
+    return old;
+}
+
+/* Producer: make the write copy the latest value; returns the new write copy index */
+static inline uint32_t cm4u_triple_publish(cm4u_triple_t *t)
+{
+    __DMB();  /* the value before the swap */
+    uint8_t old = cm4u_triple__exchange(&t->state, (uint8_t)(t->write | CM4U_TRIPLE_FRESH));
+    t->write = (uint8_t)(old & 3u);
+    return t->write;
+}
+
+/* Consumer: true when a newer value is now the read copy */
+static inline bool cm4u_triple_fetch(cm4u_triple_t *t)
+{
+    if ((t->state & CM4U_TRIPLE_FRESH) == 0u) {
+        return false;
+    }
+    uint8_t old = cm4u_triple__exchange(&t->state, t->read);
+    t->read = (uint8_t)(old & 3u);
+    __DMB();  /* the swap before the value */
+    return true;
+}
+
+/* Consumer: a value was published since the last fetch */
+static inline bool cm4u_triple_fresh(const cm4u_triple_t *t)
+{
+    return (t->state & CM4U_TRIPLE_FRESH) != 0u;
+}
+
+/* Typed access (`tb` points to a CM4U_TRIPLE(type)) */
+#define CM4U_TRIPLE_INIT(tb)       cm4u_triple_init(&(tb)->ctl)
+#define CM4U_TRIPLE_WRITE_BUF(tb)  (&(tb)->buf[(tb)->ctl.write])
+#define CM4U_TRIPLE_READ_BUF(tb)   (&(tb)->buf[(tb)->ctl.read])
+#define CM4U_TRIPLE_PUBLISH(tb)    ((void)cm4u_triple_publish(&(tb)->ctl))
+#define CM4U_TRIPLE_FETCH(tb)      cm4u_triple_fetch(&(tb)->ctl)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_TRIPLE_H */
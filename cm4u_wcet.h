@@ -0,0 +1,347 @@
+#ifndef CM4U_WCET_H
+#define CM4U_WCET_H
+
+/*
+ * WCET measurement harness: run a function many times under controlled
+ * perturbations and keep the worst case, the input that caused it and an
+ * extreme-value estimate of the tail.
+ *
+ * A mean from cm4u_profile_cycles_end() says nothing about a deadline. Here
+ * every run gets a fresh input from a user generator, and each perturbation
+ * enabled in cfg.flags is applied to a random half of the runs:
+ *
+ *   CM4U_WCET_FLUSH     reset the flash ART cache and prefetch buffer
+ *                       (CM4U_CFG_WCET_FLASH_ACR) and flush the pipeline
+ *   CM4U_WCET_IRQ       pend cfg.irq at the start of the run (or let
+ *                       cfg.arm start a timer that pends it later); its
+ *                       handler calls cm4u_wcet_irq_handler(), which runs
+ *                       cfg.irq_fn (e.g. something that evicts the cache).
+ *                       The handler's own timing of irq_fn and the empty
+ *                       interrupt round trip (pend, entry, prologue, exit),
+ *                       calibrated by init, are subtracted from the run:
+ *                       what stays is the cost of the disturbed state, not
+ *                       the handler
+ *   CM4U_WCET_MISALIGN  pass the input 1..3 bytes off word alignment
+ *
+ *   static void gen(void *in, uint32_t size, uint32_t *seed, void *ctx)
+ *   {
+ *       uint8_t *b = in;
+ *       for (uint32_t i = 0u; i < size; i++) {
+ *           b[i] = (uint8_t)cm4u_wcet_rand(seed);
+ *       }
+ *   }
+ *
+ *   static cm4u_wcet_t w;
+ *   cm4u_wcet_cfg_t cfg = { .run = filter_step, .gen = gen, .size = 32u,
+ *                           .flags = CM4U_WCET_FLUSH | CM4U_WCET_MISALIGN,
+ *                           .seed = 1u };
+ *   cm4u_wcet_init(&w, &cfg);
+ *   cm4u_wcet_run(&w, &cfg, 10000u);
+ *   // w.max, w.max_input[] (w.max_seed regenerates it), w.max_perturb
+ *   uint32_t p9 = cm4u_wcet_tail(&w, 1e-9f);  // exceeded once in 1e9 runs
+ *
+ * Run from Thread mode with the DWT cycle counter on (cm4u_dwt_init()).
+ * Times exclude the empty-measurement overhead calibrated by init. With
+ * cfg.arm, the calibrated round trip is for a pend at once; what arm()
+ * itself costs stays in the run.
+ *
+ * The tail estimate fits a Gumbel distribution (method of moments) to the
+ * maxima of blocks of runs. It starts with CM4U_CFG_WCET_BLOCK runs per
+ * block; when CM4U_CFG_WCET_BLOCKS maxima are stored, neighbours merge and
+ * blocks double, so the whole history counts. It assumes runs that are
+ * independent and see every path the field can: it extrapolates what was
+ * observed, it does not find paths that never ran. Treat it as a sanity
+ * check on the margin above w.max, not as a bound.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "cm4u_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Perturbations (cm4u_wcet_cfg_t.flags, cm4u_wcet_t.max_perturb) */
+#define CM4U_WCET_FLUSH     0x1u
+#define CM4U_WCET_IRQ       0x2u
+#define CM4U_WCET_MISALIGN  0x4u
+
+/* Timestamp source */
+#ifndef CM4U_WCET_NOW
+#define CM4U_WCET_NOW()  cm4u_dwt_get_cycles()
+#endif
+
+/* Flash cache / prefetch reset: STM32F2/F4/F7 FLASH_ACR bits */
+#ifndef CM4U_WCET_FLUSH_CACHES
+#if (CM4U_CFG_WCET_FLASH_ACR != 0)
+#define CM4U_WCET_FLUSH_CACHES()  cm4u_wcet__flush_acr()
+#else
+#define CM4U_WCET_FLUSH_CACHES()  ((void)0)
+#endif
+#endif
+
+typedef void (*cm4u_wcet_fn_t)(const void *input, uint32_t size, void *ctx);
+typedef void (*cm4u_wcet_gen_t)(void *input, uint32_t size, uint32_t *seed, void *ctx);
+
+typedef struct {
+    cm4u_wcet_fn_t  run;         /* function under test */
+    cm4u_wcet_gen_t gen;         /* fills the input; NULL = zeros */
+    void           *ctx;         /* passed to run / gen / arm / irq_fn */
+    uint32_t        size;        /* input bytes, up to CM4U_CFG_WCET_INPUT_BYTES */
+    uint32_t        flags;       /* CM4U_WCET_* perturbations to draw from */
+    uint32_t        seed;        /* generator seed (0 is replaced) */
+    IRQn_Type       irq;         /* injected interrupt (CM4U_WCET_IRQ) */
+    void          (*arm)(uint32_t delay, void *ctx);  /* pend irq after ~delay cycles; NULL = at once */
+    void          (*irq_fn)(void *ctx);               /* run by the injected handler */
+} cm4u_wcet_cfg_t;
+
+typedef struct {
+    uint32_t runs;          /* measured runs */
+    uint32_t min;           /* fastest run */
+    uint32_t max;           /* slowest run */
+    uint64_t sum;           /* for the mean */
+    uint32_t overhead;      /* empty measurement, subtracted from every run */
+    uint32_t irq_overhead;  /* empty injected-interrupt round trip, subtracted when it fired */
+    uint32_t seed;          /* generator state */
+    uint32_t max_run;       /* index of the slowest run */
+    uint32_t max_seed;      /* generator state before its input was made */
+    uint32_t max_perturb;   /* CM4U_WCET_* applied to it */
+    uint32_t max_offset;    /* its input's misalignment */
+    uint32_t block_len;     /* runs per block */
+    uint32_t block_fill;    /* runs in the open block */
+    uint32_t block_open;    /* maximum of the open block */
+    uint32_t blocks;        /* block maxima stored */
+    uint32_t block_max[CM4U_CFG_WCET_BLOCKS];
+    uint8_t  max_input[CM4U_CFG_WCET_INPUT_BYTES];  /* input of the slowest run */
+    uint32_t arena[(CM4U_CFG_WCET_INPUT_BYTES + 7u) / 4u];  /* room to misalign */
+} cm4u_wcet_t;
+
+/* Injected-interrupt bookkeeping, shared with cm4u_wcet_irq_handler() */
+typedef struct {
+    const cm4u_wcet_cfg_t *volatile cfg;
+    volatile uint32_t cycles;  /* handler time in the current run */
+    volatile uint32_t taken;   /* handler entries in the current run */
+} cm4u_wcet_irq_t;
+
+__attribute__((weak)) cm4u_wcet_irq_t cm4u_wcet_irq;
+
+/* xorshift32 step, for generators */
+static inline uint32_t cm4u_wcet_rand(uint32_t *seed)
+{
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+#if (CM4U_CFG_WCET_FLASH_ACR != 0)
+/* Caches and prefetch off, reset both caches, restore */
+static inline void cm4u_wcet__flush_acr(void)
+{
+    volatile uint32_t *acr = (volatile uint32_t *)(CM4U_CFG_WCET_FLASH_ACR);
+    uint32_t v = *acr;
+    uint32_t off = v & ~((1u << 8) | (1u << 9) | (1u << 10));  /* PRFTEN, ICEN, DCEN */
+    *acr = off;
+    *acr = off | (1u << 11) | (1u << 12);                      /* ICRST, DCRST */
+    *acr = off;
+    *acr = v;
+}
+#endif
+
+/* Body of the injected interrupt's handler */
+static inline void cm4u_wcet_irq_handler(void)
+{
+    uint32_t start = CM4U_WCET_NOW();
+    const cm4u_wcet_cfg_t *cfg = cm4u_wcet_irq.cfg;
+    cm4u_wcet_irq.taken++;
+    if ((cfg != NULL) && (cfg->irq_fn != NULL)) {
+        cfg->irq_fn(cfg->ctx);
+    }
+    cm4u_wcet_irq.cycles += CM4U_WCET_NOW() - start;
+}
+
+/* Clear the record and calibrate the empty measurement (and interrupt, for CM4U_WCET_IRQ) */
+static inline void cm4u_wcet_init(cm4u_wcet_t *w, const cm4u_wcet_cfg_t *cfg)
+{
+    memset(w, 0, sizeof(*w));
+    w->seed = (cfg->seed != 0u) ? cfg->seed : 0x9E3779B9u;
+    w->block_len = CM4U_CFG_WCET_BLOCK;
+    w->overhead = 0xFFFFFFFFu;
+    for (uint32_t i = 0u; i < 8u; i++) {
+        cm4u_dsb();
+        cm4u_isb();
+        uint32_t start = CM4U_WCET_NOW();
+        uint32_t took = CM4U_WCET_NOW() - start;
+        if (took < w->overhead) {
+            w->overhead = took;
+        }
+    }
+    if ((cfg->flags & CM4U_WCET_IRQ) == 0u) {
+        return;
+    }
+    /* The same pend as a run, into a handler with no irq_fn */
+    w->irq_overhead = 0xFFFFFFFFu;
+    cm4u_wcet_irq.cfg = NULL;
+    for (uint32_t i = 0u; i < 8u; i++) {
+        cm4u_wcet_irq.cycles = 0u;
+        cm4u_dsb();
+        cm4u_isb();
+        uint32_t start = CM4U_WCET_NOW();
+        cm4u_nvic_set_pending(cfg->irq);
+        cm4u_dsb();
+        cm4u_isb();
+        uint32_t took = CM4U_WCET_NOW() - start;
+        uint32_t own = cm4u_wcet_irq.cycles + w->overhead;
+        took = (took > own) ? (took - own) : 0u;
+        if (took < w->irq_overhead) {
+            w->irq_overhead = took;
+        }
+    }
+}
+
+/* Fold one run into the block maxima */
+static inline void cm4u_wcet__block(cm4u_wcet_t *w, uint32_t took)
+{
+    if (took > w->block_open) {
+        w->block_open = took;
+    }
+    if (++w->block_fill < w->block_len) {
+        return;
+    }
+    if (w->blocks == CM4U_CFG_WCET_BLOCKS) {
+        for (uint32_t i = 0u; i < (CM4U_CFG_WCET_BLOCKS / 2u); i++) {
+            uint32_t a = w->block_max[2u * i];
+            uint32_t b = w->block_max[(2u * i) + 1u];
+            w->block_max[i] = (a > b) ? a : b;
+        }
+        w->blocks = CM4U_CFG_WCET_BLOCKS / 2u;
+        w->block_len *= 2u;
+        /* The open block is now half as long as the new ones: keep filling it */
+        if (w->block_fill < w->block_len) {
+            return;
+        }
+    }
+    w->block_max[w->blocks++] = w->block_open;
+    w->block_open = 0u;
+    w->block_fill = 0u;
+}
+
+/* One run of `in` with `perturb` applied; cycles with the overhead and the injected handler removed */
+static inline uint32_t cm4u_wcet__once(const cm4u_wcet_t *w, const cm4u_wcet_cfg_t *cfg, const void *in,
+                                       uint32_t perturb, uint32_t delay)
+{
+    if ((perturb & CM4U_WCET_FLUSH) != 0u) {
+        CM4U_WCET_FLUSH_CACHES();
+    }
+    cm4u_wcet_irq.cfg = cfg;
+    cm4u_wcet_irq.cycles = 0u;
+    cm4u_wcet_irq.taken = 0u;
+    cm4u_dsb();
+    cm4u_isb();
+    uint32_t start = CM4U_WCET_NOW();
+    if ((perturb & CM4U_WCET_IRQ) != 0u) {
+        if (cfg->arm != NULL) {
+            cfg->arm(delay, cfg->ctx);
+        } else {
+            cm4u_nvic_set_pending(cfg->irq);
+            cm4u_dsb();
+            cm4u_isb();
+        }
+    }
+    cfg->run(in, cfg->size, cfg->ctx);
+    uint32_t took = CM4U_WCET_NOW() - start;
+    uint32_t stolen = cm4u_wcet_irq.cycles + w->overhead + (cm4u_wcet_irq.taken * w->irq_overhead);
+    if ((perturb & CM4U_WCET_IRQ) != 0u) {
+        cm4u_nvic_clear_pending(cfg->irq);  /* an armed timer that did not fire in time */
+    }
+    return (took > stolen) ? (took - stolen) : 0u;
+}
+
+/* `runs` more measured runs; returns the maximum so far */
+static inline uint32_t cm4u_wcet_run(cm4u_wcet_t *w, const cm4u_wcet_cfg_t *cfg, uint32_t runs)
+{
+    uint32_t size = (cfg->size < CM4U_CFG_WCET_INPUT_BYTES) ? cfg->size : CM4U_CFG_WCET_INPUT_BYTES;
+    for (uint32_t n = 0u; n < runs; n++) {
+        uint32_t draw = cm4u_wcet_rand(&w->seed);
+        uint32_t perturb = cfg->flags & draw;
+        uint32_t offset = ((perturb & CM4U_WCET_MISALIGN) != 0u) ? (1u + ((draw >> 8) % 3u)) : 0u;
+        uint8_t *in = (uint8_t *)w->arena + offset;
+        uint32_t seed = w->seed;
+        if (cfg->gen != NULL) {
+            cfg->gen(in, size, &w->seed, cfg->ctx);
+        } else {
+            memset(in, 0, size);
+        }
+        uint32_t delay = (w->max != 0u) ? ((draw >> 16) % w->max) : 0u;
+        uint32_t took = cm4u_wcet__once(w, cfg, in, perturb, delay);
+
+        if ((w->runs == 0u) || (took < w->min)) {
+            w->min = took;
+        }
+        if ((w->runs == 0u) || (took > w->max)) {
+            w->max = took;
+            w->max_run = w->runs;
+            w->max_seed = seed;
+            w->max_perturb = perturb;
+            w->max_offset = offset;
+            memcpy(w->max_input, in, size);
+        }
+        w->runs++;
+        w->sum += took;
+        cm4u_wcet__block(w, took);
+    }
+    return w->max;
+}
+
+/* Run the worst input again, with the perturbations it had (the IRQ without a delay) */
+static inline uint32_t cm4u_wcet_replay(cm4u_wcet_t *w, const cm4u_wcet_cfg_t *cfg)
+{
+    uint32_t size = (cfg->size < CM4U_CFG_WCET_INPUT_BYTES) ? cfg->size : CM4U_CFG_WCET_INPUT_BYTES;
+    uint8_t *in = (uint8_t *)w->arena + w->max_offset;
+    memcpy(in, w->max_input, size);
+    return cm4u_wcet__once(w, cfg, in, w->max_perturb, 0u);
+}
+
+/* Mean cycles per run */
+static inline uint32_t cm4u_wcet_mean(const cm4u_wcet_t *w)
+{
+    return (w->runs != 0u) ? (uint32_t)(w->sum / w->runs) : 0u;
+}
+
+/*
+ * Cycles a single run exceeds with probability `p` (e.g. 1e-9f), from a
+ * Gumbel fit to the block maxima; 0 until 8 blocks are complete.
+ */
+static inline uint32_t cm4u_wcet_tail(const cm4u_wcet_t *w, float p)
+{
+    uint32_t n = w->blocks;
+    if ((n < 8u) || (p <= 0.0f) || (p >= 1.0f)) {
+        return 0u;
+    }
+    float mean = 0.0f;
+    for (uint32_t i = 0u; i < n; i++) {
+        mean += (float)w->block_max[i];
+    }
+    mean /= (float)n;
+    float var = 0.0f;
+    for (uint32_t i = 0u; i < n; i++) {
+        float d = (float)w->block_max[i] - mean;
+        var += d * d;
+    }
+    var /= (float)(n - 1u);
+    float beta = sqrtf(var) * 0.7796968f;  /* sqrt(6) / pi */
+    float mu = mean - (0.5772157f * beta);  /* Euler-Mascheroni */
+    /* Per-block exceedance q = 1 - (1 - p)^block_len, then the Gumbel quantile */
+    float q = -expm1f((float)w->block_len * log1pf(-p));
+    float x = mu - (beta * logf(-log1pf(-q)));
+    return (x > 0.0f) ? (uint32_t)ceilf(x) : 0u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_WCET_H */
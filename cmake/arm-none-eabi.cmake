@@ -0,0 +1,31 @@
+# Cross toolchain for Cortex-M4F with the GNU Arm Embedded toolchain.
+#
+#   cmake -S . -B build-arm -DCMAKE_TOOLCHAIN_FILE=cmake/arm-none-eabi.cmake \
+#         -DCM4U_CMSIS_DIR=/path/to/CMSIS/Core/Include
+
+set(CMAKE_SYSTEM_NAME      Generic)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(CM4U_TOOLCHAIN_PREFIX "arm-none-eabi-" CACHE STRING "Cross tool prefix")
+
+set(CMAKE_C_COMPILER   ${CM4U_TOOLCHAIN_PREFIX}gcc)
+set(CMAKE_CXX_COMPILER ${CM4U_TOOLCHAIN_PREFIX}g++)
+set(CMAKE_ASM_COMPILER ${CM4U_TOOLCHAIN_PREFIX}gcc)
+set(CMAKE_OBJCOPY      ${CM4U_TOOLCHAIN_PREFIX}objcopy CACHE FILEPATH "")
+set(CMAKE_OBJDUMP      ${CM4U_TOOLCHAIN_PREFIX}objdump CACHE FILEPATH "")
+set(CMAKE_SIZE         ${CM4U_TOOLCHAIN_PREFIX}size    CACHE FILEPATH "")
+set(CMAKE_NM           ${CM4U_TOOLCHAIN_PREFIX}nm      CACHE FILEPATH "")
+
+# No hosted runtime to link test programs against
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
+
+set(CM4U_CPU_FLAGS "-mcpu=cortex-m4 -mthumb -mfpu=fpv4-sp-d16 -mfloat-abi=hard")
+
+set(CMAKE_C_FLAGS_INIT   "${CM4U_CPU_FLAGS} -ffunction-sections -fdata-sections")
+set(CMAKE_CXX_FLAGS_INIT "${CM4U_CPU_FLAGS} -ffunction-sections -fdata-sections -fno-exceptions -fno-rtti")
+set(CMAKE_ASM_FLAGS_INIT "${CM4U_CPU_FLAGS}")
+set(CMAKE_EXE_LINKER_FLAGS_INIT "-Wl,--gc-sections")
+
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
@@ -1,4 +1,8 @@
+#if defined(CM4U_DEVICE_HEADER)
+#include CM4U_DEVICE_HEADER      /* e.g. the QEMU benchmark target */
+#else
 #include "stm32f4xx.h"   /* or your MCU's device header */
+#endif
 #include "core_cm4.h"
 #include "cm4u_core.h"
 
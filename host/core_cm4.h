@@ -0,0 +1,1247 @@
+#ifndef CM4U_HOST_CORE_CM4_H
+#define CM4U_HOST_CORE_CM4_H
+
+/*
+ * Host-side stand-in for CMSIS core_cm4.h (cm4u host backend).
+ *
+ * Put this directory ahead of any real CMSIS include path and cm4u_core.h
+ * compiles and runs in a normal Linux binary. The core peripherals
+ * (DWT, SCB, SysTick, NVIC, CoreDebug, MPU) are plain structs in one shared,
+ * inspectable state object, and the core-register intrinsics read and write
+ * simulated IPSR / PRIMASK / BASEPRI / FAULTMASK / CONTROL / MSP / PSP.
+ *
+ * What is modelled:
+ *   - CYCCNT counts only when DEMCR.TRCENA and DWT_CTRL.CYCCNTENA are set,
+ *     and advances per CM4U_HOST_CLOCK_* mode (see cm4u_host_set_clock()).
+ *   - SysTick VAL counts down from the simulated clock and pends SysTick.
+ *   - NVIC enables / pending / active bits, IP[] and SHP[] priorities,
+ *     PRIGROUP, and preemption: a pending exception whose group priority
+ *     beats the current execution priority runs its registered handler
+ *     synchronously, on the caller's stack, with IPSR set accordingly.
+ *   - SCB->ICSR PENDSVSET/PENDSTSET and NVIC->STIR writes take effect at the
+ *     next barrier (__DSB/__ISB), WFI/WFE, unmask or exception return, like
+ *     on silicon.
+ *   - SCR.SLEEPONEXIT: returning to Thread mode gives wfi_hook a chance to
+ *     raise the next interrupt instead (cm4u_host_state.sleep_on_exit_count).
+ *   - LDREX/STREX with a single-entry exclusive monitor that is cleared on
+ *     exception entry.
+ *   - Exception entry moves MSP (or PSP, from Thread mode with SPSEL) down
+ *     by the frame size: 32 bytes, or 104 with CONTROL.FPCA set, aligned to
+ *     8. Handlers run with SPSEL and FPCA clear, and see the matching
+ *     EXC_RETURN in cm4u_host_state.exc_return. Nothing is written there.
+ *   - MPU region file behind RNR/RBAR/RASR, including RBAR.VALID region
+ *     select (read back with cm4u_host_mpu_region()).
+ *   - Bit-band alias accesses (cm4u_host_bitband_read/write()), mapped onto
+ *     ordinary host memory.
+ *
+ * In STEP mode exception entry, return and tail-chaining cost the usual
+ * Cortex-M4 12 / 12 / 6 cycles (entry_cycles etc. in the state), and every
+ * core peripheral access or NVIC_* call costs one step.
+ *
+ * What is not: bus timing, fault escalation, frame contents, memory-mapped
+ * addresses. NVIC set/clear registers must be driven through the CMSIS
+ * functions (NVIC_EnableIRQ() etc.), not by plain stores to ISER/ICER.
+ *
+ * State lives in a weak global, so every translation unit shares it without
+ * a separate .c file.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef CM4U_HOST
+#define CM4U_HOST 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --------------------------------------------------------------------------
+ *  Configuration
+ * -------------------------------------------------------------------------- */
+
+#ifndef __CM4_REV
+#define __CM4_REV               0x0001U
+#endif
+
+#ifndef __NVIC_PRIO_BITS
+#define __NVIC_PRIO_BITS        4U
+#endif
+
+#ifndef __FPU_PRESENT
+#define __FPU_PRESENT           1U
+#endif
+
+#ifndef __MPU_PRESENT
+#define __MPU_PRESENT           1U
+#endif
+
+/* Number of device IRQs modelled (Cortex-M4 maximum is 240) */
+#ifndef CM4U_HOST_NUM_IRQS
+#define CM4U_HOST_NUM_IRQS      240U
+#endif
+
+#define CM4U_HOST_NUM_VECTORS   (16U + CM4U_HOST_NUM_IRQS)
+
+/* Default simulated core clock */
+#ifndef CM4U_HOST_CORE_HZ
+#define CM4U_HOST_CORE_HZ       168000000U
+#endif
+
+/* Read-only registers stay writable here: the simulator has to drive them */
+#define __IM   volatile
+#define __OM   volatile
+#define __IOM  volatile
+#define __I    volatile
+#define __O    volatile
+#define __IO   volatile
+
+#define __STATIC_INLINE       static inline
+#define __STATIC_FORCEINLINE  static inline
+#define __NO_RETURN
+#define __WEAK                __attribute__((weak))
+#define __USED                __attribute__((used))
+#define __ALIGNED(x)          __attribute__((aligned(x)))
+#define __PACKED              __attribute__((packed))
+#define __ASM                 __asm
+#define __INLINE              inline
+
+/* --------------------------------------------------------------------------
+ *  Exception numbers
+ * -------------------------------------------------------------------------- */
+
+/* Core exceptions; device IRQs are plain non-negative numbers cast to IRQn_Type */
+typedef enum {
+    NonMaskableInt_IRQn   = -14,
+    HardFault_IRQn        = -13,
+    MemoryManagement_IRQn = -12,
+    BusFault_IRQn         = -11,
+    UsageFault_IRQn       = -10,
+    SVCall_IRQn           = -5,
+    DebugMonitor_IRQn     = -4,
+    PendSV_IRQn           = -2,
+    SysTick_IRQn          = -1
+} IRQn_Type;
+
+/* --------------------------------------------------------------------------
+ *  Register blocks (CMSIS field names)
+ * -------------------------------------------------------------------------- */
+
+typedef struct {
+    __IOM uint32_t ISER[8U];
+          uint32_t RESERVED0[24U];
+    __IOM uint32_t ICER[8U];
+          uint32_t RESERVED1[24U];
+    __IOM uint32_t ISPR[8U];
+          uint32_t RESERVED2[24U];
+    __IOM uint32_t ICPR[8U];
+          uint32_t RESERVED3[24U];
+    __IOM uint32_t IABR[8U];
+          uint32_t RESERVED4[56U];
+    __IOM uint8_t  IP[240U];
+          uint32_t RESERVED5[644U];
+    __OM  uint32_t STIR;
+} NVIC_Type;
+
+typedef struct {
+    __IM  uint32_t CPUID;
+    __IOM uint32_t ICSR;
+    __IOM uint32_t VTOR;
+    __IOM uint32_t AIRCR;
+    __IOM uint32_t SCR;
+    __IOM uint32_t CCR;
+    __IOM uint8_t  SHP[12U];
+    __IOM uint32_t SHCSR;
+    __IOM uint32_t CFSR;
+    __IOM uint32_t HFSR;
+    __IOM uint32_t DFSR;
+    __IOM uint32_t MMFAR;
+    __IOM uint32_t BFAR;
+    __IOM uint32_t AFSR;
+    __IM  uint32_t PFR[2U];
+    __IM  uint32_t DFR;
+    __IM  uint32_t ADR;
+    __IM  uint32_t MMFR[4U];
+    __IM  uint32_t ISAR[5U];
+          uint32_t RESERVED0[5U];
+    __IOM uint32_t CPACR;
+} SCB_Type;
+
+typedef struct {
+    __IOM uint32_t CTRL;
+    __IOM uint32_t LOAD;
+    __IOM uint32_t VAL;
+    __IM  uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct {
+    __IOM uint32_t CTRL;
+    __IOM uint32_t CYCCNT;
+    __IOM uint32_t CPICNT;
+    __IOM uint32_t EXCCNT;
+    __IOM uint32_t SLEEPCNT;
+    __IOM uint32_t LSUCNT;
+    __IOM uint32_t FOLDCNT;
+    __IM  uint32_t PCSR;
+    __IOM uint32_t COMP0;
+    __IOM uint32_t MASK0;
+    __IOM uint32_t FUNCTION0;
+          uint32_t RESERVED0[1U];
+    __IOM uint32_t COMP1;
+    __IOM uint32_t MASK1;
+    __IOM uint32_t FUNCTION1;
+          uint32_t RESERVED1[1U];
+    __IOM uint32_t COMP2;
+    __IOM uint32_t MASK2;
+    __IOM uint32_t FUNCTION2;
+          uint32_t RESERVED2[1U];
+    __IOM uint32_t COMP3;
+    __IOM uint32_t MASK3;
+    __IOM uint32_t FUNCTION3;
+} DWT_Type;
+
+typedef struct {
+    __IOM uint32_t DHCSR;
+    __OM  uint32_t DCRSR;
+    __IOM uint32_t DCRDR;
+    __IOM uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+    __IM  uint32_t TYPE;
+    __IOM uint32_t CTRL;
+    __IOM uint32_t RNR;
+    __IOM uint32_t RBAR;
+    __IOM uint32_t RASR;
+    __IOM uint32_t RBAR_A1;
+    __IOM uint32_t RASR_A1;
+    __IOM uint32_t RBAR_A2;
+    __IOM uint32_t RASR_A2;
+    __IOM uint32_t RBAR_A3;
+    __IOM uint32_t RASR_A3;
+} MPU_Type;
+
+/* --------------------------------------------------------------------------
+ *  Bit definitions (subset used by cm4u)
+ * -------------------------------------------------------------------------- */
+
+#define SCB_ICSR_NMIPENDSET_Pos        31U
+#define SCB_ICSR_NMIPENDSET_Msk        (1UL << SCB_ICSR_NMIPENDSET_Pos)
+#define SCB_ICSR_PENDSVSET_Pos         28U
+#define SCB_ICSR_PENDSVSET_Msk         (1UL << SCB_ICSR_PENDSVSET_Pos)
+#define SCB_ICSR_PENDSVCLR_Pos         27U
+#define SCB_ICSR_PENDSVCLR_Msk         (1UL << SCB_ICSR_PENDSVCLR_Pos)
+#define SCB_ICSR_PENDSTSET_Pos         26U
+#define SCB_ICSR_PENDSTSET_Msk         (1UL << SCB_ICSR_PENDSTSET_Pos)
+#define SCB_ICSR_PENDSTCLR_Pos         25U
+#define SCB_ICSR_PENDSTCLR_Msk         (1UL << SCB_ICSR_PENDSTCLR_Pos)
+#define SCB_ICSR_VECTACTIVE_Pos        0U
+#define SCB_ICSR_VECTACTIVE_Msk        (0x1FFUL)
+
+#define SCB_AIRCR_VECTKEY_Pos          16U
+#define SCB_AIRCR_VECTKEY_Msk          (0xFFFFUL << SCB_AIRCR_VECTKEY_Pos)
+#define SCB_AIRCR_PRIGROUP_Pos         8U
+#define SCB_AIRCR_PRIGROUP_Msk         (7UL << SCB_AIRCR_PRIGROUP_Pos)
+#define SCB_AIRCR_SYSRESETREQ_Pos      2U
+#define SCB_AIRCR_SYSRESETREQ_Msk      (1UL << SCB_AIRCR_SYSRESETREQ_Pos)
+
+#define SCB_SCR_SEVONPEND_Pos          4U
+#define SCB_SCR_SEVONPEND_Msk          (1UL << SCB_SCR_SEVONPEND_Pos)
+#define SCB_SCR_SLEEPDEEP_Pos          2U
+#define SCB_SCR_SLEEPDEEP_Msk          (1UL << SCB_SCR_SLEEPDEEP_Pos)
+#define SCB_SCR_SLEEPONEXIT_Pos        1U
+#define SCB_SCR_SLEEPONEXIT_Msk        (1UL << SCB_SCR_SLEEPONEXIT_Pos)
+
+#define SCB_CCR_STKALIGN_Pos           9U
+#define SCB_CCR_STKALIGN_Msk           (1UL << SCB_CCR_STKALIGN_Pos)
+
+#define SCB_SHCSR_USGFAULTENA_Pos      18U
+#define SCB_SHCSR_USGFAULTENA_Msk      (1UL << SCB_SHCSR_USGFAULTENA_Pos)
+#define SCB_SHCSR_BUSFAULTENA_Pos      17U
+#define SCB_SHCSR_BUSFAULTENA_Msk      (1UL << SCB_SHCSR_BUSFAULTENA_Pos)
+#define SCB_SHCSR_MEMFAULTENA_Pos      16U
+#define SCB_SHCSR_MEMFAULTENA_Msk      (1UL << SCB_SHCSR_MEMFAULTENA_Pos)
+
+#define SysTick_CTRL_COUNTFLAG_Pos     16U
+#define SysTick_CTRL_COUNTFLAG_Msk     (1UL << SysTick_CTRL_COUNTFLAG_Pos)
+#define SysTick_CTRL_CLKSOURCE_Pos     2U
+#define SysTick_CTRL_CLKSOURCE_Msk     (1UL << SysTick_CTRL_CLKSOURCE_Pos)
+#define SysTick_CTRL_TICKINT_Pos       1U
+#define SysTick_CTRL_TICKINT_Msk       (1UL << SysTick_CTRL_TICKINT_Pos)
+#define SysTick_CTRL_ENABLE_Pos        0U
+#define SysTick_CTRL_ENABLE_Msk        (1UL)
+#define SysTick_LOAD_RELOAD_Pos        0U
+#define SysTick_LOAD_RELOAD_Msk        (0xFFFFFFUL)
+#define SysTick_VAL_CURRENT_Msk        (0xFFFFFFUL)
+
+#define DWT_CTRL_NOCYCCNT_Pos          25U
+#define DWT_CTRL_NOCYCCNT_Msk          (1UL << DWT_CTRL_NOCYCCNT_Pos)
+#define DWT_CTRL_CYCCNTENA_Pos         0U
+#define DWT_CTRL_CYCCNTENA_Msk         (1UL)
+
+#define CoreDebug_DHCSR_C_DEBUGEN_Pos  0U
+#define CoreDebug_DHCSR_C_DEBUGEN_Msk  (1UL)
+#define CoreDebug_DEMCR_TRCENA_Pos     24U
+#define CoreDebug_DEMCR_TRCENA_Msk     (1UL << CoreDebug_DEMCR_TRCENA_Pos)
+
+#define MPU_TYPE_DREGION_Pos           8U
+#define MPU_TYPE_DREGION_Msk           (0xFFUL << MPU_TYPE_DREGION_Pos)
+#define MPU_CTRL_PRIVDEFENA_Pos        2U
+#define MPU_CTRL_PRIVDEFENA_Msk        (1UL << MPU_CTRL_PRIVDEFENA_Pos)
+#define MPU_CTRL_HFNMIENA_Pos          1U
+#define MPU_CTRL_HFNMIENA_Msk          (1UL << MPU_CTRL_HFNMIENA_Pos)
+#define MPU_CTRL_ENABLE_Pos            0U
+#define MPU_CTRL_ENABLE_Msk            (1UL)
+#define MPU_RNR_REGION_Msk             (0xFFUL)
+#define MPU_RBAR_ADDR_Pos              5U
+#define MPU_RBAR_ADDR_Msk              (0x7FFFFFFUL << MPU_RBAR_ADDR_Pos)
+#define MPU_RBAR_VALID_Pos             4U
+#define MPU_RBAR_VALID_Msk             (1UL << MPU_RBAR_VALID_Pos)
+#define MPU_RBAR_REGION_Msk            (0xFUL)
+#define MPU_RASR_AP_Pos                24U
+#define MPU_RASR_AP_Msk                (0x7UL << MPU_RASR_AP_Pos)
+#define MPU_RASR_SIZE_Pos              1U
+#define MPU_RASR_SIZE_Msk              (0x1FUL << MPU_RASR_SIZE_Pos)
+#define MPU_RASR_ENABLE_Msk            (1UL)
+
+/* MPU regions modelled (the Cortex-M4 MPU has 8) */
+#define CM4U_HOST_MPU_REGIONS          8U
+
+/* --------------------------------------------------------------------------
+ *  Simulator state
+ * -------------------------------------------------------------------------- */
+
+typedef enum {
+    CM4U_HOST_CLOCK_STEP   = 0, /* every modelled instruction / DWT read costs a fixed step */
+    CM4U_HOST_CLOCK_REAL   = 1, /* cycles follow CLOCK_MONOTONIC scaled to core_hz */
+    CM4U_HOST_CLOCK_MANUAL = 2  /* cycles only move via cm4u_host_advance_cycles() */
+} cm4u_host_clock_t;
+
+typedef void (*cm4u_host_handler_t)(void);
+
+typedef struct {
+    /* Register blocks (accessed through the CMSIS macros below) */
+    NVIC_Type      nvic;
+    SCB_Type       scb;
+    SysTick_Type   systick;
+    DWT_Type       dwt;
+    CoreDebug_Type coredebug;
+    MPU_Type       mpu;
+
+    /* MPU region file behind the RNR/RBAR/RASR window */
+    uint32_t mpu_rbar[CM4U_HOST_MPU_REGIONS];
+    uint32_t mpu_rasr[CM4U_HOST_MPU_REGIONS];
+    uint32_t mpu_rnr_seen;       /* region the RBAR/RASR window currently shows */
+
+    /* Core registers */
+    uint32_t ipsr;
+    uint32_t primask;
+    uint32_t basepri;
+    uint32_t faultmask;
+    uint32_t control;
+    uint32_t msp;
+    uint32_t psp;
+    uint32_t exc_return;         /* LR value of the running handler (EXC_RETURN) */
+
+    /* Exception model: vector table and system exception pending/active bits */
+    cm4u_host_handler_t vector[CM4U_HOST_NUM_VECTORS];
+    uint16_t sys_pending;        /* bit n = exception n (1..15) pending */
+    uint16_t sys_active;         /* bit n = exception n (1..15) active */
+    uint32_t nesting;            /* current exception nesting depth */
+    uint32_t max_nesting;
+    uint32_t exceptions_taken;
+
+    /* Clock */
+    cm4u_host_clock_t clock_mode;
+    uint32_t core_hz;
+    uint32_t step_cycles;        /* STEP mode: cycles per modelled instruction */
+    uint32_t entry_cycles;       /* STEP mode: exception entry (stacking + vector fetch) */
+    uint32_t exit_cycles;        /* STEP mode: exception return to the preempted context */
+    uint32_t tailchain_cycles;   /* STEP mode: return straight into the next pending one */
+    uint64_t cycles;             /* total simulated cycles since reset */
+    uint64_t cyccnt_base;        /* value of `cycles` when CYCCNT was last (re)based */
+    uint32_t cyccnt_seen;        /* last CYCCNT value the simulator produced */
+    uint64_t systick_base;       /* value of `cycles` when SysTick was last reloaded */
+    uint32_t systick_val_seen;   /* last VAL the simulator produced */
+    bool     systick_running;
+    uint64_t real_base_ns;
+
+    /* Exclusive monitor */
+    uintptr_t excl_addr;
+    bool      excl_valid;
+
+    /* Sleep / event / misc bookkeeping */
+    bool     event_register;
+    uint32_t wfi_count;
+    uint32_t sleep_on_exit_count; /* ISR returns that went straight back to sleep */
+    uint32_t wfe_count;
+    uint32_t sev_count;
+    uint32_t reset_count;
+    uint32_t svc_count;
+    uint8_t  last_svc;
+    uint32_t hardfault_count;
+
+    /* Optional hooks */
+    void (*wfi_hook)(void);      /* called from __WFI/__WFE before wake-up */
+    void (*reset_hook)(void);    /* called from NVIC_SystemReset() */
+
+    bool initialized;
+} cm4u_host_t;
+
+__attribute__((weak)) cm4u_host_t cm4u_host_state;
+
+static inline void cm4u_host_dispatch(void);
+static inline void cm4u_host_sync(void);
+
+static inline uint64_t cm4u_host__now_ns(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#else
+    /* Strict ISO mode hides POSIX clocks; fall back to process CPU time */
+    return (uint64_t)((double)clock() * (1e9 / (double)CLOCKS_PER_SEC));
+#endif
+}
+
+/* Reset the whole simulated core to its power-on state (hooks are kept) */
+static inline void cm4u_host_reset(void)
+{
+    cm4u_host_t *h = &cm4u_host_state;
+    void (*wfi_hook)(void)   = h->initialized ? h->wfi_hook : 0;
+    void (*reset_hook)(void) = h->initialized ? h->reset_hook : 0;
+    cm4u_host_clock_t mode   = h->initialized ? h->clock_mode : CM4U_HOST_CLOCK_STEP;
+    uint32_t hz              = h->initialized ? h->core_hz : CM4U_HOST_CORE_HZ;
+    uint32_t reset_count     = h->reset_count;
+
+    memset((void *)h, 0, sizeof(*h));
+    h->scb.CPUID      = 0x410FC241u;  /* Cortex-M4 r0p1 */
+    h->scb.AIRCR      = 0xFA050000u;
+    h->scb.CCR        = SCB_CCR_STKALIGN_Msk;
+    h->systick.CALIB  = 0x80000000u;  /* NOREF */
+    h->mpu.TYPE       = CM4U_HOST_MPU_REGIONS << MPU_TYPE_DREGION_Pos;
+    h->nvic.STIR      = 0xFFFFFFFFu;  /* "no write" sentinel, see cm4u_host_sync() */
+    h->msp            = 0x20020000u;
+    h->psp            = 0x20010000u;
+    h->clock_mode     = mode;
+    h->core_hz        = hz;
+    h->step_cycles    = 1u;
+    h->entry_cycles   = 12u;     /* Cortex-M4 zero-wait-state figures */
+    h->exit_cycles    = 12u;
+    h->tailchain_cycles = 6u;
+    h->real_base_ns   = cm4u_host__now_ns();
+    h->wfi_hook       = wfi_hook;
+    h->reset_hook     = reset_hook;
+    h->reset_count    = reset_count;
+    h->initialized    = true;
+}
+
+static inline cm4u_host_t *cm4u_host(void)
+{
+    if (!cm4u_host_state.initialized) {
+        cm4u_host_reset();
+    }
+    return &cm4u_host_state;
+}
+
+/* Bring SysTick VAL/COUNTFLAG up to date and pend SysTick on wrap */
+static inline void cm4u_host__systick_update(cm4u_host_t *h)
+{
+    if ((h->systick.CTRL & SysTick_CTRL_ENABLE_Msk) == 0u) {
+        h->systick_running = false;
+        return;
+    }
+    if (!h->systick_running || h->systick.VAL != h->systick_val_seen) {
+        /* Just enabled, or VAL written (which clears it): restart the period */
+        h->systick_base    = h->cycles;
+        h->systick_running = true;
+    }
+    uint64_t period = (uint64_t)(h->systick.LOAD & SysTick_LOAD_RELOAD_Msk) + 1u;
+    uint64_t elapsed = h->cycles - h->systick_base;
+    if (elapsed >= period) {
+        h->systick_base += (elapsed / period) * period;
+        h->systick.CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+        if ((h->systick.CTRL & SysTick_CTRL_TICKINT_Msk) != 0u) {
+            h->sys_pending |= (uint16_t)(1u << 15);
+        }
+        elapsed = h->cycles - h->systick_base;
+    }
+    h->systick.VAL = (uint32_t)(period - 1u - elapsed);
+    h->systick_val_seen = h->systick.VAL;
+}
+
+/* Bring CYCCNT up to date, honouring TRCENA/CYCCNTENA and user writes */
+static inline void cm4u_host__cyccnt_update(cm4u_host_t *h)
+{
+    bool counting = ((h->coredebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) != 0u) &&
+                    ((h->dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0u);
+    if ((h->dwt.CYCCNT != h->cyccnt_seen) || !counting) {
+        /* Written by software, or frozen: rebase so it continues from here */
+        h->cyccnt_base = h->cycles - h->dwt.CYCCNT;
+    }
+    if (counting) {
+        h->dwt.CYCCNT = (uint32_t)(h->cycles - h->cyccnt_base);
+    }
+    h->cyccnt_seen = h->dwt.CYCCNT;
+}
+
+/* Advance the simulated clock; may run SysTick (and anything it preempts) */
+static inline void cm4u_host_advance_cycles(uint64_t n)
+{
+    cm4u_host_t *h = cm4u_host();
+    cm4u_host__cyccnt_update(h);
+    h->cycles += n;
+    cm4u_host__cyccnt_update(h);
+    cm4u_host__systick_update(h);
+    if ((h->sys_pending & (1u << 15)) != 0u) {
+        cm4u_host_dispatch();
+    }
+}
+
+/* Per-instruction clock hook: STEP advances, REAL resamples the wall clock */
+static inline void cm4u_host__tick(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    if (h->clock_mode == CM4U_HOST_CLOCK_STEP) {
+        cm4u_host_advance_cycles(h->step_cycles);
+    } else if (h->clock_mode == CM4U_HOST_CLOCK_REAL) {
+        uint64_t now = ((cm4u_host__now_ns() - h->real_base_ns) * (uint64_t)h->core_hz) / 1000000000u;
+        if (now > h->cycles) {
+            cm4u_host_advance_cycles(now - h->cycles);
+        }
+    }
+}
+
+/* Select clock mode and simulated core frequency (CYCCNT keeps its value) */
+static inline void cm4u_host_set_clock(cm4u_host_clock_t mode, uint32_t core_hz)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->clock_mode   = mode;
+    h->core_hz      = core_hz;
+    h->real_base_ns = cm4u_host__now_ns() -
+                      (uint64_t)(((double)h->cycles * 1e9) / (double)core_hz);
+}
+
+/* Total simulated cycles since reset (independent of CYCCNT enable) */
+static inline uint64_t cm4u_host_cycles(void)
+{
+    return cm4u_host()->cycles;
+}
+
+/* --------------------------------------------------------------------------
+ *  Peripheral access (each access keeps the model's time-driven state current)
+ * -------------------------------------------------------------------------- */
+
+static inline DWT_Type *cm4u_host_dwt(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    cm4u_host__tick();
+    cm4u_host__cyccnt_update(h);
+    return &h->dwt;
+}
+
+static inline SysTick_Type *cm4u_host_systick(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    cm4u_host__tick();
+    cm4u_host__systick_update(h);
+    return &h->systick;
+}
+
+static inline CoreDebug_Type *cm4u_host_coredebug(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    cm4u_host__cyccnt_update(h);
+    return &h->coredebug;
+}
+
+static inline SCB_Type *cm4u_host_scb(void)
+{
+    cm4u_host__tick();
+    return &cm4u_host()->scb;
+}
+
+static inline NVIC_Type *cm4u_host_nvic(void)
+{
+    cm4u_host__tick();
+    return &cm4u_host()->nvic;
+}
+
+/*
+ * Commit the last RBAR/RASR write to the region file, then follow RNR or an
+ * RBAR write with VALID set (which selects the region itself, as on silicon).
+ */
+static inline void cm4u_host__mpu_update(cm4u_host_t *h)
+{
+    MPU_Type *m = &h->mpu;
+    if ((m->RBAR & MPU_RBAR_VALID_Msk) != 0u) {
+        uint32_t r = m->RBAR & MPU_RBAR_REGION_Msk;
+        if (r < CM4U_HOST_MPU_REGIONS) {
+            h->mpu_rbar[r] = m->RBAR & (MPU_RBAR_ADDR_Msk | MPU_RBAR_REGION_Msk);
+            m->RNR = r;
+        }
+        m->RBAR = h->mpu_rbar[m->RNR % CM4U_HOST_MPU_REGIONS];
+        m->RASR = h->mpu_rasr[m->RNR % CM4U_HOST_MPU_REGIONS];
+        h->mpu_rnr_seen = m->RNR;
+        return;
+    }
+    h->mpu_rbar[h->mpu_rnr_seen] = (m->RBAR & MPU_RBAR_ADDR_Msk) | h->mpu_rnr_seen;
+    h->mpu_rasr[h->mpu_rnr_seen] = m->RASR;
+    if (m->RNR != h->mpu_rnr_seen && m->RNR < CM4U_HOST_MPU_REGIONS) {
+        h->mpu_rnr_seen = m->RNR;
+        m->RBAR = h->mpu_rbar[m->RNR];
+        m->RASR = h->mpu_rasr[m->RNR];
+    }
+}
+
+static inline MPU_Type *cm4u_host_mpu(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    cm4u_host__tick();
+    cm4u_host__mpu_update(h);
+    return &h->mpu;
+}
+
+/* Read back region `r` as programmed (for checks; does not touch RNR) */
+static inline void cm4u_host_mpu_region(uint32_t r, uint32_t *rbar, uint32_t *rasr)
+{
+    cm4u_host_t *h = cm4u_host();
+    cm4u_host__mpu_update(h);
+    *rbar = h->mpu_rbar[r % CM4U_HOST_MPU_REGIONS];
+    *rasr = h->mpu_rasr[r % CM4U_HOST_MPU_REGIONS];
+}
+
+#define NVIC       (cm4u_host_nvic())
+#define SCB        (cm4u_host_scb())
+#define SysTick    (cm4u_host_systick())
+#define DWT        (cm4u_host_dwt())
+#define CoreDebug  (cm4u_host_coredebug())
+#define MPU        (cm4u_host_mpu())
+
+/* --------------------------------------------------------------------------
+ *  Exception model
+ * -------------------------------------------------------------------------- */
+
+/* Register the handler for an exception / IRQ (NULL = just mark it taken) */
+static inline void cm4u_host_set_handler(IRQn_Type irqn, cm4u_host_handler_t fn)
+{
+    cm4u_host()->vector[(int32_t)irqn + 16] = fn;
+}
+
+/* Raw 8-bit priority of exception number `exc`; fixed ones are negative */
+static inline int32_t cm4u_host__exc_priority(const cm4u_host_t *h, uint32_t exc)
+{
+    if (exc == 1u) return -3;
+    if (exc == 2u) return -2;
+    if (exc == 3u) return -1;
+    if (exc < 16u) return (int32_t)h->scb.SHP[exc - 4u];
+    return (int32_t)h->nvic.IP[exc - 16u];
+}
+
+/* Group priority, i.e. the part of the priority that decides preemption */
+static inline int32_t cm4u_host__group(const cm4u_host_t *h, int32_t prio)
+{
+    if (prio < 0) {
+        return prio;
+    }
+    uint32_t prigroup = (h->scb.AIRCR & SCB_AIRCR_PRIGROUP_Msk) >> SCB_AIRCR_PRIGROUP_Pos;
+    return prio >> (prigroup + 1u);
+}
+
+/* Current execution priority (group units); 256 = Thread mode, nothing boosted */
+static inline int32_t cm4u_host__exec_priority(const cm4u_host_t *h)
+{
+    int32_t prio = 256;
+    for (uint32_t exc = 1u; exc < CM4U_HOST_NUM_VECTORS; exc++) {
+        bool active = (exc < 16u)
+            ? ((h->sys_active & (1u << exc)) != 0u)
+            : ((h->nvic.IABR[(exc - 16u) >> 5] & (1u << ((exc - 16u) & 31u))) != 0u);
+        if (active) {
+            int32_t g = cm4u_host__group(h, cm4u_host__exc_priority(h, exc));
+            if (g < prio) prio = g;
+        }
+    }
+    if ((h->basepri & 0xFFu) != 0u) {
+        int32_t g = cm4u_host__group(h, (int32_t)(h->basepri & 0xFFu));
+        if (g < prio) prio = g;
+    }
+    if ((h->primask & 1u) != 0u && prio > 0) {
+        prio = 0;
+    }
+    if ((h->faultmask & 1u) != 0u) {
+        prio = -1;
+    }
+    return prio;
+}
+
+/* Highest-priority pending & enabled exception able to preempt now, or 0 */
+static inline uint32_t cm4u_host__next_exception(const cm4u_host_t *h)
+{
+    int32_t  exec = cm4u_host__exec_priority(h);
+    uint32_t best = 0u;
+    int32_t  best_prio = 0x7FFFFFFF;
+
+    for (uint32_t exc = 1u; exc < CM4U_HOST_NUM_VECTORS; exc++) {
+        bool pending;
+        if (exc < 16u) {
+            pending = (h->sys_pending & (1u << exc)) != 0u;
+        } else {
+            uint32_t n = exc - 16u, w = n >> 5, b = 1u << (n & 31u);
+            pending = ((h->nvic.ISPR[w] & b) != 0u) && ((h->nvic.ISER[w] & b) != 0u);
+        }
+        if (!pending) {
+            continue;
+        }
+        int32_t prio = cm4u_host__exc_priority(h, exc);
+        if (cm4u_host__group(h, prio) < exec && prio < best_prio) {
+            best = exc;
+            best_prio = prio;
+        }
+    }
+    return best;
+}
+
+static inline void cm4u_host__apply_writes(cm4u_host_t *h);
+
+/* Enter exception `exc`, run its handler, return to the preempted context */
+static inline void cm4u_host__take(cm4u_host_t *h, uint32_t exc, bool tailchained)
+{
+    uint32_t saved_ipsr = h->ipsr;
+    uint32_t saved_control = h->control;
+    uint32_t saved_exc_return = h->exc_return;
+
+    /* Frame on the preempted context's stack: 8 words, 26 with FP state, 8-byte aligned */
+    bool thread = (h->nesting == 0u);
+    bool on_psp = thread && ((h->control & 0x2u) != 0u);
+    bool fp = (h->control & 0x4u) != 0u;
+    uint32_t *sp = on_psp ? &h->psp : &h->msp;
+    uint32_t saved_sp = *sp;
+    *sp = (saved_sp - (fp ? 104u : 32u)) & ~7u;
+    h->exc_return = 0xFFFFFFE1u | (fp ? 0u : 0x10u) | (thread ? 0x8u : 0u) | (on_psp ? 0x4u : 0u);
+    h->control &= ~0x6u;  /* handlers run on MSP, FPCA clear */
+
+    /* Pending -> active first: the entry cycles below may dispatch SysTick */
+    if (exc < 16u) {
+        h->sys_pending &= (uint16_t)~(1u << exc);
+        h->sys_active  |= (uint16_t)(1u << exc);
+    } else {
+        uint32_t n = exc - 16u, w = n >> 5, b = 1u << (n & 31u);
+        h->nvic.ISPR[w] &= ~b;
+        h->nvic.ICPR[w]  = h->nvic.ISPR[w];
+        h->nvic.IABR[w] |= b;
+    }
+    if (exc == 14u) h->scb.ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+    if (exc == 15u) h->scb.ICSR &= ~SCB_ICSR_PENDSTSET_Msk;
+
+    if (h->clock_mode == CM4U_HOST_CLOCK_STEP) {
+        cm4u_host_advance_cycles(tailchained ? h->tailchain_cycles : h->entry_cycles);
+    }
+
+    h->excl_valid = false;
+    h->ipsr = exc;
+    h->nesting++;
+    h->exceptions_taken++;
+    if (h->nesting > h->max_nesting) {
+        h->max_nesting = h->nesting;
+    }
+    h->scb.ICSR = (h->scb.ICSR & ~SCB_ICSR_VECTACTIVE_Msk) | exc;
+
+    if (h->vector[exc] != 0) {
+        h->vector[exc]();
+    }
+    cm4u_host__apply_writes(h);  /* exception return synchronises, like a barrier */
+
+    h->nesting--;
+    *sp = saved_sp;
+    h->control = saved_control;
+    h->exc_return = saved_exc_return;
+    h->ipsr = saved_ipsr;
+    h->scb.ICSR = (h->scb.ICSR & ~SCB_ICSR_VECTACTIVE_Msk) | saved_ipsr;
+    h->excl_valid = false;
+    if (exc < 16u) {
+        h->sys_active &= (uint16_t)~(1u << exc);
+    } else {
+        uint32_t n = exc - 16u;
+        h->nvic.IABR[n >> 5] &= ~(1u << (n & 31u));
+    }
+}
+
+/*
+ * Run every pending exception that may preempt the current context.
+ * Returning to Thread mode with SCR.SLEEPONEXIT set counts as going back to
+ * sleep: the wfi_hook gets to raise the next interrupt, which is taken without
+ * Thread code running. If nothing is raised the host returns to Thread mode
+ * (it cannot sleep forever).
+ */
+static inline void cm4u_host_dispatch(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    uint32_t exc = cm4u_host__next_exception(h);
+    bool tailchained = false;
+    while (exc != 0u) {
+        cm4u_host__take(h, exc, tailchained);
+        if (h->nesting == 0u && (h->scb.SCR & SCB_SCR_SLEEPONEXIT_Msk) != 0u && h->wfi_hook != 0) {
+            h->sleep_on_exit_count++;
+            h->wfi_hook();
+            cm4u_host__apply_writes(h);
+            tailchained = false;  /* woken from sleep: a full entry again */
+        } else {
+            tailchained = true;
+        }
+        exc = cm4u_host__next_exception(h);
+        if (exc == 0u && tailchained && h->clock_mode == CM4U_HOST_CLOCK_STEP) {
+            cm4u_host_advance_cycles(h->exit_cycles);
+        }
+    }
+}
+
+/* Apply write-to-trigger registers (ICSR set/clear bits, STIR) */
+static inline void cm4u_host__apply_writes(cm4u_host_t *h)
+{
+    uint32_t icsr = h->scb.ICSR;
+
+    if ((icsr & SCB_ICSR_NMIPENDSET_Msk) != 0u) {
+        h->sys_pending |= (uint16_t)(1u << 2);
+        icsr &= ~SCB_ICSR_NMIPENDSET_Msk;
+    }
+    if ((icsr & SCB_ICSR_PENDSVCLR_Msk) != 0u) {
+        h->sys_pending &= (uint16_t)~(1u << 14);
+        icsr &= ~(SCB_ICSR_PENDSVCLR_Msk | SCB_ICSR_PENDSVSET_Msk);
+    }
+    if ((icsr & SCB_ICSR_PENDSTCLR_Msk) != 0u) {
+        h->sys_pending &= (uint16_t)~(1u << 15);
+        icsr &= ~(SCB_ICSR_PENDSTCLR_Msk | SCB_ICSR_PENDSTSET_Msk);
+    }
+    if ((icsr & SCB_ICSR_PENDSVSET_Msk) != 0u) h->sys_pending |= (uint16_t)(1u << 14);
+    if ((icsr & SCB_ICSR_PENDSTSET_Msk) != 0u) h->sys_pending |= (uint16_t)(1u << 15);
+    h->scb.ICSR = icsr;
+
+    if (h->nvic.STIR != 0xFFFFFFFFu) {
+        uint32_t n = h->nvic.STIR & 0x1FFu;
+        if (n < CM4U_HOST_NUM_IRQS) {
+            h->nvic.ISPR[n >> 5] |= 1u << (n & 31u);
+            h->nvic.ICPR[n >> 5]  = h->nvic.ISPR[n >> 5];
+        }
+        h->nvic.STIR = 0xFFFFFFFFu;
+    }
+}
+
+/* Apply write-to-trigger registers, then dispatch (what a barrier does here) */
+static inline void cm4u_host_sync(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    cm4u_host__apply_writes(h);
+    cm4u_host_dispatch();
+}
+
+/* Is an exception / IRQ pending in the model? */
+static inline bool cm4u_host_is_pending(IRQn_Type irqn)
+{
+    cm4u_host_t *h = cm4u_host();
+    int32_t n = (int32_t)irqn;
+    if (n < 0) {
+        return (h->sys_pending & (1u << (uint32_t)(n + 16))) != 0u;
+    }
+    return (h->nvic.ISPR[(uint32_t)n >> 5] & (1u << ((uint32_t)n & 31u))) != 0u;
+}
+
+/* Synchronous exception raised by SVC #imm8 (used by cm4u_trigger_svc) */
+static inline void cm4u_host_svc(uint8_t imm8)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->svc_count++;
+    h->last_svc = imm8;
+    if (cm4u_host__group(h, cm4u_host__exc_priority(h, 11u)) < cm4u_host__exec_priority(h)) {
+        cm4u_host__take(h, 11u, false);
+    } else {
+        /* SVC while masked escalates to HardFault on silicon */
+        h->hardfault_count++;
+        cm4u_host__take(h, 3u, false);
+    }
+    if (h->clock_mode == CM4U_HOST_CLOCK_STEP) {
+        cm4u_host_advance_cycles(h->exit_cycles);
+    }
+}
+
+/* --------------------------------------------------------------------------
+ *  Core-register intrinsics
+ * -------------------------------------------------------------------------- */
+
+static inline uint32_t __get_IPSR(void)      { return cm4u_host()->ipsr; }
+static inline uint32_t __get_xPSR(void)      { return cm4u_host()->ipsr | (1u << 24); }
+static inline uint32_t __get_APSR(void)      { return 0u; }
+
+static inline uint32_t __get_PRIMASK(void)   { return cm4u_host()->primask; }
+static inline void __set_PRIMASK(uint32_t v) { cm4u_host()->primask = v & 1u; cm4u_host_sync(); }
+static inline void __disable_irq(void)       { cm4u_host()->primask = 1u; }
+static inline void __enable_irq(void)        { cm4u_host()->primask = 0u; cm4u_host_sync(); }
+
+static inline uint32_t __get_BASEPRI(void)   { return cm4u_host()->basepri; }
+static inline void __set_BASEPRI(uint32_t v) { cm4u_host()->basepri = v & 0xFFu; cm4u_host_sync(); }
+
+/* BASEPRI_MAX: only ever raises the mask (lower non-zero value) */
+static inline void __set_BASEPRI_MAX(uint32_t v)
+{
+    cm4u_host_t *h = cm4u_host();
+    v &= 0xFFu;
+    if (v != 0u && (h->basepri == 0u || v < h->basepri)) {
+        h->basepri = v;
+    }
+}
+
+static inline uint32_t __get_FAULTMASK(void)   { return cm4u_host()->faultmask; }
+static inline void __set_FAULTMASK(uint32_t v) { cm4u_host()->faultmask = v & 1u; cm4u_host_sync(); }
+static inline void __disable_fault_irq(void)   { cm4u_host()->faultmask = 1u; }
+static inline void __enable_fault_irq(void)    { cm4u_host()->faultmask = 0u; cm4u_host_sync(); }
+
+static inline uint32_t __get_CONTROL(void)   { return cm4u_host()->control; }
+static inline void __set_CONTROL(uint32_t v) { cm4u_host()->control = v & 0x7u; }
+
+static inline uint32_t __get_MSP(void)       { return cm4u_host()->msp; }
+static inline void __set_MSP(uint32_t v)     { cm4u_host()->msp = v; }
+static inline uint32_t __get_PSP(void)       { return cm4u_host()->psp; }
+static inline void __set_PSP(uint32_t v)     { cm4u_host()->psp = v; }
+
+static inline uint32_t __get_FPSCR(void)     { return 0u; }
+static inline void __set_FPSCR(uint32_t v)   { (void)v; }
+
+/* --------------------------------------------------------------------------
+ *  Instruction intrinsics
+ * -------------------------------------------------------------------------- */
+
+static inline void __NOP(void) { cm4u_host__tick(); }
+static inline void __ISB(void) { cm4u_host__tick(); cm4u_host_sync(); }
+static inline void __DSB(void) { cm4u_host__tick(); cm4u_host_sync(); }
+static inline void __DMB(void) { cm4u_host__tick(); __sync_synchronize(); }
+
+static inline void __SEV(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->sev_count++;
+    h->event_register = true;
+}
+
+/* WFI: give the hook a chance to raise interrupts, then wake on anything pending */
+static inline void __WFI(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->wfi_count++;
+    if (h->wfi_hook != 0) {
+        h->wfi_hook();
+    }
+    cm4u_host__tick();
+    cm4u_host_sync();
+}
+
+/* WFE: consumes the event register if set, otherwise behaves like WFI */
+static inline void __WFE(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->wfe_count++;
+    if (h->event_register) {
+        h->event_register = false;
+        return;
+    }
+    if (h->wfi_hook != 0) {
+        h->wfi_hook();
+    }
+    cm4u_host__tick();
+    cm4u_host_sync();
+}
+
+#define __BKPT(value)  __builtin_trap()
+
+static inline uint32_t __REV(uint32_t v)   { return __builtin_bswap32(v); }
+static inline uint32_t __REV16(uint32_t v) { return ((v & 0xFF00FF00u) >> 8) | ((v & 0x00FF00FFu) << 8); }
+static inline uint8_t  __CLZ(uint32_t v)   { return (uint8_t)(v == 0u ? 32u : (uint32_t)__builtin_clz(v)); }
+
+static inline uint32_t __RBIT(uint32_t v)
+{
+    uint32_t r = 0u;
+    for (uint32_t i = 0u; i < 32u; i++) {
+        r = (r << 1) | (v & 1u);
+        v >>= 1;
+    }
+    return r;
+}
+
+/* Exclusive access: single-entry local monitor, cleared on exception entry/exit */
+static inline uint32_t __LDREXW(volatile uint32_t *addr)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->excl_addr  = (uintptr_t)addr;
+    h->excl_valid = true;
+    return *addr;
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    cm4u_host_t *h = cm4u_host();
+    if (!h->excl_valid || h->excl_addr != (uintptr_t)addr) {
+        h->excl_valid = false;
+        return 1u;
+    }
+    h->excl_valid = false;
+    *addr = value;
+    return 0u;
+}
+
+static inline uint16_t __LDREXH(volatile uint16_t *addr)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->excl_addr  = (uintptr_t)addr;
+    h->excl_valid = true;
+    return *addr;
+}
+
+static inline uint32_t __STREXH(uint16_t value, volatile uint16_t *addr)
+{
+    cm4u_host_t *h = cm4u_host();
+    if (!h->excl_valid || h->excl_addr != (uintptr_t)addr) {
+        h->excl_valid = false;
+        return 1u;
+    }
+    h->excl_valid = false;
+    *addr = value;
+    return 0u;
+}
+
+static inline uint8_t __LDREXB(volatile uint8_t *addr)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->excl_addr  = (uintptr_t)addr;
+    h->excl_valid = true;
+    return *addr;
+}
+
+static inline uint32_t __STREXB(uint8_t value, volatile uint8_t *addr)
+{
+    cm4u_host_t *h = cm4u_host();
+    if (!h->excl_valid || h->excl_addr != (uintptr_t)addr) {
+        h->excl_valid = false;
+        return 1u;
+    }
+    h->excl_valid = false;
+    *addr = value;
+    return 0u;
+}
+
+static inline void __CLREX(void) { cm4u_host()->excl_valid = false; }
+
+/* --------------------------------------------------------------------------
+ *  Bit-band alias emulation
+ * -------------------------------------------------------------------------- */
+
+/*
+ * There is no alias region on the host, so the alias "address" of bit b of
+ * the byte at host address A is A * 32 + b * 4: the silicon formula with
+ * region and alias base 0 (cm4u_bitband.h uses these bases under CM4U_HOST).
+ * Needs a 64-bit host. Byte-wise bit numbering assumes little-endian, as
+ * on the target.
+ */
+static inline uint32_t cm4u_host_bitband_read(uintptr_t alias)
+{
+    volatile uint8_t *byte = (volatile uint8_t *)(alias >> 5);
+    return ((uint32_t)*byte >> ((alias >> 2) & 7u)) & 1u;
+}
+
+/* A single store on silicon, so atomic with respect to handlers here too */
+static inline void cm4u_host_bitband_write(uintptr_t alias, uint32_t value)
+{
+    volatile uint8_t *byte = (volatile uint8_t *)(alias >> 5);
+    uint8_t mask = (uint8_t)(1u << ((alias >> 2) & 7u));
+    if ((value & 1u) != 0u) {
+        *byte = (uint8_t)(*byte | mask);
+    } else {
+        *byte = (uint8_t)(*byte & (uint8_t)~mask);
+    }
+}
+
+/* --------------------------------------------------------------------------
+ *  CMSIS NVIC / SysTick functions
+ * -------------------------------------------------------------------------- */
+
+static inline void __NVIC_SetPriorityGrouping(uint32_t PriorityGroup)
+{
+    cm4u_host__tick();
+    cm4u_host_t *h = cm4u_host();
+    h->scb.AIRCR = (0x5FAUL << SCB_AIRCR_VECTKEY_Pos) |
+                   ((PriorityGroup & 7u) << SCB_AIRCR_PRIGROUP_Pos);
+}
+
+static inline uint32_t __NVIC_GetPriorityGrouping(void)
+{
+    cm4u_host__tick();
+    return (cm4u_host()->scb.AIRCR & SCB_AIRCR_PRIGROUP_Msk) >> SCB_AIRCR_PRIGROUP_Pos;
+}
+
+static inline void __NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    cm4u_host__tick();
+    cm4u_host_t *h = cm4u_host();
+    if ((int32_t)IRQn >= 0) {
+        uint32_t n = (uint32_t)IRQn;
+        h->nvic.ISER[n >> 5] |= 1u << (n & 31u);
+        h->nvic.ICER[n >> 5]  = h->nvic.ISER[n >> 5];
+        cm4u_host_dispatch();
+    }
+}
+
+static inline uint32_t __NVIC_GetEnableIRQ(IRQn_Type IRQn)
+{
+    cm4u_host__tick();
+    if ((int32_t)IRQn >= 0) {
+        uint32_t n = (uint32_t)IRQn;
+        return (cm4u_host()->nvic.ISER[n >> 5] >> (n & 31u)) & 1u;
+    }
+    return 0u;
+}
+
+static inline void __NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    cm4u_host__tick();
+    cm4u_host_t *h = cm4u_host();
+    if ((int32_t)IRQn >= 0) {
+        uint32_t n = (uint32_t)IRQn;
+        h->nvic.ISER[n >> 5] &= ~(1u << (n & 31u));
+        h->nvic.ICER[n >> 5]  = h->nvic.ISER[n >> 5];
+    }
+}
+
+static inline uint32_t __NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+    cm4u_host__tick();
+    if ((int32_t)IRQn >= 0) {
+        uint32_t n = (uint32_t)IRQn;
+        return (cm4u_host()->nvic.ISPR[n >> 5] >> (n & 31u)) & 1u;
+    }
+    return 0u;
+}
+
+static inline void __NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    cm4u_host__tick();
+    cm4u_host_t *h = cm4u_host();
+    if ((int32_t)IRQn >= 0) {
+        uint32_t n = (uint32_t)IRQn;
+        h->nvic.ISPR[n >> 5] |= 1u << (n & 31u);
+        h->nvic.ICPR[n >> 5]  = h->nvic.ISPR[n >> 5];
+        cm4u_host_dispatch();
+    }
+}
+
+static inline void __NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    cm4u_host__tick();
+    cm4u_host_t *h = cm4u_host();
+    if ((int32_t)IRQn >= 0) {
+        uint32_t n = (uint32_t)IRQn;
+        h->nvic.ISPR[n >> 5] &= ~(1u << (n & 31u));
+        h->nvic.ICPR[n >> 5]  = h->nvic.ISPR[n >> 5];
+    }
+}
+
+static inline uint32_t __NVIC_GetActive(IRQn_Type IRQn)
+{
+    cm4u_host__tick();
+    if ((int32_t)IRQn >= 0) {
+        uint32_t n = (uint32_t)IRQn;
+        return (cm4u_host()->nvic.IABR[n >> 5] >> (n & 31u)) & 1u;
+    }
+    return 0u;
+}
+
+static inline void __NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    cm4u_host__tick();
+    cm4u_host_t *h = cm4u_host();
+    uint8_t v = (uint8_t)((priority << (8u - __NVIC_PRIO_BITS)) & 0xFFu);
+    if ((int32_t)IRQn >= 0) {
+        h->nvic.IP[(uint32_t)IRQn] = v;
+    } else {
+        h->scb.SHP[(((uint32_t)IRQn) & 0xFu) - 4u] = v;
+    }
+}
+
+static inline uint32_t __NVIC_GetPriority(IRQn_Type IRQn)
+{
+    cm4u_host__tick();
+    cm4u_host_t *h = cm4u_host();
+    if ((int32_t)IRQn >= 0) {
+        return (uint32_t)h->nvic.IP[(uint32_t)IRQn] >> (8u - __NVIC_PRIO_BITS);
+    }
+    return (uint32_t)h->scb.SHP[(((uint32_t)IRQn) & 0xFu) - 4u] >> (8u - __NVIC_PRIO_BITS);
+}
+
+static inline uint32_t NVIC_EncodePriority(uint32_t PriorityGroup, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    uint32_t group = PriorityGroup & 7u;
+    uint32_t pre_bits = ((7u - group) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7u - group);
+    uint32_t sub_bits = ((group + __NVIC_PRIO_BITS) < 7u) ? 0u : ((group - 7u) + __NVIC_PRIO_BITS);
+    return ((PreemptPriority & ((1u << pre_bits) - 1u)) << sub_bits) |
+           (SubPriority & ((1u << sub_bits) - 1u));
+}
+
+static inline void NVIC_DecodePriority(uint32_t Priority, uint32_t PriorityGroup,
+                                       uint32_t *pPreemptPriority, uint32_t *pSubPriority)
+{
+    uint32_t group = PriorityGroup & 7u;
+    uint32_t pre_bits = ((7u - group) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7u - group);
+    uint32_t sub_bits = ((group + __NVIC_PRIO_BITS) < 7u) ? 0u : ((group - 7u) + __NVIC_PRIO_BITS);
+    *pPreemptPriority = (Priority >> sub_bits) & ((1u << pre_bits) - 1u);
+    *pSubPriority     = Priority & ((1u << sub_bits) - 1u);
+}
+
+static inline void __NVIC_SetVector(IRQn_Type IRQn, uint32_t vector)
+{
+    (void)IRQn;
+    (void)vector; /* addresses are meaningless on the host; use cm4u_host_set_handler() */
+}
+
+/* Host reset: counts, runs the optional hook and returns (no real reboot) */
+static inline void __NVIC_SystemReset(void)
+{
+    cm4u_host_t *h = cm4u_host();
+    h->reset_count++;
+    if (h->reset_hook != 0) {
+        h->reset_hook();
+    }
+}
+
+static inline uint32_t SysTick_Config(uint32_t ticks)
+{
+    if ((ticks - 1u) > SysTick_LOAD_RELOAD_Msk) {
+        return 1u;
+    }
+    cm4u_host_t *h = cm4u_host();
+    h->systick.LOAD   = ticks - 1u;
+    __NVIC_SetPriority(SysTick_IRQn, (1u << __NVIC_PRIO_BITS) - 1u);
+    h->systick.VAL    = 0u;
+    h->systick_running = false;
+    h->systick.CTRL   = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    return 0u;
+}
+
+#define NVIC_SetPriorityGrouping    __NVIC_SetPriorityGrouping
+#define NVIC_GetPriorityGrouping    __NVIC_GetPriorityGrouping
+#define NVIC_EnableIRQ              __NVIC_EnableIRQ
+#define NVIC_GetEnableIRQ           __NVIC_GetEnableIRQ
+#define NVIC_DisableIRQ             __NVIC_DisableIRQ
+#define NVIC_GetPendingIRQ          __NVIC_GetPendingIRQ
+#define NVIC_SetPendingIRQ          __NVIC_SetPendingIRQ
+#define NVIC_ClearPendingIRQ        __NVIC_ClearPendingIRQ
+#define NVIC_GetActive              __NVIC_GetActive
+#define NVIC_SetPriority            __NVIC_SetPriority
+#define NVIC_GetPriority            __NVIC_GetPriority
+#define NVIC_SetVector              __NVIC_SetVector
+#define NVIC_SystemReset            __NVIC_SystemReset
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CM4U_HOST_CORE_CM4_H */
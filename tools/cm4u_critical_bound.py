@@ -0,0 +1,560 @@
+#!/usr/bin/env python3
+"""Static worst-case cycle bound of every masked region in a firmware image.
+
+Reads the disassembly of a Cortex-M4 image (GNU or LLVM objdump -d) and
+finds each region that runs with interrupts masked:
+
+    cpsid i / cpsid f                 ... cpsie i / cpsie f
+    mrs rX, PRIMASK; cpsid i          ... msr PRIMASK, rX       (cm4u_critical_enter / exit)
+    msr BASEPRI_MAX, rY               ... msr BASEPRI, rX       (BASEPRI mode, cm4u_raise_basepri)
+
+Nested sections are followed: a restore that is not a known 0 only leaves
+the innermost level. Functions that return with the mask raised (a
+cm4u_critical_enter() that was not inlined) open a region at each call
+site; functions that only lower it close one.
+
+Every path from the masking instruction to the unmasking one is costed
+with the Cortex-M4 timing table below (upper bounds: taken branches and
+pipeline refills everywhere, DIV at 12, barriers at 4). Called functions
+add their own worst case. A loop must be given a bound, the most times its
+body runs:
+
+    --bound 0x8000a1c=16      (address of the loop head or of its backward branch)
+    --bounds bounds.txt       (lines "ADDR N  # comment"; "func+0xOFF" works too)
+
+Indirect calls (blx rX) and unknown callees need a cost: --cost ADDR=CYCLES
+on the call. Jump tables (tbb / tbh), indirect jumps, WFI / WFE and SVC
+inside a region make it unbounded.
+
+Usage:
+
+    arm-none-eabi-objdump -d fw.elf > fw.lst
+    cm4u_critical_bound.py fw.lst --hz 168000000 --top 10
+    cm4u_critical_bound.py fw.lst --bounds bounds.txt --ws 5 --limit 2000
+    cm4u_critical_bound.py fw.elf --objdump arm-none-eabi-objdump --json
+
+--ws adds flash wait states to every taken branch and PC-relative load
+(with the ART cache off; 0 models zero-wait SRAM or cache hits). The exit
+status is 1 when a region is unbounded or exceeds --limit cycles.
+"""
+
+import argparse
+import json
+import re
+import shlex
+import subprocess
+import sys
+
+REFILL = 3  # pipeline refill after a taken branch, worst case
+DEPTH_MAX = 8
+COND = "eq|ne|cs|hs|cc|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le|al"
+BRANCH = re.compile(r"^b(lx|l|x)?(%s)?$" % COND)
+TARGET = re.compile(r"(?:0x)?([0-9a-f]+)\s+<([^>]+)>")
+IMM = re.compile(r"^mov[sw]?(?:\.[nw])?$")
+
+
+class Unbounded(Exception):
+    pass
+
+
+class Insn(object):
+    __slots__ = ("addr", "mn", "ops", "func", "index")
+
+    def __init__(self, addr, mn, ops, func, index):
+        self.addr, self.mn, self.ops, self.func, self.index = addr, mn, ops, func, index
+
+
+def parse(text):
+    """{function: [Insn]} and {address: function} from objdump -d output."""
+    funcs, starts = {}, {}
+    cur = None
+    for line in text.splitlines():
+        m = re.match(r"^([0-9a-fA-F]+) <([^>]+)>:\s*$", line)
+        if m:
+            cur = m.group(2)
+            funcs[cur] = []
+            starts[int(m.group(1), 16)] = cur
+            continue
+        if cur is None or ":" not in line:
+            continue
+        head, _, rest = line.partition(":")
+        fields = [f for f in rest.split("\t") if f.strip()]  # bytes, mnemonic, operands
+        if not re.match(r"^\s*[0-9a-fA-F]+$", head) or len(fields) < 2:
+            continue
+        body = " ".join(fields[1:])
+        body = re.split(r"\s[@;]", " " + body, 1)[0].strip()
+        if not body:
+            continue
+        mn, _, ops = body.partition(" ")
+        funcs[cur].append(Insn(int(head, 16), mn.lower(), ops.strip().lower(), cur, len(funcs[cur])))
+    return funcs, starts
+
+
+def reg_count(ops):
+    """Registers in a {...} list, ranges included; D registers count twice."""
+    m = re.search(r"\{([^}]*)\}", ops)
+    if not m:
+        return 1
+    n = 0
+    for part in m.group(1).split(","):
+        part = part.strip()
+        r = re.match(r"^([rsd])(\d+)-[rsd]?(\d+)$", part)
+        if r:
+            n += (int(r.group(3)) - int(r.group(2)) + 1) * (2 if r.group(1) == "d" else 1)
+        elif part:
+            n += 2 if part.startswith("d") else 1
+    return n
+
+
+def strip(mn):
+    return re.sub(r"\.(n|w)$", "", mn)
+
+
+def branch(mn):
+    """(kind, conditional) of a b / bl / bx / blx, else None."""
+    m = BRANCH.match(strip(mn))
+    if not m:
+        return None
+    return m.group(1) or "b", m.group(2) not in (None, "al")
+
+
+def is_(mn, names):
+    """`mn` is one of `names`, with or without a condition (IT block)."""
+    return re.match(r"^(%s)(%s)?$" % (names, COND), mn) is not None
+
+
+def timing(insn, ws):
+    """Cycles of one instruction, an upper bound; None = unbounded."""
+    mn, ops = strip(insn.mn), insn.ops
+    writes_pc = ops.startswith("pc") or re.search(r"\bpc\}", ops) is not None
+    refill = REFILL + ws
+    if branch(mn) or mn in ("cbz", "cbnz"):
+        return 1 + refill
+    if mn in ("tbb", "tbh"):
+        return 2 + refill
+    if is_(mn, "wfi|wfe|svc|bkpt|udf"):
+        return None
+    if is_(mn, r"push|pop|vpush|vpop|v?(ldm|stm)(ia|db|fd|ea)?"):
+        return 1 + reg_count(ops) + (refill if writes_pc else 0)
+    if is_(mn, r"(ldr|str)(ex)?d"):
+        return 3
+    if is_(mn, r"ldr(ex)?(b|h|sb|sh)?(t)?"):
+        return 2 + (ws if "[pc" in ops else 0) + (refill if writes_pc else 0)
+    if is_(mn, r"str(ex)?(b|h)?(t)?"):
+        return 2
+    if is_(mn, "sdiv|udiv"):
+        return 12
+    if is_(mn, "dsb|dmb|isb"):
+        return 4  # 1 + B, bus drain assumed short
+    if re.match(r"^v(div|sqrt)", mn):
+        return 14
+    if re.match(r"^v(ldr|str|mov)", mn):
+        return 2
+    if re.match(r"^v(n?ml[as]|f?n?m[as]\.)", mn) or re.match(r"^vfn?m[as]", mn):
+        return 3
+    return 1 + (refill if writes_pc else 0)
+
+
+def const_reg(insns, i, reg):
+    """Immediate last moved into `reg` on the straight line before insns[i], or None."""
+    for j in range(i - 1, max(-1, i - 6), -1):
+        p = insns[j]
+        if branch(p.mn) or strip(p.mn) in ("cbz", "cbnz"):
+            return None
+        dst = p.ops.split(",")[0].strip()
+        if dst != reg:
+            continue
+        m = re.match(r"^[^,]+,\s*#(-?(?:0x)?[0-9a-f]+)$", p.ops)
+        if IMM.match(p.mn) and m:
+            return int(m.group(1), 0)
+        return None
+    return None
+
+
+def mask_effect(insns, i):
+    """('open', kind), ('close', full?) or None for insns[i]."""
+    p = insns[i]
+    mn = strip(p.mn)
+    if mn == "cpsid":
+        return ("open", "FAULTMASK" if "f" in p.ops else "PRIMASK")
+    if mn == "cpsie":
+        return ("close", True)
+    if mn != "msr":
+        return None
+    sysreg, _, src = p.ops.partition(",")
+    sysreg, src = sysreg.strip(), src.strip()
+    value = const_reg(insns, i, src)
+    if sysreg == "basepri_max":
+        return ("open", "BASEPRI") if value != 0 else None
+    if sysreg in ("primask", "faultmask"):
+        if value is not None and value & 1:
+            return ("open", sysreg.upper())
+        return ("close", value == 0)
+    if sysreg == "basepri":
+        if value:
+            return ("open", "BASEPRI")
+        return ("close", value == 0)
+    return None
+
+
+class Image(object):
+    def __init__(self, funcs, starts, bounds, costs, ws):
+        self.funcs, self.starts, self.bounds, self.costs, self.ws = funcs, starts, bounds, costs, ws
+        self.at = {}
+        for insns in funcs.values():
+            for p in insns:
+                self.at[p.addr] = p
+        self.memo, self.busy = {}, set()
+        self.calls = {}  # function -> ("open", kind) / ("close", False)
+
+    def target(self, p):
+        m = TARGET.search(p.ops)
+        return int(m.group(1), 16) if m else None
+
+    def flow(self, p):
+        """(successors in the function, callee or None, returns?)."""
+        insns = self.funcs[p.func]
+        nxt = [insns[p.index + 1]] if p.index + 1 < len(insns) else []
+        mn = strip(p.mn)
+        b = branch(p.mn)
+        if b:
+            kind, cond = b
+            if kind == "l":
+                return nxt, ("call", self.target(p)), False
+            if kind == "lx":
+                return nxt, ("call", None), False
+            if kind == "x":
+                if p.ops == "lr":
+                    return (nxt if cond else []), None, True
+                raise Unbounded("indirect jump at 0x%x" % p.addr)
+            t = self.target(p)
+            succ = nxt if cond else []
+            if t in self.at and self.at[t].func == p.func:
+                return succ + [self.at[t]], None, False
+            return succ, ("tail", t), not cond
+        if mn in ("cbz", "cbnz"):
+            t = self.target(p)
+            return nxt + ([self.at[t]] if t in self.at else []), None, False
+        if mn in ("tbb", "tbh"):
+            raise Unbounded("jump table at 0x%x" % p.addr)
+        if re.match(r"^(pop|ldm)", mn) and re.search(r"\bpc\}", p.ops):
+            return [], None, True
+        if re.match(r"^ldr", mn) and p.ops.startswith("pc"):
+            if re.match(r"^pc,\s*\[sp\]", p.ops):
+                return [], None, True  # pop {pc} as a single load
+            raise Unbounded("indirect jump at 0x%x" % p.addr)
+        if mn.startswith(".") or mn == "<unknown>":
+            raise Unbounded("data or undecodable bytes at 0x%x (disassemble for Cortex-M4)" % p.addr)
+        return nxt, None, False
+
+    def call_cost(self, p, callee):
+        if p.addr in self.costs:
+            return self.costs[p.addr]
+        _, t = callee
+        if t is None or t not in self.starts:
+            raise Unbounded("call at 0x%x to %s needs --cost 0x%x=CYCLES" % (
+                p.addr, "0x%x" % t if t is not None else p.ops, p.addr))
+        return self.function(self.starts[t])
+
+    def cost(self, p):
+        c = timing(p, self.ws)
+        if c is None:
+            raise Unbounded("%s at 0x%x" % (p.mn, p.addr))
+        _, callee, _ = self.flow(p)
+        if callee:
+            c += self.call_cost(p, callee)
+        return c
+
+    def function(self, name):
+        """Worst case of a whole function, entry to return."""
+        if name in self.memo:
+            return self.memo[name]
+        if name in self.busy:
+            raise Unbounded("recursion through %s" % name)
+        insns = self.funcs[name]
+        if not insns:
+            raise Unbounded("%s has no code" % name)
+        self.busy.add(name)
+        try:
+            def succ(state):
+                s, _, _ = self.flow(self.at[state])
+                return [q.addr for q in s]
+            worst = longest(insns[0].addr, succ, lambda st: self.cost(self.at[st]), self.bound, lambda st: st)
+        finally:
+            self.busy.discard(name)
+        self.memo[name] = worst
+        return worst
+
+    def effect(self, p):
+        """Mask effect of an instruction, calls to opening / closing functions included."""
+        insns = self.funcs[p.func]
+        e = mask_effect(insns, p.index)
+        if e:
+            return e
+        b = branch(p.mn)
+        if b and b[0] == "l":
+            t = self.target(p)
+            name = self.starts.get(t)
+            if name is not None and self.calls.get(name):
+                return self.calls[name]
+        return None
+
+    def classify(self):
+        """Functions that return masked open a region; those that only unmask close one."""
+        for name, insns in self.funcs.items():
+            opens = closes = False
+            for p in insns:
+                e = mask_effect(insns, p.index)
+                if e and e[0] == "open":
+                    opens = opens or e[1]
+                elif e and e[0] == "close":
+                    closes = True
+            if opens and not closes:
+                self.calls[name] = ("open", opens)
+            elif closes and not opens:
+                self.calls[name] = ("close", False)
+
+    def bound(self, header, sources):
+        """Iterations of the loop headed at `header` with back edges from `sources`."""
+        for a in [header] + sorted(sources):
+            if a in self.bounds:
+                return self.bounds[a]
+        p = self.at[header]
+        raise Unbounded("loop at 0x%x in %s needs --bound 0x%x=N" % (header, p.func, header))
+
+    def region(self, p, kind):
+        """Worst cycles from masking instruction `p` to the matching unmask."""
+        def succ(state):
+            addr, depth = state
+            q = self.at[addr]
+            e = self.effect(q)
+            if e and e[0] == "open":
+                depth = min(depth + 1, DEPTH_MAX)
+            elif e and e[0] == "close":
+                depth = 0 if e[1] else depth - 1
+            if depth <= 0:
+                return []  # the unmasking instruction ends the region
+            s, _, ret = self.flow(q)
+            if ret and not s:
+                return []  # returns masked: the caller's code is not followed
+            return [(n.addr, depth) for n in s]
+
+        def cost(state):
+            return self.cost(self.at[state[0]])
+
+        # The masking instruction itself counts, then one level of masking
+        first = (p.addr, 0)
+
+        def succ0(state):
+            if state == first:
+                s, _, _ = self.flow(p)
+                return [(n.addr, 1) for n in s]
+            return succ(state)
+        return longest(first, succ0, cost, self.bound, lambda st: st[0])
+
+    def regions(self):
+        self.classify()
+        found = []
+        for name, insns in self.funcs.items():
+            if self.calls.get(name, (None,))[0] == "open":
+                continue  # counted at its call sites
+            for p in insns:
+                e = self.effect(p)
+                if not e or e[0] != "open":
+                    continue
+                r = {"function": name, "addr": p.addr, "kind": e[1], "insn": (p.mn + " " + p.ops).strip()}
+                try:
+                    r["cycles"] = self.region(p, e[1])
+                except Unbounded as why:
+                    r["cycles"] = None
+                    r["reason"] = str(why)
+                found.append(r)
+        return found
+
+
+def longest(entry, succ, cost, bound, addr_of):
+    """Longest path from `entry` to a state without successors; loops need bound()."""
+    nodes, edges, todo = {entry}, {}, [entry]
+    while todo:
+        n = todo.pop()
+        edges[n] = succ(n)
+        for m in edges[n]:
+            if m not in nodes:
+                nodes.add(m)
+                todo.append(m)
+    return _walk(entry, nodes, edges, cost, bound, addr_of, None)
+
+
+def _sccs(nodes, edges):
+    index, low, stack, on, out, counter = {}, {}, [], set(), [], [0]
+    for root in nodes:
+        if root in index:
+            continue
+        work = [(root, iter(edges.get(root, ())))]
+        index[root] = low[root] = counter[0]
+        counter[0] += 1
+        stack.append(root)
+        on.add(root)
+        while work:
+            v, it = work[-1]
+            advanced = False
+            for w in it:
+                if w not in nodes:
+                    continue
+                if w not in index:
+                    index[w] = low[w] = counter[0]
+                    counter[0] += 1
+                    stack.append(w)
+                    on.add(w)
+                    work.append((w, iter(edges.get(w, ()))))
+                    advanced = True
+                    break
+                if w in on:
+                    low[v] = min(low[v], index[w])
+            if advanced:
+                continue
+            work.pop()
+            if work:
+                low[work[-1][0]] = min(low[work[-1][0]], low[v])
+            if low[v] == index[v]:
+                comp = set()
+                while True:
+                    w = stack.pop()
+                    on.discard(w)
+                    comp.add(w)
+                    if w == v:
+                        break
+                out.append(comp)
+    return out
+
+
+def _walk(entry, nodes, edges, cost, bound, addr_of, targets):
+    """Longest path from `entry` within `nodes`, ending at a sink (or in `targets`)."""
+    comps = _sccs(nodes, edges)
+    where = {}
+    for c in comps:
+        for n in c:
+            where[n] = c
+    NEG = float("-inf")
+    value = {}
+
+    def comp_cost(c):
+        if len(c) == 1:
+            only = next(iter(c))
+            if only not in edges.get(only, ()):
+                return cost(only)
+        # A loop: one entry, `bound` iterations of the longest way round, then the longest way out
+        heads = [n for n in c if n == entry or any(n in edges.get(m, ()) for m in nodes if m not in c)]
+        if len(heads) != 1:
+            raise Unbounded("loop with several entries near 0x%x" % addr_of(sorted(c, key=addr_of)[0]))
+        h = heads[0]
+        sources = [m for m in c if h in edges.get(m, ())]
+        n = bound(addr_of(h), set(addr_of(m) for m in sources))
+        body = dict((m, [x for x in edges.get(m, ()) if x in c and x != h]) for m in c)
+        it = _walk(h, c, body, cost, bound, addr_of, set(sources))
+        exits = set(m for m in c if any(x not in c for x in edges.get(m, ())))
+        return n * it + (_walk(h, c, body, cost, bound, addr_of, exits) if exits else 0)
+
+    for c in comps:  # Tarjan emits sink components first
+        own = comp_cost(c)
+        best = NEG
+        ends_here = False
+        for m in c:
+            outs = [x for x in edges.get(m, ()) if x in nodes and where[x] is not c]
+            if targets is not None:
+                if m in targets:
+                    ends_here = True
+            elif not edges.get(m):
+                ends_here = True
+            for x in outs:
+                v = value.get(id(where[x]), NEG)
+                if v > best:
+                    best = v
+        tail = max(best, 0 if ends_here else NEG)
+        value[id(c)] = own + tail if tail != NEG else NEG
+    result = value[id(where[entry])]
+    if result == NEG:
+        return 0
+    return int(result)
+
+
+def parse_addr(text, funcs):
+    m = re.match(r"^([^+]+)\+(0x[0-9a-fA-F]+|\d+)$", text)
+    if m and m.group(1) in funcs and funcs[m.group(1)]:
+        return funcs[m.group(1)][0].addr + int(m.group(2), 0)
+    return int(text, 16) if not text.startswith("0x") else int(text, 0)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("input", help="objdump -d listing, or an ELF with --objdump")
+    ap.add_argument("--objdump", help="disassemble INPUT with this objdump command first")
+    ap.add_argument("--bound", action="append", default=[], metavar="ADDR=N",
+                    help="most iterations of the loop at ADDR (hex, or func+0xOFF)")
+    ap.add_argument("--bounds", help="file of 'ADDR N' lines")
+    ap.add_argument("--cost", action="append", default=[], metavar="ADDR=CYCLES",
+                    help="worst case of the call at ADDR (indirect or unknown callee)")
+    ap.add_argument("--ws", type=int, default=0, help="flash wait states per refill / literal load")
+    ap.add_argument("--hz", type=int, default=0, help="core clock: also print microseconds")
+    ap.add_argument("--limit", type=int, default=0, help="exit 1 when a region exceeds this many cycles")
+    ap.add_argument("--top", type=int, default=0, help="only the N worst regions")
+    ap.add_argument("--json", action="store_true", help="machine-readable output")
+    args = ap.parse_args()
+
+    if args.objdump:
+        text = subprocess.run(shlex.split(args.objdump) + ["-d", args.input], check=True, stdout=subprocess.PIPE,
+                              universal_newlines=True).stdout
+    else:
+        with open(args.input) as f:
+            text = f.read()
+    funcs, starts = parse(text)
+    if not funcs:
+        raise SystemExit("no functions found: expected objdump -d output")
+
+    bounds, costs = {}, {}
+    items = [("bound", b) for b in args.bound] + [("cost", c) for c in args.cost]
+    if args.bounds:
+        with open(args.bounds) as f:
+            for line in f:
+                line = line.split("#", 1)[0].split()
+                if len(line) == 2:
+                    items.append(("bound", "%s=%s" % tuple(line)))
+    for kind, item in items:
+        key, _, value = item.partition("=")
+        if not value:
+            raise SystemExit("--%s expects ADDR=N, got %r" % (kind, item))
+        (bounds if kind == "bound" else costs)[parse_addr(key.strip(), funcs)] = int(value, 0)
+
+    img = Image(funcs, starts, bounds, costs, args.ws)
+    regions = img.regions()
+    regions.sort(key=lambda r: (r["cycles"] is not None, -(r["cycles"] or 0)))
+    shown = regions[:args.top] if args.top else regions
+    unbounded = [r for r in regions if r["cycles"] is None]
+    over = [r for r in regions if args.limit and r["cycles"] is not None and r["cycles"] > args.limit]
+    status = 1 if unbounded or over else 0
+
+    if args.json:
+        json.dump({"regions": shown, "unbounded": len(unbounded), "over_limit": len(over),
+                   "ws": args.ws}, sys.stdout, indent=2)
+        sys.stdout.write("\n")
+        return status
+
+    print("%-28s %-10s %-9s %9s%s  %s" % ("function", "address", "mask", "cycles",
+                                          "  %9s" % "us" if args.hz else "", "masked by"))
+    for r in shown:
+        c = r["cycles"]
+        us = ("  %9.2f" % (c * 1e6 / args.hz) if c is not None else "  %9s" % "-") if args.hz else ""
+        print("%-28s 0x%08x %-9s %9s%s  %s" % (r["function"][:28], r["addr"], r["kind"],
+                                               "unbounded" if c is None else c, us, r["insn"]))
+        if c is None:
+            print("%-28s   %s" % ("", r["reason"]))
+    print()
+    print("%d masked region(s), %d unbounded" % (len(regions), len(unbounded)))
+    for r in over:
+        print("error: %s at 0x%x: %d cycles exceeds --limit %d" % (r["function"], r["addr"], r["cycles"],
+                                                                   args.limit))
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Decode cm4u_log.h binary records using the format strings in the ELF.
+
+The input is the raw word stream produced by cm4u_log_read() (little-endian
+uint32), captured from UART / RTT / semihosting into a file:
+
+    cm4u_log_decode.py firmware.elf capture.bin
+    cm4u_log_decode.py firmware.elf capture.bin --hz 168000000   # seconds
+
+Each record is: header (id << 8 | nargs << 1 | 1), CYCCNT timestamp, args.
+Timestamps are unwrapped (32-bit CYCCNT) relative to the first record.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SECTION = "cm4u_log_fmt"
+SHF_ALLOC = 0x2
+
+CONV_RE = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>\d+)?(?:\.(?P<prec>\d+))?"
+    r"(?P<len>hh|h|ll|l|z|t|j|L)?(?P<conv>[diouxXcpfFeEgGs%])")
+
+
+def read_format_section(path):
+    """Return (data, addr, alloc) of the format-string section."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        raise SystemExit("%s: not an ELF file" % path)
+    is64 = elf[4] == 2
+    endian = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x3A)
+        shdr = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x2E)
+        shdr = endian + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(shdr, elf, shoff + i * shentsize) for i in range(shnum)]
+    strtab = sections[shstrndx]
+    str_off = strtab[4]
+    for name_off, _type, flags, addr, offset, size, *_ in sections:
+        end = elf.index(b"\0", str_off + name_off)
+        if elf[str_off + name_off:end].decode() == SECTION:
+            return elf[offset:offset + size], addr, bool(flags & SHF_ALLOC)
+    raise SystemExit("%s: no %s section (no CM4U_LOG calls, or stripped?)" % (path, SECTION))
+
+
+def lookup(section, log_id):
+    data, addr, alloc = section
+    # Target: INFO section, ID = address. Host: allocated, ID = offset.
+    off = log_id if alloc else log_id - addr
+    if off < 0 or off >= len(data):
+        return None
+    end = data.find(b"\0", off)
+    return data[off:end if end >= 0 else len(data)].decode("utf-8", "replace")
+
+
+def s32(v):
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def render(fmt, args):
+    it = iter(args)
+
+    def conv(m):
+        c = m.group("conv")
+        if c == "%":
+            return "%"
+        spec = "%" + m.group("flags") + (m.group("width") or "")
+        if m.group("prec") is not None:
+            spec += "." + m.group("prec")
+        try:
+            v = next(it)
+        except StopIteration:
+            return "<missing>"
+        if c in "di":
+            return (spec + "d") % s32(v)
+        if c in "uxXo":
+            return (spec + c) % v
+        if c == "c":
+            return (spec + "c") % chr(v & 0xFF)
+        if c == "p":
+            return "0x%08x" % v
+        if c in "fFeEgG":
+            return (spec + c) % struct.unpack("<f", struct.pack("<I", v))[0]
+        return "<%%s 0x%08x>" % v
+
+    return CONV_RE.sub(conv, fmt)
+
+
+def decode(words, section, hz):
+    out = []
+    i = 0
+    first = None
+    prev = 0
+    total = 0
+    while i + 2 <= len(words):
+        hdr = words[i]
+        if (hdr & 1) == 0:
+            out.append("<bad header 0x%08x at word %d>" % (hdr, i))
+            i += 1
+            continue
+        nargs = (hdr >> 1) & 7
+        ts = words[i + 1]
+        args = words[i + 2:i + 2 + nargs]
+        i += 2 + nargs
+
+        if first is None:
+            first = ts
+            prev = ts
+        total += (ts - prev) & 0xFFFFFFFF
+        prev = ts
+
+        fmt = lookup(section, hdr >> 8)
+        text = render(fmt, args) if fmt is not None else \
+            "<unknown id 0x%x> %s" % (hdr >> 8, " ".join("0x%08x" % a for a in args))
+        stamp = "%12.6f" % (total / float(hz)) if hz else "%12d" % total
+        out.append("[%s] %s" % (stamp, text))
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elf")
+    ap.add_argument("capture", help="raw word stream ('-' = stdin)")
+    ap.add_argument("--hz", type=int, default=0, help="core clock: print seconds, not cycles")
+    args = ap.parse_args()
+
+    section = read_format_section(args.elf)
+    raw = sys.stdin.buffer.read() if args.capture == "-" else open(args.capture, "rb").read()
+    raw = raw[:len(raw) - len(raw) % 4]
+    words = list(struct.unpack("<%dI" % (len(raw) // 4), raw))
+    for line in decode(words, section, args.hz):
+        print(line)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Report the cm4u_preempt.h preemption matrix exported from the target.
+
+The input is the first CM4U_PREEMPT_EXPORT_BYTES of cm4u_preempt (or of a
+cm4u_preempt_snapshot() copy), little-endian uint32 words:
+
+    magic, slots, max_depth, overflow, exc[slots], cell[slots][slots]
+    cell = count, cycles, max   (row = victim, column = preemptor)
+
+(the per-handler profiles that follow are read by cm4u_rta.py)
+
+Dumped from the debugger, e.g. in gdb:
+
+    dump binary memory pm.bin &cm4u_preempt &cm4u_preempt.used
+
+then:
+
+    cm4u_preempt_report.py pm.bin
+    cm4u_preempt_report.py pm.bin --hz 168000000 --sort max --top 10
+    cm4u_preempt_report.py pm.bin --name 44=USART1 --name 15=SysTick
+    cm4u_preempt_report.py pm.bin --json > pm.json
+
+Pairs are listed worst first: the victim, the handler that preempted it,
+how often, the cycles it lost in total and the longest single preemption.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x584D5250
+OTHER = 0xFFFFFFFF
+SYSTEM = {0: "Thread", 2: "NMI", 3: "HardFault", 4: "MemManage", 5: "BusFault",
+          6: "UsageFault", 11: "SVCall", 12: "DebugMon", 14: "PendSV", 15: "SysTick"}
+
+
+def parse(data):
+    """Return dict(max_depth, overflow, exc[], cells[(victim, by, count, cycles, max)])."""
+    if len(data) < 16:
+        raise SystemExit("export too short (%d bytes)" % len(data))
+    magic, slots, max_depth, overflow = struct.unpack_from("<4I", data, 0)
+    if magic != MAGIC:
+        raise SystemExit("bad magic 0x%08X (cm4u_preempt_reset() never ran?)" % magic)
+    need = 16 + 4 * slots + 12 * slots * slots
+    if len(data) < need:
+        raise SystemExit("export is %d bytes, %d slots need %d" % (len(data), slots, need))
+    exc = list(struct.unpack_from("<%dI" % slots, data, 16))
+    cells = []
+    off = 16 + 4 * slots
+    for v in range(slots):
+        for p in range(slots):
+            count, cycles, longest = struct.unpack_from("<3I", data, off)
+            off += 12
+            if count:
+                cells.append((v, p, count, cycles, longest))
+    return {"max_depth": max_depth, "overflow": overflow, "exc": exc, "cells": cells}
+
+
+def exc_name(exc, names):
+    if exc in names:
+        return names[exc]
+    if exc == OTHER:
+        return "other"
+    if exc in SYSTEM:
+        return SYSTEM[exc]
+    if exc >= 16:
+        return "IRQ%d" % (exc - 16)
+    return "exc%d" % exc
+
+
+def parse_names(items):
+    names = {}
+    for item in items:
+        key, _, value = item.partition("=")
+        if not value:
+            raise SystemExit("--name expects EXC=NAME, got %r" % item)
+        names[int(key, 0)] = value
+    return names
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("export", help="binary export of cm4u_preempt")
+    ap.add_argument("--hz", type=int, default=0, help="core clock: also print microseconds")
+    ap.add_argument("--sort", choices=("max", "cycles", "count"), default="max")
+    ap.add_argument("--top", type=int, default=0, help="only the N worst pairs")
+    ap.add_argument("--name", action="append", default=[], metavar="EXC=NAME",
+                    help="name an exception number (IRQn + 16)")
+    ap.add_argument("--json", action="store_true", help="machine-readable output")
+    args = ap.parse_args()
+
+    with open(args.export, "rb") as f:
+        pm = parse(f.read())
+    names = parse_names(args.name)
+    key = {"max": 4, "cycles": 3, "count": 2}[args.sort]
+    cells = sorted(pm["cells"], key=lambda c: c[key], reverse=True)
+    if args.top:
+        cells = cells[:args.top]
+
+    rows = [{"victim": exc_name(pm["exc"][v], names), "victim_exc": pm["exc"][v],
+             "by": exc_name(pm["exc"][p], names), "by_exc": pm["exc"][p],
+             "count": count, "cycles": cycles, "max": longest}
+            for v, p, count, cycles, longest in cells]
+
+    if args.json:
+        json.dump({"max_depth": pm["max_depth"], "overflow": pm["overflow"], "pairs": rows},
+                  sys.stdout, indent=2)
+        sys.stdout.write("\n")
+        return 0
+
+    us = (lambda c: "  %10.2f" % (c * 1e6 / args.hz)) if args.hz else (lambda c: "")
+    print("%-12s %-12s %10s %12s %10s%s" % ("victim", "preempted by", "count", "cycles", "max",
+                                             "  max [us]" if args.hz else ""))
+    for r in rows:
+        print("%-12s %-12s %10d %12d %10d%s" % (r["victim"], r["by"], r["count"], r["cycles"],
+                                                 r["max"], us(r["max"])))
+    print("max nesting depth %d" % pm["max_depth"])
+    if pm["overflow"]:
+        print("warning: %d entries overflowed (raise CM4U_CFG_PREEMPT_SLOTS)" % pm["overflow"])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
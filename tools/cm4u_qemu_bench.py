@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Run cm4u benchmarks and compare them against a stored baseline.
+
+Each benchmark ELF prints ``CM4U_BENCH <name> cycles=<n> max=<n> iters=<n>``
+lines (see bench/cm4u_bench.h). Under QEMU the binaries run headless with
+semihosting; with ``--host`` they are plain Linux executables built against
+the host backend.
+
+Metrics collected per benchmark ELF:
+  <name>.cycles          min cycles per iteration, from the bench output
+  <elf>.insns            total guest instructions (QEMU + libinsn plugin only)
+
+With ``--host`` a measurement of 0 cycles is recorded as
+``<name>_modelled.cycles``: the host model charges only intrinsics and
+core register accesses, so 0 means "not modelled", not "free".
+
+Baseline file (JSON):
+  {
+    "tolerance": {"default_pct": 2.0, "per_metric": {"core.pendsv_roundtrip.cycles": 5.0}},
+    "results":   {"core.critical_pair.cycles": 4, ...}
+  }
+
+A metric regresses when it exceeds baseline * (1 + tol/100) (absolute slack
+of 1 count for tiny values). Missing baseline entries are reported as NEW and
+do not fail; use --update to (re)write the results section.
+
+A baseline with ``"enforce": false`` (or no results at all) only reports:
+regressions are printed but do not fail the run. --update records real
+numbers and drops the flag.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+BENCH_RE = re.compile(r"^CM4U_BENCH\s+(\S+)\s+cycles=(\d+)\s+max=(\d+)\s+iters=(\d+)")
+INSN_RE = re.compile(r"(?:total\s+)?insns:\s*(\d+)")
+
+
+def run_one(elf, args):
+    """Run one benchmark binary, return (metrics dict, exit code)."""
+    metrics = {}
+    log_path = None
+    if args.host:
+        cmd = [elf]
+    else:
+        cmd = [args.qemu, "-M", args.machine, "-cpu", "cortex-m4",
+               "-nographic", "-monitor", "none", "-serial", "none",
+               "-semihosting-config", "enable=on,target=native",
+               "-icount", "shift=%d,align=off,sleep=off" % args.icount_shift,
+               "-kernel", elf]
+        if args.plugin:
+            fd, log_path = tempfile.mkstemp(prefix="cm4u_insn_", suffix=".log")
+            os.close(fd)
+            cmd += ["-plugin", args.plugin, "-d", "plugin", "-D", log_path]
+
+    try:
+        proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              timeout=args.timeout, universal_newlines=True)
+        output, code = proc.stdout, proc.returncode
+    except subprocess.TimeoutExpired as exc:
+        output = exc.stdout or ""
+        if isinstance(output, bytes):
+            output = output.decode(errors="replace")
+        code = -1
+        print("TIMEOUT %s after %ds" % (elf, args.timeout), file=sys.stderr)
+
+    for line in output.splitlines():
+        m = BENCH_RE.match(line.strip())
+        if m:
+            name, cycles = m.group(1), int(m.group(2))
+            if args.host and cycles == 0:
+                name += "_modelled"
+            metrics[name + ".cycles"] = cycles
+        elif args.verbose:
+            print("  | " + line)
+
+    if log_path:
+        with open(log_path) as f:
+            for line in f:
+                m = INSN_RE.search(line)
+                if m:
+                    name = os.path.splitext(os.path.basename(elf))[0]
+                    metrics[name + ".insns"] = int(m.group(1))
+        os.unlink(log_path)
+
+    return metrics, code
+
+
+def tolerance_for(baseline, key, default_pct):
+    tol = baseline.get("tolerance", {})
+    return float(tol.get("per_metric", {}).get(key, tol.get("default_pct", default_pct)))
+
+
+def compare(results, baseline, default_pct):
+    """Print a comparison table, return number of regressions."""
+    base = baseline.get("results", {})
+    regressions = 0
+    width = max([len(k) for k in results] + [10])
+    print("%-*s %12s %12s %8s  %s" % (width, "metric", "baseline", "current", "delta", "status"))
+    for key in sorted(results):
+        cur = results[key]
+        if key not in base:
+            print("%-*s %12s %12d %8s  NEW" % (width, key, "-", cur, "-"))
+            continue
+        ref = base[key]
+        pct = tolerance_for(baseline, key, default_pct)
+        limit = max(ref * (1.0 + pct / 100.0), ref + 1)
+        delta = ((cur - ref) * 100.0 / ref) if ref else 0.0
+        if cur > limit:
+            status = "REGRESSION (tol %.1f%%)" % pct
+            regressions += 1
+        elif cur < ref * (1.0 - pct / 100.0) and cur < ref - 1:
+            status = "improved"
+        else:
+            status = "ok"
+        print("%-*s %12d %12d %+7.1f%%  %s" % (width, key, ref, cur, delta, status))
+    for key in sorted(set(base) - set(results)):
+        print("%-*s %12d %12s %8s  MISSING" % (width, key, base[key], "-", "-"))
+    return regressions
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elves", nargs="+", help="benchmark binaries")
+    ap.add_argument("--baseline", required=True, help="baseline JSON file")
+    ap.add_argument("--results", help="write collected metrics to this JSON file")
+    ap.add_argument("--update", action="store_true", help="store results as the new baseline")
+    ap.add_argument("--tolerance", type=float, default=2.0,
+                    help="default tolerance in percent when the baseline sets none")
+    ap.add_argument("--host", action="store_true", help="run binaries natively (host backend)")
+    ap.add_argument("--qemu", default="qemu-system-arm")
+    ap.add_argument("--machine", default="mps2-an386")
+    ap.add_argument("--plugin", help="path to QEMU libinsn.so for instruction counts")
+    ap.add_argument("--icount-shift", type=int, default=0)
+    ap.add_argument("--timeout", type=int, default=60)
+    ap.add_argument("-v", "--verbose", action="store_true")
+    args = ap.parse_args()
+
+    results = {}
+    failed = 0
+    for elf in args.elves:
+        metrics, code = run_one(elf, args)
+        if code != 0:
+            print("FAIL %s exited with %d" % (elf, code), file=sys.stderr)
+            failed += 1
+        results.update(metrics)
+
+    if args.results:
+        with open(args.results, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    if args.update:
+        baseline.setdefault("tolerance", {"default_pct": args.tolerance, "per_metric": {}})
+        baseline.pop("enforce", None)
+        baseline["results"] = results
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline updated: %s (%d metrics)" % (args.baseline, len(results)))
+        return 1 if failed else 0
+
+    regressions = compare(results, baseline, args.tolerance)
+    if not (baseline.get("enforce", True) and baseline.get("results")):
+        print("%s is not enforcing (record it with --update): %d regression(s) not counted"
+              % (args.baseline, regressions), file=sys.stderr)
+        regressions = 0
+    if regressions or failed:
+        print("%d regression(s), %d failed run(s)" % (regressions, failed), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,307 @@
+#!/usr/bin/env python3
+"""Worst-case response times of the handlers profiled by cm4u_preempt.h.
+
+The input is the first CM4U_PREEMPT_EXPORT_BYTES of a cm4u_preempt_snapshot()
+copy (the snapshot adds the NVIC priorities and PRIGROUP), little-endian
+32-bit words:
+
+    magic, slots, max_depth, overflow, exc[slots], cell[slots][slots] (3 words),
+    prigroup, prio_bits, crit_mode, crit_basepri,
+    prof[slots] = priority, runs, exec_max, gap_min, first, last,
+                  crit_max, crit_count
+
+Usage:
+
+    cm4u_rta.py pm.bin
+    cm4u_rta.py pm.bin --hz 168000000 --period 44=1ms --deadline 44=200us
+    cm4u_rta.py pm.bin --spec tasks.json --margin 30 --json
+
+Each handler is a sporadic task: C = exec_max + --overhead (exception entry
+and exit), T = gap_min (the shortest measured interval) unless --period
+gives it, D = T unless --deadline gives it. Values take a cycles, us or ms
+suffix (the last two need --hz); --wcet overrides C. A --spec JSON file holds
+the same per exception, plus a name:
+
+    {"44": {"name": "USART1", "period": "1ms", "deadline": "200us"}}
+
+Standard fixed-priority response-time analysis, iterated to a fixed point:
+
+    R = C + B + sum over higher-priority j of ceil(R / T_j) * C_j
+
+Priorities are NVIC preemption levels (PRIGROUP applied). Handlers of the
+same level do not preempt each other: the ones served first (lower
+subpriority, then lower exception number) count as higher priority, and
+one run of a later one is blocking. B is the largest of those runs and of
+the critical sections measured in lower-priority contexts, Thread mode
+included, that mask the handler (all of them with PRIMASK sections, the
+levels at or below CM4U_CFG_CRITICAL_BASEPRI with BASEPRI sections).
+
+Per handler the report gives R, the slack D - R, the utilisation C / T and
+the cycles its C could grow by before some deadline is missed; overall, the
+factor every C could grow by. A handler is at risk when R exceeds
+(100 - --margin)% of D. The exit status is 1 when a deadline is missed.
+"""
+
+import argparse
+import json
+import math
+import struct
+import sys
+
+MAGIC = 0x584D5250
+OTHER = 0xFFFFFFFF
+PROF_WORDS = 8
+CRITICAL_BASEPRI = 1
+SYSTEM = {0: "Thread", 2: "NMI", 3: "HardFault", 4: "MemManage", 5: "BusFault",
+          6: "UsageFault", 11: "SVCall", 12: "DebugMon", 14: "PendSV", 15: "SysTick"}
+
+
+def parse(data):
+    if len(data) < 16:
+        raise SystemExit("export too short (%d bytes)" % len(data))
+    magic, slots, max_depth, overflow = struct.unpack_from("<4I", data, 0)
+    if magic != MAGIC:
+        raise SystemExit("bad magic 0x%08X (cm4u_preempt_reset() never ran?)" % magic)
+    off = 16 + 4 * slots + 12 * slots * slots
+    need = off + 16 + 4 * PROF_WORDS * slots
+    if len(data) < need:
+        raise SystemExit("export is %d bytes, %d slots need %d (an export without profiles?)"
+                         % (len(data), slots, need))
+    exc = struct.unpack_from("<%dI" % slots, data, 16)
+    prigroup, prio_bits, crit_mode, crit_basepri = struct.unpack_from("<4I", data, off)
+    off += 16
+    prof = []
+    for i in range(slots):
+        f = struct.unpack_from("<i7I", data, off + 4 * PROF_WORDS * i)
+        prof.append(dict(zip(("priority", "runs", "exec_max", "gap_min", "first", "last",
+                              "crit_max", "crit_count"), f), exc=exc[i]))
+    return {"max_depth": max_depth, "overflow": overflow, "prigroup": prigroup,
+            "prio_bits": prio_bits, "crit_mode": crit_mode, "crit_basepri": crit_basepri,
+            "prof": prof}
+
+
+def split(pm, prio):
+    """(preemption level, subpriority) of an NVIC priority."""
+    if prio < 0:
+        return prio, 0
+    g = pm["prigroup"] & 7
+    bits = pm["prio_bits"]
+    sub = 0 if g + bits < 7 else g - 7 + bits
+    return prio >> sub, prio & ((1 << sub) - 1)
+
+
+def exc_name(exc, names):
+    if exc in names:
+        return names[exc]
+    if exc == OTHER:
+        return "other"
+    if exc in SYSTEM:
+        return SYSTEM[exc]
+    return "IRQ%d" % (exc - 16) if exc >= 16 else "exc%d" % exc
+
+
+def cycles(value, hz):
+    """'1200', '1200cycles', '250us' or '1.5ms' -> cycles."""
+    if isinstance(value, (int, float)):
+        return int(value)
+    text = str(value).strip()
+    for suffix, scale in (("cycles", None), ("us", 1e-6), ("ms", 1e-3)):
+        if text.endswith(suffix):
+            number = float(text[:-len(suffix)])
+            if scale is None:
+                return int(number)
+            if not hz:
+                raise SystemExit("%r needs --hz" % text)
+            return int(math.ceil(number * scale * hz))
+    return int(text, 0)
+
+
+def response(task, hp, blocking, limit):
+    """Fixed point of R = C + B + sum(ceil(R / Tj) * Cj), or None past `limit`."""
+    r = task["c"] + blocking
+    while True:
+        nxt = task["c"] + blocking + sum(-(-r // j["t"]) * j["c"] for j in hp)
+        if nxt > limit:
+            return None
+        if nxt == r:
+            return r
+        r = nxt
+
+
+def blocking_of(task, tasks, crits, pm):
+    """Longest lower-priority critical section or same-level run ahead of `task`."""
+    b = 0
+    for j in tasks:
+        if j["level"] == task["level"] and j["order"] > task["order"]:
+            b = max(b, j["c"])
+    for c in crits:
+        if c["level"] <= task["level"] or task["level"] < 0:
+            continue  # its own level or above (part of C), or NMI / HardFault
+        if pm["crit_mode"] == CRITICAL_BASEPRI:
+            mask = split(pm, pm["crit_basepri"] >> (8 - pm["prio_bits"]))[0]
+            if task["level"] < mask:
+                continue  # runs above the BASEPRI section
+        b = max(b, c["crit_max"])
+    return b
+
+
+def analyse(tasks, crits, pm, scale=1.0, extra=None):
+    """Response time per task (None = misses its deadline), C scaled and `extra` added."""
+    work = []
+    for t in tasks:
+        c = int(math.ceil(t["c"] * scale)) + (extra[1] if extra and extra[0] is t else 0)
+        work.append(dict(t, c=c))
+    scaled = [dict(c, crit_max=int(math.ceil(c["crit_max"] * scale))) for c in crits]
+    out = []
+    for t in work:
+        hp = [j for j in work if j["order"] < t["order"]]
+        b = blocking_of(t, work, scaled, pm)
+        out.append((b, response(t, hp, b, t["d"])))
+    return out
+
+
+def feasible(tasks, crits, pm, scale=1.0, extra=None):
+    return all(r is not None for _, r in analyse(tasks, crits, pm, scale, extra))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("export", help="binary export of a cm4u_preempt_snapshot() copy")
+    ap.add_argument("--hz", type=int, default=0, help="core clock: us / ms values and columns")
+    ap.add_argument("--overhead", type=int, default=22,
+                    help="cycles added to each run for exception entry and exit (default 22)")
+    ap.add_argument("--margin", type=float, default=20.0,
+                    help="flag a handler at risk when R exceeds (100 - MARGIN)%% of D")
+    ap.add_argument("--period", action="append", default=[], metavar="EXC=TIME",
+                    help="minimum inter-arrival time (default: measured gap_min)")
+    ap.add_argument("--deadline", action="append", default=[], metavar="EXC=TIME",
+                    help="relative deadline (default: the period)")
+    ap.add_argument("--wcet", action="append", default=[], metavar="EXC=TIME",
+                    help="execution time instead of the measured exec_max")
+    ap.add_argument("--name", action="append", default=[], metavar="EXC=NAME",
+                    help="name an exception number (IRQn + 16)")
+    ap.add_argument("--spec", help="JSON file: {EXC: {name, period, deadline, wcet}}")
+    ap.add_argument("--json", action="store_true", help="machine-readable output")
+    args = ap.parse_args()
+
+    with open(args.export, "rb") as f:
+        pm = parse(f.read())
+    spec = {}
+    if args.spec:
+        with open(args.spec) as f:
+            spec = {int(k, 0): v for k, v in json.load(f).items()}
+    for field in ("name", "period", "deadline", "wcet"):
+        for item in getattr(args, field):
+            key, _, value = item.partition("=")
+            if not value:
+                raise SystemExit("--%s expects EXC=VALUE, got %r" % (field, item))
+            spec.setdefault(int(key, 0), {})[field] = value
+    names = {exc: s["name"] for exc, s in spec.items() if "name" in s}
+
+    tasks, crits, notes = [], [], []
+    for f in pm["prof"]:
+        exc = f["exc"]
+        if exc == OTHER:
+            if f["runs"]:
+                notes.append("%d runs of unslotted handlers not analysed (raise CM4U_CFG_PREEMPT_SLOTS)"
+                             % f["runs"])
+            continue
+        level, sub = split(pm, f["priority"]) if exc else (1 << 30, 0)
+        if f["crit_count"]:
+            crits.append({"level": level, "crit_max": f["crit_max"]})
+        if exc == 0:
+            continue  # Thread mode: only its critical sections matter
+        s = spec.get(exc, {})
+        name = exc_name(exc, names)
+        t = cycles(s["period"], args.hz) if "period" in s else f["gap_min"]
+        if t <= 0:
+            notes.append("%s: ran %d time(s), no rate measured; give --period %d=..." % (name, f["runs"], exc))
+            continue
+        c = cycles(s["wcet"], args.hz) if "wcet" in s else f["exec_max"] + args.overhead
+        d = cycles(s["deadline"], args.hz) if "deadline" in s else t
+        tasks.append({"name": name, "exc": exc, "priority": f["priority"], "level": level,
+                      "order": (level, sub, exc), "c": c, "t": t, "d": d, "runs": f["runs"],
+                      "mean_t": (f["last"] - f["first"]) / (f["runs"] - 1) if f["runs"] > 1 else 0.0})
+        if d > t:
+            notes.append("%s: deadline beyond the period, only one pending run assumed" % name)
+    tasks.sort(key=lambda t: t["order"])
+    seen = set(f["exc"] for f in pm["prof"])
+    for exc in sorted(spec):
+        if exc not in seen:
+            notes.append("%s never ran: not analysed" % exc_name(exc, names))
+
+    results = analyse(tasks, crits, pm)
+    ok = all(r is not None for _, r in results)
+
+    # Headroom: cycles each C can grow by alone, and the factor all of them can grow by
+    for t, (b, r) in zip(tasks, results):
+        t["b"], t["r"] = b, r
+        t["slack"] = t["d"] - r if r is not None else None
+        t["util"] = t["c"] / t["t"]
+        lo, hi = 0, t["d"]
+        if not ok:
+            hi = 0
+        while lo < hi:
+            mid = (lo + hi + 1) // 2
+            if feasible(tasks, crits, pm, extra=(t, mid)):
+                lo = mid
+            else:
+                hi = mid - 1
+        t["headroom"] = lo
+        at_risk = r is not None and r > t["d"] * (100.0 - args.margin) / 100.0
+        t["status"] = "MISS" if r is None else ("at risk" if at_risk else "ok")
+    scale = 0.0
+    if ok and tasks:
+        lo, hi = 1.0, 2.0
+        while feasible(tasks, crits, pm, hi) and hi < 1e6:
+            lo, hi = hi, hi * 2
+        for _ in range(40):
+            mid = (lo + hi) / 2
+            if feasible(tasks, crits, pm, mid):
+                lo = mid
+            else:
+                hi = mid
+        scale = lo
+    util = sum(t["util"] for t in tasks)
+    mean_util = sum(t["c"] / max(t["mean_t"], t["t"]) for t in tasks)
+
+    if args.json:
+        keys = ("name", "exc", "priority", "level", "c", "t", "d", "b", "r", "slack", "util",
+                "headroom", "runs", "mean_t", "status")
+        json.dump({"schedulable": ok, "utilisation": util, "mean_utilisation": mean_util,
+                   "scale": scale, "overhead": args.overhead, "margin": args.margin,
+                   "tasks": [{k: t[k] for k in keys} for t in tasks], "notes": notes},
+                  sys.stdout, indent=2)
+        sys.stdout.write("\n")
+        return 0 if ok else 1
+
+    us = (lambda c: "  %9.2f" % (c * 1e6 / args.hz) if c is not None else "  %9s" % "-") \
+        if args.hz else (lambda c: "")
+    print("%-12s %5s %9s %9s %9s %7s %9s %9s %6s %9s%s  %s" % (
+        "handler", "level", "C", "T", "D", "B", "R", "slack", "U%", "headroom",
+        "  %9s  %9s" % ("R [us]", "D [us]") if args.hz else "", "status"))
+    for t in tasks:
+        print("%-12s %5d %9d %9d %9d %7d %9s %9s %6.2f %9d%s%s  %s" % (
+            t["name"], t["level"], t["c"], t["t"], t["d"], t["b"],
+            "-" if t["r"] is None else t["r"], "-" if t["slack"] is None else t["slack"],
+            100.0 * t["util"], t["headroom"], us(t["r"]), us(t["d"]), t["status"]))
+    print()
+    print("utilisation %.2f%% at the shortest intervals, %.2f%% at the mean rates" % (
+        100.0 * util, 100.0 * mean_util))
+    if ok:
+        print("schedulable: every C can grow by %.0f%% (x%.2f) before a deadline is missed"
+              % (100.0 * (scale - 1.0), scale))
+    else:
+        print("error: %d deadline(s) missed" % sum(t["r"] is None for t in tasks))
+    for t in tasks:
+        if t["status"] == "at risk":
+            print("warning: %s uses %.0f%% of its deadline" % (t["name"], 100.0 * t["r"] / t["d"]))
+    if pm["overflow"]:
+        print("warning: %d entries overflowed (raise CM4U_CFG_PREEMPT_SLOTS)" % pm["overflow"])
+    for n in notes:
+        print("note: " + n)
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
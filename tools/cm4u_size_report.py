@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+"""Flash / RAM cost of each cm4u configuration.
+
+Runs `size` (Berkeley format) on one binary per configuration and prints
+text/data/bss plus flash (text+data) and RAM (data+bss) deltas against the
+first configuration given, which should be the minimal one.
+
+    cm4u_size_report.py --size arm-none-eabi-size minimal=a.elf default=b.elf ...
+"""
+
+import argparse
+import subprocess
+import sys
+
+
+def measure(size_tool, path):
+    out = subprocess.check_output([size_tool, path], universal_newlines=True)
+    fields = out.splitlines()[1].split()
+    text, data, bss = int(fields[0]), int(fields[1]), int(fields[2])
+    return {"text": text, "data": data, "bss": bss, "flash": text + data, "ram": data + bss}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("configs", nargs="+", help="name=binary pairs, reference first")
+    ap.add_argument("--size", default="size", help="binutils size program")
+    args = ap.parse_args()
+
+    rows = []
+    for item in args.configs:
+        name, _, path = item.partition("=")
+        rows.append((name, measure(args.size, path)))
+
+    ref = rows[0][1]
+    print("%-12s %8s %8s %8s %8s %8s %8s %8s" %
+          ("config", "text", "data", "bss", "flash", "ram", "d.flash", "d.ram"))
+    for name, m in rows:
+        print("%-12s %8d %8d %8d %8d %8d %+8d %+8d" %
+              (name, m["text"], m["data"], m["bss"], m["flash"], m["ram"],
+               m["flash"] - ref["flash"], m["ram"] - ref["ram"]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
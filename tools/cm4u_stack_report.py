@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Worst-case MSP depth from a cm4u_stack.h export.
+
+The input is the first CM4U_STACK_EXPORT_BYTES of a cm4u_stack_snapshot()
+copy (the snapshot adds the NVIC priorities, PRIGROUP and the painted high
+water), little-endian 32-bit words:
+
+    magic, slots, prigroup, prio_bits, limit, top, used, thread_max,
+    max_depth, overflow, window, fpu,
+    isr[slots] = exc, priority, frame_max, body_clean, body_nested,
+                 runs_clean, runs_nested, saturated
+
+Usage:
+
+    cm4u_stack_report.py stack.bin
+    cm4u_stack_report.py stack.bin --fp off --name 44=USART1
+    cm4u_stack_report.py stack.bin --thread 512     # Thread's own MSP use, if known
+    cm4u_stack_report.py stack.bin --json
+
+Handlers of the same preemption priority (NVIC priority with PRIGROUP
+applied) cannot nest, so each level contributes its neediest handler:
+exception frame + body. The levels add up on top of Thread mode's share.
+With FP frames (--fp on, the default when the FPU is enabled) every frame
+counts 108 bytes, because any context that touched the FPU gets one. The
+exit status is 1 when the estimate exceeds the reserved MSP.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x4B545350
+HEADER = 12
+ISR_WORDS = 8
+FRAME_FP = 108
+SYSTEM = {2: "NMI", 3: "HardFault", 4: "MemManage", 5: "BusFault", 6: "UsageFault",
+          11: "SVCall", 12: "DebugMon", 14: "PendSV", 15: "SysTick"}
+
+
+def parse(data):
+    if len(data) < 4 * HEADER:
+        raise SystemExit("export too short (%d bytes)" % len(data))
+    hdr = struct.unpack_from("<%dI" % HEADER, data, 0)
+    (magic, slots, prigroup, prio_bits, limit, top, used, thread_max,
+     max_depth, overflow, window, fpu) = hdr
+    if magic != MAGIC:
+        raise SystemExit("bad magic 0x%08X (cm4u_stack_init() never ran?)" % magic)
+    need = 4 * (HEADER + ISR_WORDS * slots)
+    if len(data) < need:
+        raise SystemExit("export is %d bytes, %d slots need %d" % (len(data), slots, need))
+    isrs = []
+    for i in range(slots):
+        exc, prio, frame, clean, nested, rc, rn, sat = struct.unpack_from(
+            "<Ii6I", data, 4 * (HEADER + ISR_WORDS * i))
+        if exc == 0:
+            break
+        isrs.append({"exc": exc, "priority": prio, "frame_max": frame, "body_clean": clean,
+                     "body_nested": nested, "runs_clean": rc, "runs_nested": rn,
+                     "saturated": sat})
+    return {"prigroup": prigroup, "prio_bits": prio_bits, "limit": limit, "top": top,
+            "used": used, "thread_max": thread_max, "max_depth": max_depth,
+            "overflow": overflow, "window": window, "fpu": fpu, "isrs": isrs}
+
+
+def group(st, prio):
+    """Preemption priority, as cm4u_stack_group()."""
+    if prio < 0:
+        return prio
+    g = st["prigroup"] & 7
+    bits = st["prio_bits"]
+    sub = 0 if g + bits < 7 else g - 7 + bits
+    return prio >> sub
+
+
+def need(isr, fp):
+    body = isr["body_clean"] if isr["runs_clean"] else isr["body_nested"]
+    return (FRAME_FP if fp else isr["frame_max"]) + body, body
+
+
+def exc_name(exc, names):
+    if exc in names:
+        return names[exc]
+    if exc in SYSTEM:
+        return SYSTEM[exc]
+    return "IRQ%d" % (exc - 16) if exc >= 16 else "exc%d" % exc
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("export", help="binary export of a cm4u_stack_snapshot() copy")
+    ap.add_argument("--fp", choices=("auto", "on", "off"), default="auto",
+                    help="count every frame as an FP frame (auto: when the FPU is enabled)")
+    ap.add_argument("--thread", type=int, default=None,
+                    help="Thread mode's MSP use in bytes (default: sampled at preemption)")
+    ap.add_argument("--name", action="append", default=[], metavar="EXC=NAME",
+                    help="name an exception number (IRQn + 16)")
+    ap.add_argument("--json", action="store_true", help="machine-readable output")
+    args = ap.parse_args()
+
+    with open(args.export, "rb") as f:
+        st = parse(f.read())
+    names = {}
+    for item in args.name:
+        key, _, value = item.partition("=")
+        names[int(key, 0)] = value
+    fp = st["fpu"] != 0 if args.fp == "auto" else args.fp == "on"
+    thread = st["thread_max"] if args.thread is None else args.thread
+
+    # Neediest handler per preemption level, most urgent level last
+    levels = {}
+    for isr in st["isrs"]:
+        total, body = need(isr, fp)
+        g = group(st, isr["priority"])
+        if g not in levels or total > levels[g]["need"]:
+            levels[g] = {"level": g, "name": exc_name(isr["exc"], names), "exc": isr["exc"],
+                         "frame": total - body, "body": body, "need": total}
+    chain = [levels[g] for g in sorted(levels, reverse=True)]
+    estimate = thread + sum(l["need"] for l in chain)
+    reserved = st["top"] - st["limit"]
+
+    if args.json:
+        json.dump({"reserved": reserved, "used": st["used"], "estimate": estimate, "fp_frames": fp,
+                   "thread": thread, "levels": chain, "max_depth": st["max_depth"],
+                   "overflow": st["overflow"]}, sys.stdout, indent=2)
+        sys.stdout.write("\n")
+        return 0 if estimate <= reserved else 1
+
+    print("%-12s %6s %6s %6s %6s %7s %7s  %s" % ("handler", "prio", "level", "frame", "body",
+                                                 "clean", "nested", "notes"))
+    for isr in st["isrs"]:
+        total, body = need(isr, False)
+        notes = []
+        if not isr["runs_clean"]:
+            notes.append("never ran undisturbed: body includes nested frames")
+        if isr["saturated"]:
+            notes.append("window full %dx: raise CM4U_CFG_STACK_WINDOW" % isr["saturated"])
+        print("%-12s %6d %6d %6d %6d %7d %7d  %s" % (
+            exc_name(isr["exc"], names), isr["priority"], group(st, isr["priority"]),
+            isr["frame_max"], body, isr["runs_clean"], isr["runs_nested"], "; ".join(notes)))
+
+    print()
+    print("worst nesting (%s frames):" % ("FP" if fp else "observed"))
+    print("  %-22s %6d" % ("Thread", thread))
+    for l in chain:
+        print("  %-22s %6d   (frame %d + body %d)" % ("level %d: %s" % (l["level"], l["name"]),
+                                                     l["need"], l["frame"], l["body"]))
+    print("  %-22s %6d" % ("estimate", estimate))
+    print()
+    print("reserved MSP %d, painted high water %d, estimate %d, headroom %d (%.0f%%)" % (
+        reserved, st["used"], estimate, reserved - estimate,
+        100.0 * (reserved - estimate) / reserved if reserved else 0.0))
+    if st["overflow"]:
+        print("warning: %d handler entries not recorded (raise CM4U_CFG_STACK_SLOTS)" % st["overflow"])
+    if estimate > reserved:
+        print("error: worst case exceeds the reserved MSP")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
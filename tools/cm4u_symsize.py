@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+"""Compare code size of paired functions (e.g. C API vs C++ wrapper).
+
+Finds every symbol <a-prefix><name> with a matching <b-prefix><name> in the
+binary and prints both sizes. Exits non-zero if any B function is larger than
+its A twin by more than --slack bytes.
+
+    cm4u_symsize.py --nm arm-none-eabi-nm bench_cpp.elf zo_c_ zo_cpp_
+"""
+
+import argparse
+import subprocess
+import sys
+
+
+def symbol_sizes(nm, path):
+    out = subprocess.check_output([nm, "--print-size", "--size-sort", path],
+                                  universal_newlines=True)
+    sizes = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 4 and parts[2].lower() in ("t", "w"):
+            sizes[parts[3]] = int(parts[1], 16)
+    return sizes
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("binary")
+    ap.add_argument("prefix_a")
+    ap.add_argument("prefix_b")
+    ap.add_argument("--nm", default="nm")
+    ap.add_argument("--slack", type=int, default=0, help="allowed extra bytes for B")
+    args = ap.parse_args()
+
+    sizes = symbol_sizes(args.nm, args.binary)
+    names = sorted(s[len(args.prefix_a):] for s in sizes if s.startswith(args.prefix_a))
+    worse = 0
+    print("%-16s %10s %10s %8s" % ("function", args.prefix_a, args.prefix_b, "delta"))
+    for name in names:
+        b = sizes.get(args.prefix_b + name)
+        if b is None:
+            continue
+        a = sizes[args.prefix_a + name]
+        flag = ""
+        if b > a + args.slack:
+            flag = "  LARGER"
+            worse += 1
+        print("%-16s %10d %10d %+8d%s" % (name, a, b, b - a, flag))
+    return 1 if worse else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())